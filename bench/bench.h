@@ -0,0 +1,90 @@
+// File:     bench/bench.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_BENCH_H
+#define NANONET_BENCH_H
+
+// C++
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+// bench
+#include "histogram.h"
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    // how long each timed benchmark runs
+    std::chrono::milliseconds duration{2000};
+};
+
+struct Result {
+    std::string name;
+    // e.g. {"msg_per_s", 1.2e5}, printed and written in this order
+    std::vector<std::pair<std::string, double>> metrics;
+    // nanoseconds per operation, empty if not measured
+    Histogram latency;
+};
+
+// nanoseconds since start
+inline uint64_t elapsed_ns(Clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<
+        std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+// make the compiler produce value and assume memory was read, so the
+// work behind it is neither dropped nor hoisted out of a timed loop
+template <class T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// tcp.cpp
+Result tcp_echo_latency(const Options& options);
+Result tcp_echo_throughput(const Options& options);
+Result tcp_accept_rate(const Options& options);
+Result tcp_connect_rate(const Options& options);
+
+// udp.cpp
+Result udp_pps(const Options& options);
+Result udp_pps_batch(const Options& options);
+
+// parse.cpp
+Result parse_addrport_legacy(const Options& options);
+Result parse_addrport(const Options& options);
+Result parse_addrport_ipv6(const Options& options);
+Result parse_addr(const Options& options);
+Result parse_port(const Options& options);
+Result format_addr_ntos(const Options& options);
+
+} // namespace bench
+
+#endif // NANONET_BENCH_H
@@ -0,0 +1,116 @@
+// File:     bench/histogram.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_BENCH_HISTOGRAM_H
+#define NANONET_BENCH_HISTOGRAM_H
+
+// C++
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace bench {
+
+// HDR-style histogram of non-negative integers (nanoseconds), values are
+// exact below 2^SUB_BITS and kept to 2^-SUB_BITS relative precision above,
+// recording is a few shifts and an increment
+class Histogram {
+
+    static constexpr int SUB_BITS = 8;
+    static constexpr uint64_t SUB_COUNT = uint64_t(1) << SUB_BITS;
+    static constexpr size_t SIZE = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_;
+    uint64_t min_;
+    uint64_t max_;
+    double sum_;
+
+    static size_t index_(uint64_t value) noexcept {
+        if (value < SUB_COUNT) return static_cast<size_t>(value);
+        int shift = 63 - __builtin_clzll(value) - SUB_BITS;
+        return static_cast<size_t>(shift + 1) << SUB_BITS
+            | static_cast<size_t>((value >> shift) & (SUB_COUNT - 1));
+    }
+
+    // the largest value counted by index
+    static uint64_t highest_(size_t index) noexcept {
+        if (index < SUB_COUNT) return index;
+        int shift = static_cast<int>(index >> SUB_BITS) - 1;
+        uint64_t lowest = (SUB_COUNT | (index & (SUB_COUNT - 1))) << shift;
+        return lowest + ((uint64_t(1) << shift) - 1);
+    }
+
+public:
+
+    // constructor
+    Histogram() : counts_(SIZE), total_(0),
+        min_(std::numeric_limits<uint64_t>::max()), max_(0), sum_(0) {}
+
+    void record(uint64_t value) noexcept {
+        ++counts_[index_(value)];
+        ++total_;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+        sum_ += static_cast<double>(value);
+    }
+
+    // add the values of another histogram, e.g. one per thread
+    void merge(const Histogram& other) noexcept {
+        if (other.total_ == 0) return;
+        for (size_t i = 0; i < SIZE; ++i) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        sum_ += other.sum_;
+    }
+
+    // the value at or below which percent of the values lie
+    uint64_t percentile(double percent) const noexcept {
+        if (total_ == 0) return 0;
+        double rank = std::ceil(percent / 100.0 * static_cast<double>(total_));
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(rank));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < SIZE; ++i) {
+            seen += counts_[i];
+            if (seen >= target) return std::min(highest_(i), max_);
+        }
+        return max_;
+    }
+
+    uint64_t count() const noexcept { return total_; }
+    uint64_t min() const noexcept { return total_ ? min_ : 0; }
+    uint64_t max() const noexcept { return max_; }
+    double mean() const noexcept { return total_ ? sum_ / total_ : 0; }
+
+}; // class Histogram
+
+} // namespace bench
+
+#endif // NANONET_BENCH_HISTOGRAM_H
@@ -0,0 +1,186 @@
+// File:     bench/main.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nanonet.h"
+#include "bench.h"
+
+// C++
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace bench;
+
+namespace {
+
+struct Benchmark {
+    const char* name;
+    Result (*run)(const Options&);
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"tcp_echo_latency", tcp_echo_latency},
+    {"tcp_echo_throughput", tcp_echo_throughput},
+    {"tcp_accept_rate", tcp_accept_rate},
+    {"tcp_connect_rate", tcp_connect_rate},
+    {"udp_pps", udp_pps},
+    {"udp_pps_batch", udp_pps_batch},
+    {"parse_addrport_legacy", parse_addrport_legacy},
+    {"parse_addrport", parse_addrport},
+    {"parse_addrport_ipv6", parse_addrport_ipv6},
+    {"parse_addr", parse_addr},
+    {"parse_port", parse_port},
+    {"format_addr_ntos", format_addr_ntos},
+};
+
+// percentiles of every latency histogram
+const double PERCENTILES[] = {50, 90, 99, 99.9, 99.99};
+
+void usage(const char* prog) {
+    std::fprintf(stderr,
+        "usage: %s [--duration MS] [--json FILE|-] [--list] [FILTER...]\n"
+        "  runs the benchmarks whose name contains one of the filters,\n"
+        "  all of them without filters, --json - writes JSON to stdout\n",
+        prog);
+}
+
+// "99.9" -> "p99_9"
+std::string percentile_key(double percent) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "p%g", percent);
+    std::string key = buf;
+    for (char& c : key) if (c == '.') c = '_';
+    return key;
+}
+
+void print_text(FILE* out, const Result& result) {
+    std::fprintf(out, "%-26s", result.name.c_str());
+    for (const auto& metric : result.metrics)
+        std::fprintf(out, " %s=%.6g", metric.first.c_str(), metric.second);
+    std::fprintf(out, "\n");
+    const Histogram& h = result.latency;
+    if (h.count() == 0) return;
+    std::fprintf(out, "%-26s ns: n=%llu min=%llu mean=%.0f", "",
+        static_cast<unsigned long long>(h.count()),
+        static_cast<unsigned long long>(h.min()), h.mean());
+    for (double percent : PERCENTILES)
+        std::fprintf(out, " %s=%llu", percentile_key(percent).c_str(),
+            static_cast<unsigned long long>(h.percentile(percent)));
+    std::fprintf(out, " max=%llu\n", static_cast<unsigned long long>(h.max()));
+}
+
+// one object per benchmark, names and keys never need escaping
+void print_json(FILE* out, const Options& options,
+        const std::vector<Result>& results) {
+    std::fprintf(out, "{\n  \"duration_ms\": %lld,\n  \"benchmarks\": [",
+        static_cast<long long>(options.duration.count()));
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        std::fprintf(out, "%s\n    {\n      \"name\": \"%s\",\n"
+            "      \"metrics\": {", i ? "," : "", result.name.c_str());
+        for (size_t j = 0; j < result.metrics.size(); ++j)
+            std::fprintf(out, "%s\"%s\": %.17g", j ? ", " : "",
+                result.metrics[j].first.c_str(), result.metrics[j].second);
+        std::fprintf(out, "}");
+        const Histogram& h = result.latency;
+        if (h.count() > 0) {
+            std::fprintf(out, ",\n      \"latency_ns\": {\"count\": %llu, "
+                "\"min\": %llu, \"mean\": %.17g",
+                static_cast<unsigned long long>(h.count()),
+                static_cast<unsigned long long>(h.min()), h.mean());
+            for (double percent : PERCENTILES)
+                std::fprintf(out, ", \"%s\": %llu",
+                    percentile_key(percent).c_str(),
+                    static_cast<unsigned long long>(h.percentile(percent)));
+            std::fprintf(out, ", \"max\": %llu}",
+                static_cast<unsigned long long>(h.max()));
+        }
+        std::fprintf(out, "\n    }");
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+}
+
+bool selected(const char* name, const std::vector<std::string>& filters) {
+    if (filters.empty()) return true;
+    for (const std::string& filter : filters)
+        if (std::strstr(name, filter.c_str())) return true;
+    return false;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    const char* json = nullptr;
+    std::vector<std::string> filters;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--duration" && i + 1 < argc) {
+            options.duration = std::chrono::milliseconds(
+                std::strtol(argv[++i], nullptr, 10));
+        } else if (arg == "--json" && i + 1 < argc) {
+            json = argv[++i];
+        } else if (arg == "--list") {
+            for (const Benchmark& bench : BENCHMARKS)
+                std::printf("%s\n", bench.name);
+            return 0;
+        } else if (arg.empty() || arg[0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            filters.push_back(arg);
+        }
+    }
+
+    // the text report goes to stderr while stdout carries the JSON
+    bool json_stdout = json && std::strcmp(json, "-") == 0;
+    FILE* text = json_stdout ? stderr : stdout;
+    std::vector<Result> results;
+    for (const Benchmark& bench : BENCHMARKS) {
+        if (!selected(bench.name, filters)) continue;
+        try {
+            results.push_back(bench.run(options));
+        } catch (const nano::NanoExcept& e) {
+            std::fprintf(stderr, "%s: %s\n", bench.name, e.what());
+            return 1;
+        }
+        print_text(text, results.back());
+        std::fflush(text);
+    }
+
+    if (json) {
+        FILE* out = json_stdout ? stdout : std::fopen(json, "w");
+        if (!out) {
+            std::perror(json);
+            return 1;
+        }
+        print_json(out, options, results);
+        if (out != stdout) std::fclose(out);
+    }
+    return 0;
+}
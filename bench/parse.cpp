@@ -0,0 +1,222 @@
+// File:     bench/parse.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nanonet.h"
+#include "bench.h"
+
+// C++
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace nano;
+
+namespace bench {
+
+namespace {
+
+constexpr size_t COUNT = 1 << 14;
+
+// compile-time literals
+constexpr AddrPort LOOPBACK = AddrPort::parse("127.0.0.1:8080");
+static_assert(LOOPBACK.addr().get(false) == 0x7F000001);
+static_assert(LOOPBACK.port().get(false) == 8080);
+
+// the previous path: validate, re-parse with inet_addr, then a byte loop
+// for the port with exception-based range checks
+AddrPort legacy_parse(const std::string& str) {
+    size_t pos = str.find(':');
+    std::string addr = str.substr(0, pos);
+    int count = 0, value = 0;
+    char prev = '.';
+    for (char c : addr) {
+        if (c == '.') {
+            if (prev == '.' || value > 255 || count == 3)
+                throw NanoExcept("invalid");
+            value = 0;
+            ++count;
+        } else if (c >= '0' && c <= '9') {
+            value = value * 10 + (c & 0xF);
+        } else {
+            throw NanoExcept("invalid");
+        }
+        prev = c;
+    }
+    if (value > 255 || count != 3) throw NanoExcept("invalid");
+    addr_t net_addr = inet_addr(addr.c_str());
+    unsigned port = 0;
+    for (const char* p = str.c_str() + pos + 1; *p; ++p) {
+        if (*p == ' ') continue;
+        if (*p < '0' || *p > '9') throw NanoExcept("invalid");
+        port = port * 10 + (*p & 0xF);
+        if (port >= 65536) throw NanoExcept("out of range");
+    }
+    return AddrPort(Addr(addr_ntoh(net_addr)), Port(port));
+}
+
+// the same random "a.b.c.d:port" strings for every benchmark
+const std::vector<std::string>& inputs() {
+    static const std::vector<std::string> strs = [] {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> octet(0, 255), port(0, 65535);
+        std::vector<std::string> ret;
+        ret.reserve(COUNT);
+        for (size_t i = 0; i < COUNT; ++i) {
+            ret.push_back(std::to_string(octet(rng)) + '.'
+                + std::to_string(octet(rng)) + '.'
+                + std::to_string(octet(rng)) + '.'
+                + std::to_string(octet(rng)) + ':'
+                + std::to_string(port(rng)));
+        }
+        return ret;
+    }();
+    return strs;
+}
+
+// "[a:b:c:d:e:f:g:h]:port" strings with random groups, some runs of zeros
+// compressed to ::
+const std::vector<std::string>& inputs6() {
+    static const std::vector<std::string> strs = [] {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> group(0, 0xFFFF), port(0, 65535),
+            zeros(0, 7);
+        std::vector<std::string> ret;
+        ret.reserve(COUNT);
+        char hex[8];
+        for (size_t i = 0; i < COUNT; ++i) {
+            int gap = zeros(rng);
+            std::string str = "[";
+            for (int g = 0; g < 8; ++g) {
+                if (g == gap && g < 6) {
+                    str += g == 0 ? "::" : ":";
+                    g += 2;
+                    continue;
+                }
+                std::snprintf(hex, sizeof(hex), "%x", group(rng));
+                str += hex;
+                if (g < 7) str += ':';
+            }
+            ret.push_back(str + "]:" + std::to_string(port(rng)));
+        }
+        return ret;
+    }();
+    return strs;
+}
+
+// run op over every input in rounds until the duration is over, the
+// histogram holds the mean ns per op of each round, a single op is too
+// short for the clock
+template <class Op>
+Result run(const char* name, const Options& options,
+        const std::vector<std::string>& strs, Op op) {
+    Result result;
+    result.name = name;
+    uint64_t checksum = 0;
+    uint64_t rounds = 0;
+    auto begin = Clock::now(), end = begin + options.duration;
+    do {
+        auto start = Clock::now();
+        for (const std::string& str : strs) checksum += op(str);
+        do_not_optimize(checksum);
+        result.latency.record(elapsed_ns(start) / strs.size());
+        ++rounds;
+    } while (Clock::now() < end);
+    double ns = static_cast<double>(elapsed_ns(begin))
+        / (static_cast<double>(strs.size()) * static_cast<double>(rounds));
+    result.metrics = {{"ns_per_op", ns}, {"op_per_s", 1e9 / ns}};
+    return result;
+}
+
+// the address parts of the inputs
+std::vector<std::string> addrs() {
+    std::vector<std::string> ret;
+    for (const std::string& str : inputs())
+        ret.push_back(str.substr(0, str.find(':')));
+    return ret;
+}
+
+std::vector<std::string> ports() {
+    std::vector<std::string> ret;
+    for (const std::string& str : inputs())
+        ret.push_back(str.substr(str.find(':') + 1));
+    return ret;
+}
+
+} // anonymous namespace
+
+Result parse_addrport_legacy(const Options& options) {
+    return run("parse_addrport_legacy", options, inputs(),
+            [](const std::string& str) {
+        AddrPort ap = legacy_parse(str);
+        return ap.addr().get() ^ ap.port().get();
+    });
+}
+
+Result parse_addrport(const Options& options) {
+    return run("parse_addrport", options, inputs(),
+            [](const std::string& str) {
+        AddrPort ap(str);
+        return ap.addr().get() ^ ap.port().get();
+    });
+}
+
+// the bracketed IPv6 form, the IPv4 one above takes the same path through
+// AddrPort::parse() and the constructor
+Result parse_addrport_ipv6(const Options& options) {
+    return run("parse_addrport_ipv6", options, inputs6(),
+            [](const std::string& str) {
+        AddrPort ap = AddrPort::parse(str);
+        in6_addr addr = ap.addr().get6();
+        return static_cast<addr_t>(addr.s6_addr[15] ^ ap.port().get());
+    });
+}
+
+Result parse_addr(const Options& options) {
+    return run("parse_addr", options, addrs(), [](const std::string& str) {
+        return Addr(str).get();
+    });
+}
+
+Result parse_port(const Options& options) {
+    return run("parse_port", options, ports(), [](const std::string& str) {
+        return static_cast<addr_t>(Port(str).get());
+    });
+}
+
+Result format_addr_ntos(const Options& options) {
+    std::vector<std::string> strs = addrs();
+    std::vector<addr_t> values;
+    for (const std::string& str : strs) values.push_back(Addr(str).get());
+    // index the numeric addresses by the position of the string
+    const std::string* base = strs.data();
+    return run("format_addr_ntos", options, strs,
+            [&](const std::string& str) {
+        return static_cast<addr_t>(addr_ntos(values[&str - base]).size());
+    });
+}
+
+} // namespace bench
@@ -0,0 +1,244 @@
+// File:     bench/tcp.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nanonet.h"
+#include "bench.h"
+
+// C++
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef NANO_LINUX
+#include <netinet/tcp.h>
+#endif
+
+using namespace nano;
+
+namespace bench {
+
+namespace {
+
+constexpr size_t MESSAGE = 64;
+constexpr size_t CHUNK = 64 * 1024;
+constexpr int CONNECTORS = 4;
+
+ServerSocket listen_loopback() {
+    ServerSocket server(Addr("127.0.0.1"), Port(0));
+    server.listen(1024);
+    return server;
+}
+
+// close with a RST, a TIME_WAIT per connection would use up the
+// ephemeral ports within seconds
+void reset(Socket& sock) {
+    linger lg = {1, 0};
+    sock.set_option(SOL_SOCKET, SO_LINGER, lg);
+    sock.close();
+}
+
+// echo until the peer is gone
+void echo(ServerSocket& server) {
+    Socket conn = server.accept();
+    conn.set_option(IPPROTO_TCP, TCP_NODELAY, 1);
+    std::vector<char> buf(CHUNK);
+    try {
+        int n = 0;
+        while ((n = conn.receive(buf.data(), buf.size())) > 0)
+            conn.send_all(buf.data(), static_cast<size_t>(n));
+    } catch (const NanoExcept&) {}
+    conn.close();
+}
+
+// accept and close until running is cleared, the timeout lets the
+// acceptor see it
+size_t accept_until(ServerSocket& server, const std::atomic<bool>& running,
+        Histogram* latency) {
+    timeval timeout = {0, 100 * 1000};
+    server.set_option(SOL_SOCKET, SO_RCVTIMEO, timeout);
+    size_t accepted = 0;
+    while (running) {
+        auto start = Clock::now();
+        try {
+            Socket conn = server.accept();
+            if (latency) latency->record(elapsed_ns(start));
+            conn.close();
+            ++accepted;
+        } catch (const NanoExcept&) {}
+    }
+    return accepted;
+}
+
+} // anonymous namespace
+
+// ping-pong of small messages on one connection
+Result tcp_echo_latency(const Options& options) {
+    ServerSocket server = listen_loopback();
+    AddrPort local = server.local();
+    std::thread server_thread([&] { echo(server); });
+
+    Socket client;
+    client.connect(local.addr(), local.port());
+    client.set_option(IPPROTO_TCP, TCP_NODELAY, 1);
+
+    Result result;
+    result.name = "tcp_echo_latency";
+    char buf[MESSAGE] = {};
+    size_t round_trips = 0;
+    auto begin = Clock::now(), end = begin + options.duration;
+    while (Clock::now() < end) {
+        auto start = Clock::now();
+        client.send_all(buf, MESSAGE);
+        if (client.receive_exact(buf, MESSAGE) != MESSAGE) break;
+        result.latency.record(elapsed_ns(start));
+        ++round_trips;
+    }
+    double seconds = static_cast<double>(elapsed_ns(begin)) / 1e9;
+
+    client.close();
+    server_thread.join();
+    server.close();
+    result.metrics = {{"rtt_per_s", round_trips / seconds}};
+    return result;
+}
+
+// one thread writes large chunks, the main thread reads the echo
+Result tcp_echo_throughput(const Options& options) {
+    ServerSocket server = listen_loopback();
+    AddrPort local = server.local();
+    std::thread server_thread([&] { echo(server); });
+
+    Socket client;
+    client.connect(local.addr(), local.port());
+    client.recv_timeout(100);
+
+    std::atomic<bool> running(true), written(false);
+    std::thread writer([&] {
+        std::vector<char> chunk(CHUNK, 'x');
+        try {
+            while (running) client.send_all(chunk.data(), chunk.size());
+        } catch (const NanoExcept&) {}
+        written = true;
+    });
+
+    Result result;
+    result.name = "tcp_echo_throughput";
+    std::vector<char> buf(CHUNK);
+    size_t bytes = 0;
+    auto begin = Clock::now(), end = begin + options.duration;
+    auto last = begin;
+    for (;;) {
+        int n = client.receive(buf.data(), buf.size());
+        if (Clock::now() < end) {
+            if (n > 0) {
+                bytes += static_cast<size_t>(n);
+                result.latency.record(elapsed_ns(last));
+                last = Clock::now();
+            }
+            continue;
+        }
+        // keep reading until the writer is out of send_all()
+        running = false;
+        if (written && n <= 0) break;
+    }
+    double seconds = std::chrono::duration<double>(end - begin).count();
+
+    writer.join();
+    reset(client);
+    server_thread.join();
+    server.close();
+    result.metrics = {{"mbyte_per_s", bytes / seconds / 1e6},
+        {"gbit_per_s", bytes * 8 / seconds / 1e9}};
+    return result;
+}
+
+// several threads connect and reset, the histogram holds the time spent
+// in accept()
+Result tcp_accept_rate(const Options& options) {
+    ServerSocket server = listen_loopback();
+    AddrPort local = server.local();
+
+    std::atomic<bool> running(true);
+    std::vector<std::thread> connectors;
+    for (int i = 0; i < CONNECTORS; ++i) {
+        connectors.emplace_back([&] {
+            while (running) {
+                Socket sock;
+                try {
+                    sock.connect(local.addr(), local.port());
+                } catch (const NanoExcept&) {}
+                reset(sock);
+            }
+        });
+    }
+
+    Result result;
+    result.name = "tcp_accept_rate";
+    auto begin = Clock::now();
+    std::thread timer([&] {
+        std::this_thread::sleep_for(options.duration);
+        running = false;
+    });
+    size_t accepted = accept_until(server, running, &result.latency);
+    double seconds = static_cast<double>(elapsed_ns(begin)) / 1e9;
+
+    timer.join();
+    for (std::thread& thread : connectors) thread.join();
+    server.close();
+    result.metrics = {{"accept_per_s", accepted / seconds}};
+    return result;
+}
+
+// connect and reset in a row, the histogram holds the time spent in
+// connect()
+Result tcp_connect_rate(const Options& options) {
+    ServerSocket server = listen_loopback();
+    AddrPort local = server.local();
+    std::atomic<bool> running(true);
+    std::thread acceptor([&] { accept_until(server, running, nullptr); });
+
+    Result result;
+    result.name = "tcp_connect_rate";
+    size_t connected = 0;
+    auto begin = Clock::now(), end = begin + options.duration;
+    while (Clock::now() < end) {
+        Socket sock;
+        auto start = Clock::now();
+        sock.connect(local.addr(), local.port());
+        result.latency.record(elapsed_ns(start));
+        reset(sock);
+        ++connected;
+    }
+    double seconds = static_cast<double>(elapsed_ns(begin)) / 1e9;
+
+    running = false;
+    acceptor.join();
+    server.close();
+    result.metrics = {{"connect_per_s", connected / seconds}};
+    return result;
+}
+
+} // namespace bench
@@ -0,0 +1,109 @@
+// File:     bench/udp.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nanonet.h"
+#include "bench.h"
+
+// C++
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace nano;
+
+namespace bench {
+
+namespace {
+
+constexpr size_t PAYLOAD = 64;
+constexpr size_t BATCH = 64;
+
+// receive for the duration while another thread floods the socket, the
+// histogram holds the gaps between the receive calls that got packets
+Result run(const char* name, bool batch, const Options& options) {
+    UdpSocket receiver(Addr("127.0.0.1"), Port(0));
+    receiver.set_option(SOL_SOCKET, SO_RCVBUF, 4 << 20);
+    receiver.recv_timeout(100);
+    AddrPort target = receiver.local();
+
+    std::atomic<bool> running(true);
+    std::atomic<size_t> sent(0);
+    std::thread sender([&] {
+        UdpSocket sock;
+        char payload[PAYLOAD] = {};
+        std::vector<Datagram> dgrams(BATCH,
+            Datagram{payload, PAYLOAD, PAYLOAD, target});
+        size_t count = 0;
+        while (running) {
+            if (batch) count += sock.send_batch(dgrams.data(), dgrams.size());
+            else count += sock.send_to(payload, PAYLOAD, target) > 0;
+        }
+        sent = count;
+        sock.close();
+    });
+
+    std::vector<char> bufs(BATCH * PAYLOAD);
+    std::vector<Datagram> dgrams(BATCH);
+    for (size_t i = 0; i < BATCH; ++i)
+        dgrams[i] = Datagram{&bufs[i * PAYLOAD], PAYLOAD, 0, AddrPort()};
+
+    Result result;
+    result.name = name;
+    size_t packets = 0;
+    AddrPort source;
+    auto start = Clock::now(), end = start + options.duration;
+    auto last = start;
+    while (Clock::now() < end) {
+        int n = batch ? receiver.receive_batch(dgrams.data(), BATCH)
+            : (receiver.receive_from(bufs.data(), PAYLOAD, source) >= 0);
+        if (n > 0) {
+            packets += static_cast<size_t>(n);
+            result.latency.record(elapsed_ns(last));
+            last = Clock::now();
+        }
+    }
+    double seconds = static_cast<double>(elapsed_ns(start)) / 1e9;
+
+    running = false;
+    sender.join();
+    receiver.close();
+    result.metrics = {{"pkt_per_s", packets / seconds},
+        {"sent_per_s", sent / seconds},
+        {"mbit_per_s", packets * PAYLOAD * 8 / seconds / 1e6}};
+    return result;
+}
+
+} // anonymous namespace
+
+Result udp_pps(const Options& options) {
+    return run("udp_pps", false, options);
+}
+
+Result udp_pps_batch(const Options& options) {
+    return run("udp_pps_batch", true, options);
+}
+
+} // namespace bench
@@ -33,7 +33,26 @@
 #endif
 
 // C++
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 // platform
@@ -45,6 +64,10 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 
 #elif _WIN32 // Windows
 
@@ -62,6 +85,12 @@
 #error "Unsupported platform. Only Windows and Linux are supported."
 #endif
 
+#ifdef NANO_LINUX
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+#endif
+
 namespace nano {
 
 #ifdef NANO_LINUX
@@ -76,7 +105,7 @@ namespace nano {
 
 enum Domain {
     IPv4 = AF_INET,
-    // IPv6 = AF_INET6, // Not supported yet (NanoNet 2.3)
+    IPv6 = AF_INET6,
 };
 
 enum SockType {
@@ -86,20 +115,64 @@ enum SockType {
 
 class NanoExcept : public std::exception {
     std::string except_msg_;
+    int code_;
 public:
-    explicit NanoExcept(const std::string& msg) : except_msg_(msg) {}
-    explicit NanoExcept(std::string&& msg) : except_msg_(std::move(msg)) {}
+    explicit NanoExcept(const std::string& msg, int code = 0)
+        : except_msg_(msg), code_(code) {}
+    explicit NanoExcept(std::string&& msg, int code = 0)
+        : except_msg_(std::move(msg)), code_(code) {}
     virtual ~NanoExcept() override = default;
     virtual const char* what() const noexcept override {
         return except_msg_.c_str();
     }
+    // the system error code taken where the call failed, 0 if none
+    int code() const noexcept {
+        return code_;
+    }
 };
 
-// Convert network byte order and host byte order
-addr_t addr_ntoh(addr_t addr) noexcept;
-addr_t addr_hton(addr_t addr) noexcept;
-port_t port_ntoh(port_t addr) noexcept;
-port_t port_hton(port_t addr) noexcept;
+// Result of a non-throwing I/O call, error is 0 on success
+struct IoResult {
+    int bytes;
+    int error;
+
+    bool ok() const noexcept { return error == 0; }
+    explicit operator bool() const noexcept { return error == 0; }
+
+    // a non-blocking socket is not ready, try again later
+    bool would_block() const noexcept {
+#ifdef NANO_LINUX
+        return error == EAGAIN || error == EWOULDBLOCK;
+#elif NANO_WINDOWS
+        return error == WSAEWOULDBLOCK;
+#endif
+    }
+}; // struct IoResult
+
+// Convert network byte order and host byte order, constexpr so that
+// addresses and ports can be built at compile time
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+
+constexpr addr_t addr_ntoh(addr_t addr) noexcept { return addr; }
+constexpr port_t port_ntoh(port_t port) noexcept { return port; }
+
+#else
+
+constexpr addr_t addr_ntoh(addr_t addr) noexcept {
+    uint32_t val = static_cast<uint32_t>(addr);
+    return static_cast<addr_t>((val >> 24) | ((val >> 8) & 0xFF00)
+        | ((val << 8) & 0xFF0000) | (val << 24));
+}
+
+constexpr port_t port_ntoh(port_t port) noexcept {
+    uint16_t val = static_cast<uint16_t>(port);
+    return static_cast<port_t>((val >> 8) | (val << 8));
+}
+
+#endif
+
+constexpr addr_t addr_hton(addr_t addr) noexcept { return addr_ntoh(addr); }
+constexpr port_t port_hton(port_t port) noexcept { return port_ntoh(port); }
 
 // Converts an ip address to a numeric value and a dotted-decimal string
 addr_t addr_ston(std::string_view str);
@@ -107,6 +180,124 @@ std::string addr_ntos(addr_t addr);
 
 bool is_valid_ipv4(std::string_view addr) noexcept;
 
+// Parse the dotted-decimal IPv4 address at the start of str in one pass
+// without touching DNS, octets have 1-3 digits and no leading zeros, the
+// result is in network byte order, returns the characters used or 0
+constexpr size_t parse_ipv4_prefix(std::string_view str,
+        addr_t& addr) noexcept {
+    uint32_t result = 0;
+    size_t i = 0, size = str.size();
+    for (int part = 0; part < 4; ++part) {
+        if (part > 0) {
+            if (i >= size || str[i] != '.') return 0;
+            ++i;
+        }
+        size_t begin = i;
+        uint32_t value = 0;
+        for (; i < size && i - begin < 3; ++i) {
+            uint32_t digit = static_cast<unsigned char>(str[i]) - '0';
+            if (digit > 9) break;
+            value = value * 10 + digit;
+        }
+        size_t digits = i - begin;
+        if (digits == 0 || value > 255 || (digits > 1 && str[begin] == '0'))
+            return 0;
+        result = (result << 8) | value;
+    }
+    addr = addr_hton(static_cast<addr_t>(result));
+    return i;
+}
+
+// The whole string is an IPv4 address, see parse_ipv4_prefix
+constexpr bool parse_ipv4(std::string_view str, addr_t& addr) noexcept {
+    addr_t value = 0;
+    size_t used = parse_ipv4_prefix(str, value);
+    if (used == 0 || used != str.size()) return false;
+    addr = value;
+    return true;
+}
+
+// Parse a decimal port of 1-5 digits, the result is in network byte order
+constexpr bool parse_port(std::string_view str, port_t& port) noexcept {
+    uint32_t value = 0, valid = 1;
+    size_t count = 0;
+    for (size_t i = 0; i < 5; ++i) {
+        uint32_t digit = i < str.size() ? static_cast<uint32_t>(
+            static_cast<unsigned char>(str[i])) - '0' : 10;
+        valid &= digit < 10;
+        value = valid ? value * 10 + digit : value;
+        count += valid;
+    }
+    if (count == 0 || count != str.size() || value > 65535) return false;
+    port = port_hton(static_cast<port_t>(value));
+    return true;
+}
+
+// Parse an IPv6 address in the text forms of RFC 4291, with :: and a
+// dotted IPv4 tail, into 16 bytes in network byte order
+constexpr bool parse_ipv6(std::string_view str, uint8_t (&bytes)[16]) noexcept {
+    auto hex = [](char c) -> uint32_t {
+        return c >= '0' && c <= '9' ? c - '0'
+            : c >= 'a' && c <= 'f' ? c - 'a' + 10
+            : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+    };
+    uint32_t words[8] = {};
+    int count = 0, gap = -1;
+    size_t i = 0, size = str.size();
+    if (size >= 2 && str[0] == ':' && str[1] == ':') {
+        gap = 0;
+        i = 2;
+    }
+    while (i < size) {
+        if (count == 8) return false;
+        size_t end = i;
+        while (end < size && hex(str[end]) < 16) ++end;
+        if (end < size && str[end] == '.') {
+            // the last 32 bits as dotted IPv4
+            addr_t addr = 0;
+            if (count > 6 || !parse_ipv4(str.substr(i), addr)) return false;
+            uint32_t value = static_cast<uint32_t>(addr_ntoh(addr));
+            words[count++] = value >> 16;
+            words[count++] = value & 0xFFFF;
+            i = size;
+            break;
+        }
+        if (end == i || end - i > 4) return false;
+        uint32_t value = 0;
+        for (; i < end; ++i) value = (value << 4) | hex(str[i]);
+        words[count++] = value;
+        if (i == size) break;
+        if (str[i++] != ':' || i == size) return false;
+        if (str[i] == ':') {
+            if (gap >= 0) return false;
+            gap = count;
+            ++i;
+        }
+    }
+    if (gap < 0 ? count != 8 : count > 7) return false;
+    // expand ::
+    int tail = gap < 0 ? 0 : count - gap;
+    for (int k = 0; k < 8; ++k) {
+        uint32_t word = gap < 0 || k < gap ? words[k]
+            : k >= 8 - tail ? words[k - (8 - count)] : 0;
+        bytes[2 * k] = static_cast<uint8_t>(word >> 8);
+        bytes[2 * k + 1] = static_cast<uint8_t>(word & 0xFF);
+    }
+    return true;
+}
+
+// Parse "a.b.c.d<separator>port" in one pass with the parsers above
+constexpr bool parse_addrport(std::string_view str, addr_t& addr,
+        port_t& port, char separator = ':') noexcept {
+    addr_t addr_value = 0;
+    size_t pos = parse_ipv4_prefix(str, addr_value);
+    if (pos == 0 || pos >= str.size() || str[pos] != separator
+            || !parse_port(str.substr(pos + 1), port))
+        return false;
+    addr = addr_value;
+    return true;
+}
+
 // Query the ip address corresponding to the domain name
 size_t dns_query(std::string_view name, std::vector<addr_t>& results,
     int protocol = SOCK_DGRAM);
@@ -119,15 +310,34 @@ sock_t create_socket(int domain, int type, int protocol = 0) noexcept;
 
 // Bind a address to a socket
 bool bind_address(sock_t socket, addr_t addr, port_t port) noexcept;
+bool bind_address(sock_t socket, const sockaddr* addr, socklen_t len) noexcept;
 
-// Accept a connection on a socket
-sock_t accept_from(sock_t socket, addr_t* addr, port_t* port) noexcept;
+// Accept a connection on a socket, flags are passed to accept4 on Linux
+sock_t accept_from(sock_t socket, addr_t* addr, port_t* port,
+    int flags = 0) noexcept;
+sock_t accept_from(sock_t socket, sockaddr_storage* addr,
+    int flags = 0) noexcept;
 
 // Listen for connections on a socket
 bool enable_listening(sock_t socket, int backlog = 20) noexcept;
 
 // Initiate a connection on a socket
 bool connect_to(sock_t socket, addr_t addr, port_t port) noexcept;
+bool connect_to(sock_t socket, const sockaddr* addr, socklen_t len) noexcept;
+
+// Connect within timeout_ms, or as long as the kernel retries if it is
+// negative, the error is ETIMEDOUT when the deadline passes
+bool connect_to(sock_t socket, addr_t addr, port_t port,
+    int timeout_ms) noexcept;
+bool connect_to(sock_t socket, const sockaddr* addr, socklen_t len,
+    int timeout_ms) noexcept;
+
+// Race TCP connections to the addresses in order, starting the next one
+// every stagger_ms or as soon as one fails, returns the blocking socket of
+// the first to connect and closes the others, or INVALID_SOCKET with the
+// error of the last failure
+sock_t connect_race(const sockaddr_storage* addrs, size_t count,
+    int timeout_ms, int stagger_ms, size_t* index = nullptr) noexcept;
 
 // Receive a message from a socket
 int recv_msg(sock_t socket, char* buf, size_t buf_size, int flags = 0);
@@ -139,6 +349,87 @@ int send_msg(sock_t socket, const char* msg, size_t length, int flags = 0);
 int send_msg_to(sock_t socket, const char* msg, size_t length,
     addr_t addr, port_t port, int flags = 0);
 
+// Receive or send without throwing, the functions above wrap these
+IoResult try_recv_msg(sock_t socket, char* buf, size_t buf_size,
+    int flags = 0) noexcept;
+IoResult try_recv_msg_from(sock_t socket, char* buf, size_t buf_size,
+    addr_t* addr, port_t* port, int flags = 0) noexcept;
+IoResult try_send_msg(sock_t socket, const char* msg, size_t length,
+    int flags = 0) noexcept;
+IoResult try_send_msg_to(sock_t socket, const char* msg, size_t length,
+    addr_t addr, port_t port, int flags = 0) noexcept;
+
+// The same for addresses of either family
+IoResult try_recv_msg_from(sock_t socket, char* buf, size_t buf_size,
+    sockaddr_storage* addr, int flags = 0) noexcept;
+IoResult try_send_msg_to(sock_t socket, const char* msg, size_t length,
+    const sockaddr* addr, socklen_t len, int flags = 0) noexcept;
+
+// Receive without storing a '\0' after the data
+IoResult try_recv_raw(sock_t socket, char* buf, size_t buf_size,
+    int flags = 0) noexcept;
+
+// Send all length bytes, waiting whenever a non-blocking socket would
+// block, returns length
+size_t send_msg_all(sock_t socket, const char* msg, size_t length);
+
+// Receive exactly length bytes with MSG_WAITALL, returns length, fewer if
+// the peer closed or a receive timeout or non-blocking socket stopped it
+// after some bytes, or -ERR_CODE
+int recv_msg_all(sock_t socket, char* buf, size_t length);
+
+#ifdef NANO_LINUX
+
+// Send a message the kernel splits into segment_size datagrams (UDP GSO)
+int send_msg_to_gso(sock_t socket, const char* msg, size_t length,
+    const sockaddr* addr, socklen_t len, size_t segment_size, int flags = 0);
+
+// Receive datagrams the kernel may have coalesced (UDP GRO), segment_size
+// is set to the size of every datagram but the last
+int recv_msg_from_gro(sock_t socket, char* buf, size_t buf_size,
+    sockaddr_storage* addr, size_t* segment_size, int flags = 0);
+
+// Read a MSG_ZEROCOPY completion from the error queue without blocking,
+// sends first..last are done, copied is set if the kernel fell back to
+// copying, returns 0 on success, or -EAGAIN when the queue is empty
+int recv_zerocopy_notice(sock_t socket, uint32_t* first, uint32_t* last,
+    bool* copied);
+
+// Send the buffers in order with sendmsg, partial writes are resumed,
+// returns the bytes sent before the socket would block
+size_t send_msg_iov(sock_t socket, const iovec* iov, size_t count,
+    int flags = 0);
+
+// Receive into the buffers in order with recvmsg
+ssize_t recv_msg_iov(sock_t socket, iovec* iov, size_t count, int flags = 0);
+
+// Create a connected pair of AF_UNIX sockets
+bool create_socket_pair(int type, sock_t (&socks)[2]) noexcept;
+
+// Descriptors passed in one message at most
+constexpr size_t FDS_PER_MSG = 16;
+
+// Pass descriptors over an AF_UNIX socket (SCM_RIGHTS) with one byte of
+// data, the receiver sets count from the capacity to the number received,
+// received descriptors are close-on-exec
+IoResult try_send_fds(sock_t socket, const int* fds, size_t count) noexcept;
+IoResult try_recv_fds(sock_t socket, int* fds, size_t* count) noexcept;
+
+#endif
+
+// Send count bytes of a file from offset without copying them to user
+// space, returns the bytes sent before the socket would block
+size_t send_file(sock_t socket, int fd, off_t offset, size_t count);
+
+#ifdef NANO_LINUX
+
+// The fallback of send_file for files sendfile cannot map, moves the
+// bytes through a pipe of the calling thread, whatever is left in it when
+// the socket would block or fails is dropped
+size_t splice_file(sock_t socket, int fd, off_t offset, size_t count);
+
+#endif
+
 // Close the socket
 bool close_socket(sock_t socket) noexcept;
 
@@ -149,6 +440,16 @@ void make_sockaddr4(sockaddr_in* sockaddr,
 // Gets the address and port bound on the file descriptor
 void get_local_address(sock_t socket, addr_t* addr, port_t* port) noexcept;
 
+// Gets the address and port of the connected peer
+void get_remote_address(sock_t socket, addr_t* addr, port_t* port) noexcept;
+
+// The same for sockets of either family, ss_family is AF_UNSPEC on failure
+void get_local_address(sock_t socket, sockaddr_storage* addr) noexcept;
+void get_remote_address(sock_t socket, sockaddr_storage* addr) noexcept;
+
+// Size of an AF_INET or AF_INET6 address, 0 for other families
+socklen_t sockaddr_length(const sockaddr* addr) noexcept;
+
 // Set non-blocking
 bool set_blocking(sock_t socket, bool blocking) noexcept;
 
@@ -156,39 +457,128 @@ bool set_blocking(sock_t socket, bool blocking) noexcept;
 
 class Addr {
 
-    // net byte order addr (ipv4)
-    addr_t val_;
+    friend struct std::hash<Addr>;
+
+    // the mapped prefix of IPv4 addresses, ::ffff:0:0/96
+    static constexpr uint32_t MAPPED = static_cast<uint32_t>(addr_hton(0xFFFF));
+
+    // net byte order, IPv4 is kept as an IPv4-mapped IPv6 address so
+    // that both families fit 16 bytes
+    uint32_t val_[4];
 
 public:
 
-    // ctor & dtor
-    Addr(addr_t val = 0) noexcept;
+    // ctor & dtor, trivially copyable so it packs into flat tables
+    constexpr Addr(addr_t val = 0) noexcept
+        : val_{0, 0, MAPPED, static_cast<uint32_t>(addr_hton(val))} {}
+    explicit constexpr Addr(const uint8_t (&bytes)[16]) noexcept
+        : val_{word_(bytes, 0), word_(bytes, 4), word_(bytes, 8),
+        word_(bytes, 12)} {}
+    explicit Addr(const in6_addr& addr) noexcept;
     Addr(std::string_view addr);
 
     Addr(const Addr&) = default;
     Addr(Addr&&) = default;
-    virtual ~Addr() = default;
+    ~Addr() = default;
 
     // assignment
     Addr& operator=(const Addr&) = default;
     Addr& operator=(Addr&&) = default;
 
-    Addr& operator=(addr_t other) noexcept;
+    constexpr Addr& operator=(addr_t other) noexcept {
+        return *this = Addr(other);
+    }
     Addr& operator=(std::string_view addr);
 
-    bool operator==(addr_t other) const noexcept;
+    constexpr bool operator==(addr_t other) const noexcept {
+        return *this == Addr(other);
+    }
     bool operator==(std::string_view other) const;
 
-    bool operator!=(addr_t other) const noexcept;
+    constexpr bool operator!=(addr_t other) const noexcept {
+        return !(*this == Addr(other));
+    }
     bool operator!=(std::string_view other) const;
 
-    // setter & getter
-    addr_t get(bool net_order = true) const noexcept;
-    void set(addr_t val) noexcept;
+    // compare & order by the numeric value of the 128-bit address, IPv4
+    // counts as ::ffff:a.b.c.d, after ::1 and before 2000::
+    friend constexpr bool operator==(const Addr& a, const Addr& b) noexcept {
+        return a.val_[0] == b.val_[0] && a.val_[1] == b.val_[1]
+            && a.val_[2] == b.val_[2] && a.val_[3] == b.val_[3];
+    }
+    friend constexpr bool operator!=(const Addr& a, const Addr& b) noexcept {
+        return !(a == b);
+    }
+    friend constexpr bool operator<(const Addr& a, const Addr& b) noexcept {
+        for (int i = 0; i < 4; ++i) {
+            if (a.val_[i] != b.val_[i])
+                return addr_ntoh(a.val_[i]) < addr_ntoh(b.val_[i]);
+        }
+        return false;
+    }
+    friend constexpr bool operator>(const Addr& a, const Addr& b) noexcept {
+        return b < a;
+    }
+    friend constexpr bool operator<=(const Addr& a, const Addr& b) noexcept {
+        return !(b < a);
+    }
+    friend constexpr bool operator>=(const Addr& a, const Addr& b) noexcept {
+        return !(a < b);
+    }
+
+    // dotted-decimal or IPv6, never resolves a host name, usable at compile
+    // time for literals
+    static constexpr Addr parse(std::string_view addr) {
+        addr_t ipv4 = 0;
+        if (parse_ipv4(addr, ipv4)) return Addr(addr_ntoh(ipv4));
+        uint8_t bytes[16] = {};
+        if (!parse_ipv6(addr, bytes))
+            throw NanoExcept("[Addr] parse(): \'" + std::string(addr)
+                + "\' is not an IPv4 or IPv6 address");
+        return Addr(bytes);
+    }
+
+    // family
+    constexpr bool is_ipv4() const noexcept {
+        return val_[0] == 0 && val_[1] == 0 && val_[2] == MAPPED;
+    }
+    constexpr bool is_ipv6() const noexcept {
+        return !this->is_ipv4();
+    }
+    constexpr int family() const noexcept {
+        return this->is_ipv4() ? AF_INET : AF_INET6;
+    }
+
+    // 0.0.0.0 or ::
+    constexpr bool is_unspecified() const noexcept {
+        return val_[0] == 0 && val_[1] == 0
+            && (val_[2] == 0 || val_[2] == MAPPED) && val_[3] == 0;
+    }
+
+    // setter & getter of the IPv4 address, get() is only meaningful if
+    // is_ipv4(), for IPv6 it returns the low 32 bits
+    constexpr addr_t get(bool net_order = true) const noexcept {
+        return net_order ? val_[3] : addr_ntoh(val_[3]);
+    }
+    constexpr void set(addr_t val) noexcept {
+        *this = Addr(val);
+    }
+
+    // the IPv6 address, IPv4 is mapped
+    in6_addr get6() const noexcept;
+    void set6(const in6_addr& addr) noexcept;
 
     // to string
     std::string to_string() const noexcept;
 
+private:
+    static constexpr uint32_t word_(const uint8_t (&bytes)[16], int i) {
+        return static_cast<uint32_t>(addr_hton(static_cast<addr_t>(
+            (static_cast<uint32_t>(bytes[i]) << 24)
+            | (static_cast<uint32_t>(bytes[i + 1]) << 16)
+            | (static_cast<uint32_t>(bytes[i + 2]) << 8) | bytes[i + 3])));
+    }
+
 };  // class Addr
 
 class Port {
@@ -198,30 +588,70 @@ class Port {
 
 public:
 
-    // ctor & dtor
-    Port(port_t val = 0) noexcept;
+    // ctor & dtor, trivially copyable so it packs into flat tables
+    constexpr Port(port_t val = 0) noexcept : val_(port_hton(val)) {}
     Port(std::string_view port);
 
     Port(const Port&) = default;
     Port(Port&&) = default;
-    virtual ~Port() = default;
+    ~Port() = default;
 
     // assignment
     Port& operator=(const Port&) = default;
     Port& operator=(Port&&) = default;
 
-    Port& operator=(port_t other) noexcept;
+    constexpr Port& operator=(port_t other) noexcept {
+        val_ = port_hton(other);
+        return *this;
+    }
     Port& operator=(std::string_view other);
 
-    bool operator==(port_t other) const noexcept;
+    constexpr bool operator==(port_t other) const noexcept {
+        return val_ == port_hton(other);
+    }
     bool operator==(std::string_view other) const;
 
-    bool operator!=(port_t other) const noexcept;
+    constexpr bool operator!=(port_t other) const noexcept {
+        return val_ != port_hton(other);
+    }
     bool operator!=(std::string_view other) const;
 
+    // compare & order by numeric value
+    friend constexpr bool operator==(const Port& a, const Port& b) noexcept {
+        return a.val_ == b.val_;
+    }
+    friend constexpr bool operator!=(const Port& a, const Port& b) noexcept {
+        return a.val_ != b.val_;
+    }
+    friend constexpr bool operator<(const Port& a, const Port& b) noexcept {
+        return port_ntoh(a.val_) < port_ntoh(b.val_);
+    }
+    friend constexpr bool operator>(const Port& a, const Port& b) noexcept {
+        return b < a;
+    }
+    friend constexpr bool operator<=(const Port& a, const Port& b) noexcept {
+        return !(b < a);
+    }
+    friend constexpr bool operator>=(const Port& a, const Port& b) noexcept {
+        return !(a < b);
+    }
+
+    // digits only, usable at compile time for literals
+    static constexpr Port parse(std::string_view port) {
+        Port ret;
+        if (!parse_port(port, ret.val_))
+            throw NanoExcept("[Port] parse(): \'" + std::string(port)
+                + "\' is not a port");
+        return ret;
+    }
+
     // getter & setter
-    port_t get(bool net_order = true) const noexcept;
-    void set(port_t val) noexcept;
+    constexpr port_t get(bool net_order = true) const noexcept {
+        return net_order ? val_ : port_ntoh(val_);
+    }
+    constexpr void set(port_t val) noexcept {
+        val_ = port_hton(val);
+    }
 
     // to string
     std::string to_string() const noexcept;
@@ -235,44 +665,227 @@ class AddrPort {
 
 public:
 
-    // ctor & dtor
-    AddrPort() = default;
-    AddrPort(const Addr& addr, const Port& port) noexcept;
+    // ctor & dtor, trivially copyable so it packs into flat tables
+    constexpr AddrPort() noexcept = default;
+    constexpr AddrPort(const Addr& addr, const Port& port) noexcept
+        : addr_(addr), port_(port) {}
     AddrPort(std::string_view addrport, char separator = ':');
 
     AddrPort(const AddrPort&) = default;
     AddrPort(AddrPort&&) = default;
-    virtual ~AddrPort() = default;
+    ~AddrPort() = default;
 
     // assignment
     AddrPort& operator=(const AddrPort&) = default;
     AddrPort& operator=(AddrPort&&) = default;
 
+    // "a.b.c.d:port" or "[ipv6]:port", never resolves a host name, usable
+    // at compile time for literals
+    static constexpr AddrPort parse(std::string_view addrport,
+            char separator = ':') {
+        addr_t addr = 0;
+        port_t port = 0;
+        if (parse_addrport(addrport, addr, port, separator))
+            return AddrPort(Addr(addr_ntoh(addr)), Port(port_ntoh(port)));
+        size_t close = addrport.find(']');
+        uint8_t bytes[16] = {};
+        if (addrport.size() > 0 && addrport[0] == '['
+                && close != std::string_view::npos
+                && close + 1 < addrport.size()
+                && addrport[close + 1] == separator
+                && parse_ipv6(addrport.substr(1, close - 1), bytes)
+                && parse_port(addrport.substr(close + 2), port))
+            return AddrPort(Addr(bytes), Port(port_ntoh(port)));
+        throw NanoExcept("[AddrPort] parse(): \'" + std::string(addrport)
+            + "\' is not an address and port");
+    }
+
+    // compare & order by address, then port
+    friend constexpr bool operator==(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return a.addr_ == b.addr_ && a.port_ == b.port_;
+    }
+    friend constexpr bool operator!=(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return !(a == b);
+    }
+    friend constexpr bool operator<(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return a.addr_ < b.addr_ || (a.addr_ == b.addr_ && a.port_ < b.port_);
+    }
+    friend constexpr bool operator>(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return b < a;
+    }
+    friend constexpr bool operator<=(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return !(b < a);
+    }
+    friend constexpr bool operator>=(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return !(a < b);
+    }
+
     // getter & setter
-    Addr addr() const noexcept;
-    void addr(const Addr& addr) noexcept;
+    constexpr Addr addr() const noexcept { return addr_; }
+    constexpr void addr(const Addr& addr) noexcept { addr_ = addr; }
 
-    Port port() const noexcept;
-    void port(const Port& port) noexcept;
+    constexpr Port port() const noexcept { return port_; }
+    constexpr void port(const Port& port) noexcept { port_ = port; }
 
-    // to string
+    // socket address for a socket of the family, IPv4 is mapped on IPv6
+    // sockets, returns the length, or 0 if an IPv6 address does not fit
+    socklen_t to_sockaddr(sockaddr_storage& addr,
+        int family = AF_UNSPEC) const noexcept;
+    static AddrPort from_sockaddr(const sockaddr_storage& addr) noexcept;
+
+    // to string, IPv6 addresses are enclosed in brackets
     std::string to_string(char separator = ':') const noexcept;
 
 }; // class AddrPort
 
+} // namespace nano
+
+namespace std {
+
+template <>
+struct hash<::nano::Addr> {
+    size_t operator()(const ::nano::Addr& addr) const noexcept {
+        uint64_t high = (static_cast<uint64_t>(addr.val_[0]) << 32)
+            | addr.val_[1];
+        uint64_t low = (static_cast<uint64_t>(addr.val_[2]) << 32)
+            | addr.val_[3];
+        return hash<uint64_t>()((high * 0x9E3779B97F4A7C15ULL) ^ low);
+    }
+};
+
+template <>
+struct hash<::nano::Port> {
+    size_t operator()(const ::nano::Port& port) const noexcept {
+        return hash<::nano::port_t>()(port.get());
+    }
+};
+
+template <>
+struct hash<::nano::AddrPort> {
+    // mixed so that neighbouring hosts and ports spread over the buckets
+    // of power-of-two tables
+    size_t operator()(const ::nano::AddrPort& addrport) const noexcept {
+        uint64_t key = (static_cast<uint64_t>(
+            hash<::nano::Addr>()(addrport.addr())) << 16)
+            ^ addrport.port().get();
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+};
+
+} // namespace std
+
+namespace nano {
+
+// Plain copy of the counters of a SocketStats
+struct IoStats {
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+
+    // send & receive calls that reached the kernel
+    uint64_t recv_calls = 0;
+    uint64_t send_calls = 0;
+
+    // calls a non-blocking socket turned down
+    uint64_t would_block = 0;
+
+    // sends that took only a part of the bytes
+    uint64_t short_writes = 0;
+
+    // failed calls other than would_block
+    uint64_t errors = 0;
+
+    IoStats& operator+=(const IoStats& other) noexcept;
+    IoStats operator-(const IoStats& other) const noexcept;
+
+}; // struct IoStats
+
+// I/O counters attached to sockets with SocketBase::stats(), a socket
+// without counters pays a null check per call, every SocketStats is
+// listed process-wide for a periodic dump
+class SocketStats {
+
+    // a single thread writes, any thread reads, no atomic add needed
+    using counter_t = std::atomic<uint64_t>;
+
+    counter_t bytes_in_;
+    counter_t bytes_out_;
+    counter_t recv_calls_;
+    counter_t send_calls_;
+    counter_t would_block_;
+    counter_t short_writes_;
+    counter_t errors_;
+
+    std::string name_;
+
+    // process-wide list
+    SocketStats* prev_;
+    SocketStats* next_;
+
+    static void add_(counter_t& counter, uint64_t value) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+            std::memory_order_relaxed);
+    }
+
+    void count_error_(int error) noexcept;
+
+public:
+
+    // ctor & dtor, the counts of a destroyed SocketStats stay in total()
+    explicit SocketStats(std::string name = "");
+    ~SocketStats();
+
+    // uncopyable & unmovable
+    SocketStats(const SocketStats&) = delete;
+    SocketStats& operator=(const SocketStats&) = delete;
+
+    const std::string& name() const noexcept;
+
+    // called by the sockets, share one SocketStats only between sockets
+    // used by the same thread, e.g. all of one EventLoop
+    void on_send(const IoResult& ret, size_t length) noexcept;
+    void on_receive(const IoResult& ret) noexcept;
+
+    // for sends returning the bytes sent before the socket would block
+    void on_send(size_t sent, size_t length) noexcept;
+
+    // the counts so far, safe from any thread
+    IoStats snapshot() const noexcept;
+
+    // the sum of every SocketStats of the process, alive or not
+    static IoStats total();
+
+    // visit the live SocketStats, e.g. to find slow peers, callback must
+    // not create or destroy a SocketStats
+    static void for_each(
+        const std::function<void(const SocketStats&)>& callback);
+
+}; // class SocketStats
+
 class SocketBase {
 protected:
 
     sock_t socket_;
+    int domain_;
 
-    // local address
-    addr_t local_addr_;
-    port_t local_port_;
+    // local address, queried on first use when unknown
+    mutable AddrPort local_;
+
+    // I/O counters, none by default
+    SocketStats* stats_;
 
 protected:
 
     // ctor & dtor
-    SocketBase(int type);
+    SocketBase(int type, int domain = AF_INET);
     virtual ~SocketBase() = default;
 
     // move
@@ -290,16 +903,31 @@ public:
     bool is_open() const noexcept;
     sock_t get() const noexcept;
 
-    // bind local
+    // detach the socket without closing it
+    sock_t release() noexcept;
+
+    // AF_INET, AF_INET6 or AF_UNIX
+    int domain() const noexcept;
+
+    // bind local, an IPv4 socket cannot bind an IPv6 address, create it
+    // with Domain::IPv6 instead
     void bind(const Addr& addr, const Port& port);
     void bind(const AddrPort& addrport);
 
+    // accept IPv4 on an IPv6 socket as mapped addresses, call before bind()
+    bool dual_stack(bool enable) noexcept;
+
     // get local
     AddrPort local() const noexcept;
 
     // blocking
     bool set_blocking(bool blocking);
 
+    // count the I/O of this socket into stats, which must outlive it or
+    // be detached with nullptr first, follows the socket when moved
+    void stats(SocketStats* stats) noexcept;
+    SocketStats* stats() const noexcept;
+
     // socket option
     template <class Ty>
     inline bool set_option(int level, int optname, const Ty& optval) const {
@@ -327,16 +955,38 @@ public:
 protected:
     virtual const char* except_name() const noexcept;
 
+    // throw if the socket cannot reach addr
+    void match_domain_(const Addr& addr) const;
+
+    // I/O accounting, a null check without stats
+    void count_send_(const IoResult& ret, size_t length) const noexcept {
+        if (stats_) stats_->on_send(ret, length);
+    }
+
+    void count_send_(size_t sent, size_t length) const noexcept {
+        if (stats_) stats_->on_send(sent, length);
+    }
+
+    void count_receive_(const IoResult& ret) const noexcept {
+        if (stats_) stats_->on_receive(ret);
+    }
+
+    // for calls returning the bytes or -ERR_CODE
+    int count_receive_(int ret) const noexcept {
+        if (stats_) stats_->on_receive(ret < 0
+            ? IoResult{0, -ret} : IoResult{ret, 0});
+        return ret;
+    }
+
 }; // class SocketBase
 
 class TransSocket : public SocketBase {
 protected:
-    // remote address
-    addr_t remote_addr_;
-    port_t remote_port_;
+    // remote address, queried on first use when unknown
+    mutable AddrPort remote_;
 
     // ctor & dtor
-    TransSocket(int type);
+    TransSocket(int type, int domain = AF_INET);
     virtual ~TransSocket() = default;
 
     // move
@@ -351,44 +1001,210 @@ public:
 
     AddrPort remote() const noexcept;
 
-    // connect to remote
+    // connect to remote, an IPv6 remote needs a socket created with
+    // Domain::IPv6, which reaches IPv4 remotes too
     void connect(const Addr& addr, const Port& port);
-    int send(const char* msg, size_t length);
+
+    // fail with ETIMEDOUT if not connected within timeout_ms
+    void connect(const Addr& addr, const Port& port, int timeout_ms);
+
+    // the sends are virtual so a Socket reached through TransSocket& still
+    // queues behind its corked bytes
+    virtual int send(const char* msg, size_t length);
     int receive(char* buf, size_t buf_size);
 
+    // send everything, waiting while a non-blocking socket would block
+    virtual void send_all(const char* msg, size_t length);
+
+    // receive exactly length bytes (MSG_WAITALL), returns length, fewer
+    // if the peer closed first, or -ERR_CODE, never stores a '\0', a
+    // non-blocking socket or a receive timeout also returns fewer after
+    // some bytes, so a short count alone does not mean end of stream,
+    // receive() again tells 0 for closed from -EAGAIN
+    int receive_exact(char* buf, size_t length);
+
+    // never throw, for non-blocking sockets where would_block() is routine
+    virtual IoResult try_send(const char* msg, size_t length) noexcept;
+    IoResult try_receive(char* buf, size_t buf_size) noexcept;
+
+#ifdef NANO_LINUX
+    // gather and scatter with sendmsg & recvmsg, send() returns the bytes
+    // sent, fewer than requested only if a non-blocking socket would block
+    virtual size_t send(const iovec* iov, size_t count);
+    int receive(iovec* iov, size_t count);
+#endif
+
+    // send several buffers as if they were one
+    size_t send(std::initializer_list<std::string_view> bufs);
+
     bool recv_timeout(long ms) const noexcept;
 
 }; // class TransSocket
 
+class EventLoop;
+
+#ifdef NANO_LINUX
+
+// Snapshot of TCP_INFO
+struct TcpInfo {
+    uint8_t state;          // TCP_ESTABLISHED, ...
+    uint32_t rtt_us;        // smoothed round-trip time
+    uint32_t rtt_var_us;
+    uint32_t snd_cwnd;      // congestion window in segments
+    uint32_t snd_ssthresh;
+    uint32_t snd_mss;
+    uint32_t rcv_space;     // receive window being advertised
+    uint32_t unacked;       // segments in flight
+    uint32_t lost;
+    uint32_t retransmits;   // retries of the oldest unacked segment
+    uint32_t total_retrans;
+}; // struct TcpInfo
+
+#endif
+
 class Socket : public TransSocket {
 
     // server socket
     friend class ServerSocket;
+    friend class IoUring;
+    friend class UnixSocket;
+
+public:
+
+    // id of a send that was copied and whose buffer is free at once
+    static constexpr uint32_t ZEROCOPY_NONE = UINT32_MAX;
+
+    // smaller payloads are cheaper to copy than to pin
+    static constexpr size_t ZEROCOPY_MIN = 16 * 1024;
+
+    // sends first..last are complete, copied is set if the kernel fell back
+    // to copying and zero-copy is not worth it on this route
+    using ZerocopyCallback = std::function<void(uint32_t first,
+        uint32_t last, bool copied)>;
+
+#ifdef NANO_LINUX
+    // sends are coalesced while corked until this many bytes are queued
+    static constexpr size_t CORK_THRESHOLD = 16 * 1024;
+#endif
+
+private:
+
+    // MSG_ZEROCOPY sends, ids are assigned in order from 0
+    bool zerocopy_;
+    uint32_t zerocopy_next_;
+    uint32_t zerocopy_done_;
+
+#ifdef NANO_LINUX
+    // coalesced sends, shared with the flush deferred on a loop
+    struct Cork;
+    std::shared_ptr<Cork> cork_;
+#endif
 
 public:
 
     // ctor & dtor
     Socket(bool create = true);
-    virtual ~Socket() = default;
+    explicit Socket(Domain domain);
+    virtual ~Socket();
 
     // move
-    Socket(Socket&&) = default;
-    Socket& operator=(Socket&&) = default;
+    Socket(Socket&& other) noexcept;
+    Socket& operator=(Socket&& other) noexcept;
 
     // uncopyable
     Socket(const Socket&) = delete;
     Socket& operator=(const Socket&) = delete;
 
+    // connect to the first address that answers, attempts are started in
+    // order every stagger_ms, or at once when the previous one fails, and
+    // timeout_ms bounds the whole race
+    static Socket connect_any(const std::vector<Addr>& addrs,
+        const Port& port, int timeout_ms = -1, int stagger_ms = 250);
+
+    // race every address the host resolves to
+    static Socket connect_any(std::string_view host, const Port& port,
+        int timeout_ms = -1, int stagger_ms = 250);
+
+    // send count bytes of a file from offset with sendfile, returns the
+    // bytes sent before a non-blocking socket would block
+    size_t send_file(int fd, off_t offset, size_t count);
+
+    // opt in to MSG_ZEROCOPY, returns false if the kernel does not support it
+    bool zerocopy(bool enable) noexcept;
+
+    // send from the pages of msg without copying them, msg must not be
+    // modified until id is reported by reap_zerocopy(), id is ZEROCOPY_NONE
+    // if the payload was copied as usual
+    int send_zerocopy(const char* msg, size_t length, uint32_t& id);
+
+    // reap completions from the error queue without blocking, call it when
+    // the socket reports an error event, returns the number of sends done
+    size_t reap_zerocopy(const ZerocopyCallback& callback);
+    size_t reap_zerocopy(std::vector<uint32_t>& ids);
+
+    // zero-copy sends whose buffers are still in use
+    uint32_t zerocopy_pending() const noexcept;
+
+#ifdef NANO_LINUX
+    // RTT, congestion window, retransmits and more of the connection
+    TcpInfo tcp_info() const;
+
+    // queue small sends until uncork(), then write them with one sendmsg,
+    // scopes nest, a send that fills the queue up to threshold goes out
+    // at once with the queue and MSG_MORE, queued bytes are dropped if
+    // the socket is closed first
+    void cork(size_t threshold = CORK_THRESHOLD);
+    void uncork();
+
+    // cork during every iteration of loop, the queue is flushed once the
+    // callbacks of the iteration ran, nullptr turns it off
+    void auto_cork(EventLoop* loop, size_t threshold = CORK_THRESHOLD);
+
+    // write the queue now, returns the bytes sent, fewer than corked()
+    // only if a non-blocking socket would block, flush again when writable,
+    // with auto_cork() the loop does so on its own
+    size_t flush();
+    size_t corked() const noexcept;
+
+    // the same as in TransSocket, but queued behind or with the corked bytes,
+    // an error of a flush deferred on the loop is thrown by the next of
+    // these, flush() or uncork()
+    using TransSocket::send;
+    virtual int send(const char* msg, size_t length) override;
+    virtual size_t send(const iovec* iov, size_t count) override;
+    virtual void send_all(const char* msg, size_t length) override;
+    virtual IoResult try_send(const char* msg, size_t length) noexcept override;
+#endif
+
 protected:
     virtual const char* except_name() const noexcept override;
 
+#ifdef NANO_LINUX
+private:
+    bool corking_() const noexcept;
+    void rethrow_();
+    void schedule_();
+    void flush_deferred_() noexcept;
+    size_t write_(const iovec* iov, size_t count, int flags);
+    bool drain_();
+#endif
+
 }; // class Socket
 
+// a datagram of a batch
+struct Datagram {
+    char* buf;          // payload
+    size_t size;        // capacity of buf, when receiving
+    size_t length;      // bytes to send, or bytes received
+    AddrPort addrport;  // destination, or source
+};
+
 class UdpSocket : public TransSocket {
 public:
 
     // ctor & dtor
     UdpSocket(bool create = true);
+    explicit UdpSocket(Domain domain);
     UdpSocket(const Addr& addr, const Port& port);
     virtual ~UdpSocket() = default;
 
@@ -407,6 +1223,31 @@ public:
     int receive_from(char* buf, size_t buf_size, AddrPort& addrport);
     int receive_from(char* buf, size_t buf_size);
 
+    // never throw, see TransSocket::try_send()
+    IoResult try_send_to(const char* msg, size_t length,
+        const AddrPort& remote) noexcept;
+    IoResult try_receive_from(char* buf, size_t buf_size,
+        AddrPort& addrport) noexcept;
+
+    // send or receive up to count datagrams in one call, returns the
+    // number of datagrams transferred, an IPv6 remote on an IPv4 socket
+    // throws before anything is sent
+    int send_batch(const Datagram* dgrams, size_t count);
+    int receive_batch(Datagram* dgrams, size_t count);
+
+    // segmentation offload, msg is sent as segment_size datagrams and
+    // segment_size is set to the datagram size of a coalesced receive,
+    // the kernel takes at most 64 segments and 65507 bytes per call, so
+    // longer messages are sent in several calls, segment_size must fit
+    // in the path MTU, returns the bytes sent
+    int send_to(const char* msg, size_t length,
+        const AddrPort& remote, size_t segment_size);
+    int receive_from(char* buf, size_t buf_size,
+        AddrPort& addrport, size_t& segment_size);
+
+    // let the kernel coalesce received datagrams (UDP GRO)
+    bool enable_gro(bool enable) noexcept;
+
 protected:
     virtual const char* except_name() const noexcept override;
 
@@ -417,6 +1258,8 @@ public:
 
     // ctor & dtor
     ServerSocket(bool create = true);
+    explicit ServerSocket(Domain domain);
+    // binding to :: accepts IPv4 clients as well
     ServerSocket(const Addr& addr, const Port& port);
     ServerSocket(const AddrPort& addrport);
     virtual ~ServerSocket() = default;
@@ -435,14 +1278,1682 @@ public:
     // accept from client
     Socket accept();
 
+    // accept until the backlog is drained or max sockets were accepted,
+    // the sockets are non-blocking and close-on-exec
+    size_t accept_batch(std::vector<Socket>& sockets,
+        size_t max = static_cast<size_t>(-1));
+
     // set address reuse
     bool reuse_addr(bool reuseAddr) noexcept;
 
+    // let several sockets bind the same address and port
+    bool reuse_port(bool enable) noexcept;
+
 protected:
     virtual const char* except_name() const noexcept override;
 
 }; // class ServerSocket
 
-} // namespace nano
+#ifdef NANO_LINUX
+
+class UnixAddr {
+
+    // a file system path, or an abstract name after a leading '\0'
+    std::string path_;
+
+public:
+
+    // ctor & dtor, a leading '@' names an abstract socket, the empty
+    // address is an unnamed socket
+    UnixAddr() = default;
+    UnixAddr(std::string_view path);
+    UnixAddr(const char* path);
+
+    UnixAddr(const UnixAddr&) = default;
+    UnixAddr(UnixAddr&&) = default;
+    ~UnixAddr() = default;
+
+    // assignment
+    UnixAddr& operator=(const UnixAddr&) = default;
+    UnixAddr& operator=(UnixAddr&&) = default;
+
+    // a name in the abstract namespace, gone with the last socket using it
+    static UnixAddr abstract(std::string_view name);
+
+    // compare
+    friend bool operator==(const UnixAddr& a, const UnixAddr& b) noexcept {
+        return a.path_ == b.path_;
+    }
+    friend bool operator!=(const UnixAddr& a, const UnixAddr& b) noexcept {
+        return a.path_ != b.path_;
+    }
+
+    // getter
+    bool empty() const noexcept;
+    bool is_abstract() const noexcept;
+    const std::string& path() const noexcept;
+
+    // socket address, returns the length
+    socklen_t to_sockaddr(sockaddr_un& addr) const noexcept;
+    static UnixAddr from_sockaddr(const sockaddr_un& addr, socklen_t len);
+
+    // remove the socket file left by a previous run, never a regular file
+    // or a socket something still listens on, so binding it then fails
+    // with EADDRINUSE
+    bool remove_stale() const noexcept;
+
+    // the name a socket is bound or connected to
+    static UnixAddr local_of(sock_t socket);
+    static UnixAddr remote_of(sock_t socket);
+
+    // to string, abstract names start with '@'
+    std::string to_string() const;
+
+}; // class UnixAddr
+
+class UnixSocket : public TransSocket {
+
+    // server socket
+    friend class UnixServerSocket;
+
+public:
+
+    // ctor & dtor
+    UnixSocket(bool create = true);
+    virtual ~UnixSocket() = default;
+
+    // move
+    UnixSocket(UnixSocket&&) = default;
+    UnixSocket& operator=(UnixSocket&&) = default;
+
+    // uncopyable
+    UnixSocket(const UnixSocket&) = delete;
+    UnixSocket& operator=(const UnixSocket&) = delete;
+
+    // two connected sockets, e.g. for a parent and its child
+    static std::pair<UnixSocket, UnixSocket> pair();
+
+    // connect to a listening socket
+    void connect(const UnixAddr& addr);
+
+    // local & remote, empty for unnamed sockets
+    UnixAddr local() const;
+    UnixAddr remote() const;
+
+    // pass a descriptor to the peer process (SCM_RIGHTS), the sender keeps
+    // its own copy and may close it afterwards
+    void send_fd(sock_t fd);
+
+    // returns INVALID_SOCKET if the peer closed or sent data without a
+    // descriptor
+    sock_t receive_fd();
+
+    // take over a TCP connection passed with send_fd()
+    Socket receive_socket();
+
+protected:
+    virtual const char* except_name() const noexcept override;
+
+}; // class UnixSocket
+
+class UnixServerSocket : public SocketBase {
+public:
+
+    // ctor & dtor
+    UnixServerSocket(bool create = true);
+    UnixServerSocket(const UnixAddr& addr);
+    virtual ~UnixServerSocket() = default;
+
+    // move
+    UnixServerSocket(UnixServerSocket&&) = default;
+    UnixServerSocket& operator=(UnixServerSocket&&) = default;
+
+    // uncopyable
+    UnixServerSocket(const UnixServerSocket&) = delete;
+    UnixServerSocket& operator=(const UnixServerSocket&) = delete;
+
+    // bind local, a socket file left by a previous run is removed first,
+    // the file is not removed on close
+    void bind(const UnixAddr& addr);
+
+    // listen
+    void listen(int backlog = 20);
+
+    // accept from client
+    UnixSocket accept();
+
+    // get local
+    UnixAddr local() const;
+
+protected:
+    virtual const char* except_name() const noexcept override;
+
+}; // class UnixServerSocket
+
+class UnixDgramSocket : public TransSocket {
+public:
+
+    // ctor & dtor, an unbound socket can send but gets no replies
+    UnixDgramSocket(bool create = true);
+    UnixDgramSocket(const UnixAddr& addr);
+    virtual ~UnixDgramSocket() = default;
+
+    // move
+    UnixDgramSocket(UnixDgramSocket&&) = default;
+    UnixDgramSocket& operator=(UnixDgramSocket&&) = default;
+
+    // uncopyable
+    UnixDgramSocket(const UnixDgramSocket&) = delete;
+    UnixDgramSocket& operator=(const UnixDgramSocket&) = delete;
+
+    // two connected sockets, e.g. for a parent and its child
+    static std::pair<UnixDgramSocket, UnixDgramSocket> pair();
+
+    // bind local, a socket file left by a previous run is removed first
+    void bind(const UnixAddr& addr);
+
+    // set the default destination of send()
+    void connect(const UnixAddr& addr);
+
+    // local & remote, empty for unnamed sockets
+    UnixAddr local() const;
+    UnixAddr remote() const;
+
+    // send to the specified remote
+    int send_to(const char* msg, size_t length, const UnixAddr& remote);
+
+    // receive from the specified remote, never stores a '\0' after the data
+    int receive_from(char* buf, size_t buf_size, UnixAddr& addr);
+
+    // never throw, see TransSocket::try_send()
+    IoResult try_send_to(const char* msg, size_t length,
+        const UnixAddr& remote) noexcept;
+    IoResult try_receive_from(char* buf, size_t buf_size,
+        UnixAddr& addr) noexcept;
+
+protected:
+    virtual const char* except_name() const noexcept override;
+
+}; // class UnixDgramSocket
+
+#endif // NANO_LINUX
+
+class IOBuffer {
+public:
+
+    // size of the pooled chunks the buffer is made of
+    static constexpr size_t CHUNK_SIZE = 16384;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+
+    // data[begin, end) is readable, data[end, CHUNK_SIZE) of the last chunk
+    // is free tail space
+    struct Chunk {
+        char* data;
+        size_t begin;
+        size_t end;
+    };
+
+    std::deque<Chunk> chunks_;
+    size_t size_;
+
+    // backpressure
+    size_t high_water_;
+    size_t low_water_;
+
+public:
+
+    // ctor & dtor, a high water mark of 0 means unlimited
+    IOBuffer(size_t high_water = 0, size_t low_water = 0) noexcept;
+    virtual ~IOBuffer();
+
+    // move
+    IOBuffer(IOBuffer&& other) noexcept;
+    IOBuffer& operator=(IOBuffer&& other) noexcept;
+
+    // uncopyable
+    IOBuffer(const IOBuffer&) = delete;
+    IOBuffer& operator=(const IOBuffer&) = delete;
+
+    // readable bytes
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+    void clear() noexcept;
+
+    // write to the tail
+    void append(const char* data, size_t length);
+    void append(std::string_view data);
+
+    // the readable bytes of the first chunk
+    std::string_view front() const noexcept;
+
+    // the first length bytes as one view, copies only if they span chunks,
+    // length must not exceed CHUNK_SIZE
+    std::string_view peek(size_t length);
+
+    // offset of the first c, or npos
+    size_t find(char c) const noexcept;
+
+    // drop bytes from the head, freed chunks go back to the pool
+    void consume(size_t length) noexcept;
+
+    // copy and consume up to length bytes, returns the bytes read
+    size_t read(char* buf, size_t length) noexcept;
+    std::string read_string(size_t length);
+
+    // read from the socket into the tail, up to max_bytes in one call,
+    // returns the bytes read, 0 if the peer closed, or -ERR_CODE
+    int read_from(const SocketBase& sock, size_t max_bytes = 65536);
+
+    // send from the head and consume what was sent, returns the bytes
+    // sent before a non-blocking socket would block
+    size_t write_to(const SocketBase& sock);
+
+    // water marks
+    void water_marks(size_t high, size_t low) noexcept;
+    bool above_high_water() const noexcept;
+    bool below_low_water() const noexcept;
+
+private:
+    size_t reserve_(size_t length);
+    void trim_() noexcept;
+
+}; // class IOBuffer
+
+// queues frames of a 4-byte big-endian length and the payload, and sends
+// all of them in as few calls as possible
+class FrameWriter {
+public:
+
+    static constexpr size_t HEADER_SIZE = 4;
+
+private:
+
+    // bytes in buf_ at offset, or a payload the caller keeps alive
+    struct Segment {
+        const char* data;
+        size_t offset;
+        size_t length;
+    };
+
+    std::string buf_;
+    std::vector<Segment> segments_;
+    size_t size_;
+
+public:
+
+    // ctor & dtor
+    FrameWriter() noexcept;
+    virtual ~FrameWriter() = default;
+
+    // move
+    FrameWriter(FrameWriter&&) = default;
+    FrameWriter& operator=(FrameWriter&&) = default;
+
+    // uncopyable
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    // queue a frame, the payload is copied
+    void write(std::string_view payload);
+
+    // queue a frame without copying the payload, which must stay valid
+    // until it is flushed
+    void write_ref(std::string_view payload);
+
+    // send the queued bytes, returns the bytes sent, fewer than pending()
+    // only if a non-blocking socket would block, the rest stays queued and
+    // the copied bytes already sent are released
+    size_t flush(const SocketBase& sock);
+
+    // queued bytes, headers included
+    size_t pending() const noexcept;
+    bool empty() const noexcept;
+    void clear() noexcept;
+
+private:
+    void append_(const char* data, size_t length);
+    void consume_(size_t length) noexcept;
+    void compact_() noexcept;
+
+}; // class FrameWriter
+
+// splits a stream into the frames written by FrameWriter, every frame that
+// arrived with one receive is handed out in place
+class FrameReader {
+public:
+
+    static constexpr size_t HEADER_SIZE = 4;
+
+    // larger frames are taken as a corrupt stream
+    static constexpr size_t MAX_FRAME = 16 * 1024 * 1024;
+
+private:
+
+    // buf_[begin_, end_) is received and not handed out
+    std::unique_ptr<char[]> buf_;
+    size_t capacity_;
+    size_t begin_;
+    size_t end_;
+    size_t max_frame_;
+
+public:
+
+    // ctor & dtor, the buffer grows for frames larger than capacity
+    FrameReader(size_t capacity = 65536, size_t max_frame = MAX_FRAME);
+    virtual ~FrameReader() = default;
+
+    // move
+    FrameReader(FrameReader&&) = default;
+    FrameReader& operator=(FrameReader&&) = default;
+
+    // uncopyable
+    FrameReader(const FrameReader&) = delete;
+    FrameReader& operator=(const FrameReader&) = delete;
+
+    // receive once into the buffer, returns the bytes read, 0 if the
+    // peer closed, or -ERR_CODE
+    int read_from(const SocketBase& sock);
+
+    // add bytes received elsewhere
+    void append(const char* data, size_t length);
+
+    // the next complete frame, valid until the next read_from() or
+    // append(), throws if its length exceeds the limit
+    bool next(std::string_view& frame);
+
+    // received bytes not handed out yet
+    size_t buffered() const noexcept;
+
+private:
+    size_t reserve_(size_t length);
+
+}; // class FrameReader
+
+class ConnectionPool {
+public:
+
+    // a connection handed out by acquire(), it goes back to its pool entry
+    // with release() or is closed with the lease, which must not outlive
+    // the pool
+    class Lease {
+        friend class ConnectionPool;
+
+        ConnectionPool* pool_;
+        AddrPort remote_;
+        Socket sock_;
+
+        Lease(ConnectionPool* pool, const AddrPort& remote, Socket&& sock);
+
+    public:
+
+        // ctor & dtor, a connection still held is closed, it may be in the
+        // middle of a request
+        Lease() noexcept;
+        ~Lease();
+
+        // move
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+
+        // hand the connection back, it is closed unless reusable
+        void release(bool reusable = true) noexcept;
+
+        Socket& socket() noexcept;
+        Socket* operator->() noexcept;
+        explicit operator bool() const noexcept;
+
+    }; // class Lease
+
+private:
+
+    struct Idle {
+        Socket sock;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    // removed once it has neither idle nor active connections
+    struct Host {
+        std::deque<Idle> idle;  // oldest first
+        size_t active = 0;      // leased out by acquire()
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::unordered_map<AddrPort, Host> hosts_;
+
+    size_t max_per_host_;
+    std::chrono::milliseconds max_idle_;
+
+public:
+
+    // ctor & dtor, idle connections are closed with the pool
+    ConnectionPool(size_t max_per_host = 8,
+        std::chrono::milliseconds max_idle = std::chrono::seconds(60));
+    virtual ~ConnectionPool();
+
+    // uncopyable & unmovable
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // the most recently used healthy idle connection, or a new one, waits
+    // while max_per_host connections to remote are leased out, timeout
+    // bounds the wait and the connect together, a negative one waits
+    // forever
+    Lease acquire(const AddrPort& remote,
+        std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
+    // close connections idle for longer than max_idle, returns the number
+    size_t evict_idle();
+
+    // close every idle connection
+    void clear() noexcept;
+
+    size_t idle_count() const noexcept;
+    size_t active_count(const AddrPort& remote) const noexcept;
+
+private:
+    void release_(const AddrPort& remote, Socket&& sock,
+        bool reusable) noexcept;
+    void erase_unused_(const AddrPort& remote) noexcept;
+
+}; // class ConnectionPool
+
+// bounded queue for many producers and one consumer, producers claim a
+// slot with one CAS and the consumer never writes a shared counter, a
+// producer stalled between claiming and filling its slot holds back the
+// consumer but no other producer
+template <class T>
+class MpscQueue {
+
+    struct Cell {
+        // pos when free, pos + 1 when filled, pos + capacity when consumed
+        std::atomic<size_t> seq;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+
+    // producers and the consumer write different cache lines
+    alignas(64) std::atomic<size_t> tail_;
+    alignas(64) size_t head_;
+
+public:
+
+    // ctor & dtor, the capacity is rounded up to a power of two
+    explicit MpscQueue(size_t capacity) : mask_(1), tail_(0), head_(0) {
+        while (mask_ + 1 < capacity) mask_ = (mask_ << 1) | 1;
+        cells_.reset(new Cell[mask_ + 1]);
+        for (size_t i = 0; i <= mask_; ++i)
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    ~MpscQueue() {
+        while (T* value = this->front_()) {
+            value->~T();
+            this->advance_();
+        }
+    }
+
+    // uncopyable & unmovable
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // any thread, false if the queue is full
+    template <class... Args>
+    bool try_emplace(Args&&... args) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq - pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                // not consumed yet since the last lap
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        ::new (cell->storage) T(std::forward<Args>(args)...);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(T&& value) {
+        return this->try_emplace(std::move(value));
+    }
+
+    // consumer thread only, false if the queue is empty
+    bool try_pop(T& value) {
+        T* front = this->front_();
+        if (front == nullptr) return false;
+        value = std::move(*front);
+        front->~T();
+        this->advance_();
+        return true;
+    }
+
+    // consumer thread only
+    bool empty() const noexcept {
+        const Cell& cell = cells_[head_ & mask_];
+        return cell.seq.load(std::memory_order_acquire) != head_ + 1;
+    }
+
+    size_t capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+private:
+    T* front_() noexcept {
+        Cell& cell = cells_[head_ & mask_];
+        if (cell.seq.load(std::memory_order_acquire) != head_ + 1)
+            return nullptr;
+        return std::launder(reinterpret_cast<T*>(cell.storage));
+    }
+
+    void advance_() noexcept {
+        cells_[head_ & mask_].seq.store(head_ + mask_ + 1,
+            std::memory_order_release);
+        ++head_;
+    }
+
+}; // class MpscQueue
+
+template <class Signature>
+class UniqueFunction;
+
+// std::function for move-only callables, such as a lambda owning a Socket,
+// small callables are stored inline
+template <class R, class... Args>
+class UniqueFunction<R(Args...)> {
+
+    // a lambda capturing a Socket and a pointer fits
+    static constexpr size_t INLINE_SIZE = 88;
+
+    struct Ops {
+        R (*call)(void* storage, Args&&... args);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <class Fn>
+    static constexpr bool is_inline_ = sizeof(Fn) <= INLINE_SIZE
+        && alignof(Fn) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible_v<Fn>;
+
+    alignas(std::max_align_t) unsigned char storage_[INLINE_SIZE];
+    const Ops* ops_;
+
+public:
+
+    // ctor & dtor
+    UniqueFunction() noexcept : ops_(nullptr) {}
+    UniqueFunction(std::nullptr_t) noexcept : ops_(nullptr) {}
+
+    template <class Fn, class F = std::decay_t<Fn>, class = std::enable_if_t<
+        !std::is_same_v<F, UniqueFunction>
+        && std::is_invocable_r_v<R, F&, Args...>>>
+    UniqueFunction(Fn&& fn) : ops_(&OPS_<F>) {
+        if constexpr (is_inline_<F>) {
+            ::new (storage_) F(std::forward<Fn>(fn));
+        } else {
+            ::new (storage_) F*(new F(std::forward<Fn>(fn)));
+        }
+    }
+
+    ~UniqueFunction() {
+        if (ops_) ops_->destroy(storage_);
+    }
+
+    // move
+    UniqueFunction(UniqueFunction&& other) noexcept : ops_(other.ops_) {
+        if (ops_) ops_->move(storage_, other.storage_);
+        other.ops_ = nullptr;
+    }
+
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+        if (this == &other) return *this;
+        if (ops_) ops_->destroy(storage_);
+        ops_ = other.ops_;
+        if (ops_) ops_->move(storage_, other.storage_);
+        other.ops_ = nullptr;
+        return *this;
+    }
+
+    UniqueFunction& operator=(std::nullptr_t) noexcept {
+        if (ops_) ops_->destroy(storage_);
+        ops_ = nullptr;
+        return *this;
+    }
+
+    // uncopyable
+    UniqueFunction(const UniqueFunction&) = delete;
+    UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+    explicit operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    R operator()(Args... args) {
+        if (ops_ == nullptr) throw std::bad_function_call();
+        return ops_->call(storage_, std::forward<Args>(args)...);
+    }
+
+private:
+    template <class F>
+    static F* target_(void* storage) noexcept {
+        if constexpr (is_inline_<F>) {
+            return std::launder(reinterpret_cast<F*>(storage));
+        } else {
+            return *std::launder(reinterpret_cast<F**>(storage));
+        }
+    }
+
+    template <class F>
+    static R call_(void* storage, Args&&... args) {
+        return std::invoke(*target_<F>(storage), std::forward<Args>(args)...);
+    }
+
+    // the source is left empty, inline callables are destroyed there
+    template <class F>
+    static void move_(void* dst, void* src) noexcept {
+        if constexpr (is_inline_<F>) {
+            F* fn = target_<F>(src);
+            ::new (dst) F(std::move(*fn));
+            fn->~F();
+        } else {
+            ::new (dst) F*(target_<F>(src));
+        }
+    }
+
+    template <class F>
+    static void destroy_(void* storage) noexcept {
+        if constexpr (is_inline_<F>) {
+            target_<F>(storage)->~F();
+        } else {
+            delete target_<F>(storage);
+        }
+    }
+
+    template <class F>
+    static constexpr Ops OPS_ = {&call_<F>, &move_<F>, &destroy_<F>};
+
+}; // class UniqueFunction
+
+#ifdef NANO_LINUX
+
+class EventLoop {
+public:
+
+    // events of interest
+    enum Event : uint32_t {
+        READABLE = EPOLLIN,
+        WRITABLE = EPOLLOUT,
+    };
+
+    using Callback = std::function<void()>;
+
+    // work posted from other threads, may own sockets
+    using Job = UniqueFunction<void()>;
+
+private:
+
+    struct Handler {
+        sock_t fd;
+        uint32_t events;
+        Callback on_read;
+        Callback on_write;
+        Callback on_error;
+        // once_writable(), and whether only it registered the socket
+        Callback on_writable_once;
+        bool temporary;
+    };
+
+    // epoll instance
+    int epfd_;
+    std::atomic<bool> running_;
+
+    // eventfd to interrupt a blocking wait
+    int wakeup_fd_;
+
+    // posted jobs, posters write the eventfd only if the loop is idle, so
+    // a burst of posts costs one wakeup
+    MpscQueue<Job> posted_;
+    std::atomic<bool> idle_;
+
+    // run once the current iteration is done
+    std::vector<Callback> deferred_;
+
+    // ready list of a single wait
+    std::vector<epoll_event> events_;
+
+    // registered handlers, and handlers removed while dispatching
+    std::unordered_map<sock_t, std::unique_ptr<Handler>> handlers_;
+    std::vector<std::unique_ptr<Handler>> removed_;
+
+public:
+
+    // ctor & dtor
+    EventLoop(int max_events = 256, size_t post_capacity = 1024);
+    virtual ~EventLoop();
+
+    // uncopyable & unmovable
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // register a socket (switched to non-blocking, edge-triggered)
+    void add(sock_t fd, uint32_t events, Callback on_read,
+        Callback on_write = nullptr, Callback on_error = nullptr);
+    void add(const SocketBase& sock, uint32_t events, Callback on_read,
+        Callback on_write = nullptr, Callback on_error = nullptr);
+
+    // change the events of interest
+    void modify(sock_t fd, uint32_t events);
+    void modify(const SocketBase& sock, uint32_t events);
+
+    // unregister a socket
+    void remove(sock_t fd) noexcept;
+    void remove(const SocketBase& sock) noexcept;
+
+    bool contains(sock_t fd) const noexcept;
+    size_t size() const noexcept;
+
+    // wait once and dispatch, returns the number of ready sockets
+    int run_once(int timeout_ms = -1);
+
+    // dispatch until stop() is called
+    void run();
+    void stop() noexcept;
+    bool is_running() const noexcept;
+
+    // interrupt a blocking wait, callable from any thread
+    void wakeup() noexcept;
+
+    // run job on the loop thread after the current iteration, callable
+    // from any thread, returns false and leaves job alone if the queue
+    // is full
+    bool post(Job&& job);
+
+    // run callback on the loop thread once the events and posted jobs of
+    // the current iteration are handled, e.g. to flush coalesced writes,
+    // call from the loop thread
+    void defer(Callback callback);
+
+    // run callback once the socket is writable or fails, e.g. to resume a
+    // flush the socket cut short, whether or not it was added, replaces
+    // an earlier callback, call from the loop thread
+    void once_writable(sock_t fd, Callback callback);
+    void once_writable(const SocketBase& sock, Callback callback);
+
+private:
+    bool update_(Handler& handler) noexcept;
+    void run_posted_();
+    void run_deferred_();
+
+}; // class EventLoop
+
+class IoUring {
+public:
+
+    // result is the number of bytes, or a negative error code
+    using Callback = std::function<void(int result)>;
+
+    // error is 0 on success, or a positive error code
+    using AcceptCallback = std::function<void(Socket&& sock, int error)>;
+
+    // data is only valid during the callback, length <= 0 ends the stream
+    using RecvCallback = std::function<void(const char* data, int length)>;
+
+private:
+
+    struct Op;
+
+    int ring_fd_;
+
+    // eventfd read by an armed operation, written by stop()
+    int wakeup_fd_;
+    std::atomic<bool> running_;
+
+    // submission queue
+    void* sq_ring_;
+    size_t sq_ring_size_;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_array_;
+    unsigned sq_mask_;
+    unsigned sq_entries_;
+    unsigned sq_pending_;
+    io_uring_sqe* sqes_;
+
+    // completion queue
+    void* cq_ring_;
+    size_t cq_ring_size_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned cq_mask_;
+    io_uring_cqe* cqes_;
+
+    // ring of provided buffers for receives, shared with the kernel,
+    // nullptr if they are provided with IORING_OP_PROVIDE_BUFFERS
+    io_uring_buf_ring* buf_ring_;
+    size_t buf_ring_size_;
+    char* buf_base_;
+    unsigned buf_count_;
+    unsigned buf_size_;
+    unsigned short buf_tail_;
+    std::vector<unsigned short> buf_recycled_;
+
+    // operations in flight
+    std::unordered_set<Op*> ops_;
+
+public:
+
+    // ctor & dtor
+    IoUring(unsigned entries = 256);
+    virtual ~IoUring();
+
+    // uncopyable & unmovable
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // whether the running kernel supports io_uring
+    static bool available() noexcept;
+
+    // register a ring of count buffers of size bytes for receive(),
+    // count is a power of 2 up to 32768
+    void provide_buffers(unsigned count = 256, unsigned size = 4096);
+
+    // multishot accept, one callback per connection
+    void accept(const ServerSocket& server, AcceptCallback callback);
+
+    // multishot receive into the provided buffers
+    void receive(const SocketBase& sock, RecvCallback callback);
+
+    // msg must stay valid until the callback is called
+    void send(const SocketBase& sock, const char* msg, size_t length,
+        Callback callback = nullptr);
+
+    // the socket is released immediately and closed asynchronously, a
+    // multishot receive or accept on it is canceled first
+    void close(SocketBase& sock, Callback callback = nullptr);
+
+    // submit queued operations, returns the number submitted
+    int submit();
+
+    // submit, wait once and dispatch, returns the number of completions
+    int run_once(int timeout_ms = -1);
+
+    // dispatch until stop() is called, stop() may be called from any thread
+    void run();
+    void stop() noexcept;
+    bool is_running() const noexcept;
+
+private:
+    io_uring_sqe* get_sqe_();
+    void prep_accept_(Op* op);
+    void prep_receive_(Op* op);
+    void prep_wakeup_(Op* op);
+    void recycle_buffer_(unsigned short bid);
+    void provide_recycled_();
+    bool cancel_all_() noexcept;
+    void complete_(Op* op, int res, unsigned flags);
+    int enter_(unsigned to_submit, unsigned min_complete,
+        unsigned flags, void* arg, size_t argsz) noexcept;
+
+}; // class IoUring
+
+class ShardedServer {
+public:
+
+    // called on the loop thread of the shard that accepted the connection
+    using AcceptHandler = std::function<void(EventLoop& loop, Socket&& sock)>;
+
+    // called on the loop thread of the shard that failed, e.g. accept()
+    // out of file descriptors, the handler threw or pinning failed
+    using ErrorHandler = std::function<void(size_t shard,
+        const std::exception& e)>;
+
+private:
+
+    struct Shard;
+
+    // one listening socket, loop and thread per shard
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    // CPUs allowed by the process affinity mask, the k-th of them belongs
+    // to shard k % size() both for steering and for pinning
+    std::vector<int> cpus_;
+    std::atomic<bool> running_;
+    bool pin_threads_;
+    AcceptHandler handler_;
+    ErrorHandler on_error_;
+
+public:
+
+    // ctor & dtor, 0 shards means one per CPU in the affinity mask
+    ShardedServer(const Addr& addr, const Port& port, size_t shards = 0);
+    ShardedServer(const AddrPort& addrport, size_t shards = 0);
+    virtual ~ShardedServer();
+
+    // uncopyable & unmovable
+    ShardedServer(const ShardedServer&) = delete;
+    ShardedServer& operator=(const ShardedServer&) = delete;
+
+    // listen on every shard
+    void listen(int backlog = 20);
+
+    // let the kernel pick the shard of the CPU that received the
+    // connection, call after listen(). With fewer shards than CPUs a shard
+    // serves several CPUs, with more only the first ones get connections.
+    // CPUs outside the affinity mask go to shard cpu % size()
+    bool steer_by_cpu() noexcept;
+
+    // pin the thread of each shard to the CPUs steered to it, or share
+    // one with more shards than CPUs, enabled by default
+    void pin_threads(bool enable) noexcept;
+
+    // errors are dropped without a handler, call before start()
+    void on_error(ErrorHandler handler);
+
+    // start one loop thread per shard
+    void start(AcceptHandler handler);
+
+    // stop and join the loop threads
+    void stop() noexcept;
+
+    size_t size() const noexcept;
+    EventLoop& loop(size_t index);
+    AddrPort local() const noexcept;
+
+private:
+    void run_(size_t index);
+    void accept_(size_t index);
+    void report_(size_t index, const std::exception& e) noexcept;
+
+}; // class ShardedServer
+
+class TimerWheel {
+public:
+
+    // slot index << 32 | generation, 0 is never a valid id
+    using TimerId = uint64_t;
+
+    using Callback = std::function<void()>;
+
+    // 4 levels of 256 slots cover 2^32 ticks
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOTS = 256;
+
+private:
+
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    // pooled timer, linked into the list of its slot
+    struct Node {
+        Callback callback;
+        uint64_t expires;
+        uint32_t generation;
+        uint32_t prev;
+        uint32_t next;
+        uint32_t slot;
+    };
+
+    std::vector<Node> nodes_;
+    uint32_t free_;
+    uint32_t slots_[LEVELS * SLOTS];
+    size_t level_size_[LEVELS];
+    size_t size_;
+
+    // time in ticks since start_
+    std::chrono::steady_clock::duration tick_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t now_;
+
+    // timerfd armed for the tick armed_
+    int timer_fd_;
+    uint64_t armed_;
+    EventLoop* loop_;
+
+public:
+
+    // ctor & dtor
+    TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(1));
+    virtual ~TimerWheel();
+
+    // uncopyable & unmovable
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // run callback once after delay, rounded up to whole ticks
+    TimerId add(std::chrono::milliseconds delay, Callback callback);
+
+    // stop a pending timer, false if it already ran or was canceled
+    bool cancel(TimerId id) noexcept;
+
+    // move a pending timer to delay from now, e.g. an idle timeout on
+    // activity, false if it already ran or was canceled
+    bool reschedule(TimerId id, std::chrono::milliseconds delay) noexcept;
+
+    bool contains(TimerId id) const noexcept;
+    size_t size() const noexcept;
+
+    // run the timers that are due, returns the number run
+    size_t advance();
+
+    // milliseconds until the next tick with work to do, -1 if none,
+    // for a loop that does not use the timerfd
+    int next_timeout() const noexcept;
+
+    // timerfd readable when advance() has work to do
+    int fd() const noexcept;
+
+    // run the timers on the loop thread, call both from the loop thread
+    void attach(EventLoop& loop);
+    void detach() noexcept;
+
+private:
+    uint64_t current_tick_() const noexcept;
+    uint64_t next_tick_() const noexcept;
+    Node* find_(TimerId id) noexcept;
+    void link_(uint32_t index) noexcept;
+    void unlink_(uint32_t index) noexcept;
+    void release_(uint32_t index) noexcept;
+    void cascade_(size_t level, size_t slot) noexcept;
+    size_t expire_(size_t slot);
+    void arm_(uint64_t tick) noexcept;
+
+}; // class TimerWheel
+
+#endif // NANO_LINUX
+
+class EventLoop;
+
+class Resolver {
+public:
+
+    // error is 0 on success, or a getaddrinfo() error code
+    using Callback = std::function<void(const std::vector<Addr>& addrs,
+        int error)>;
+
+    // the cache is split into shards to keep lock contention low
+    static constexpr size_t SHARDS = 16;
+    static constexpr size_t SHARD_CAPACITY = 1024;
+
+private:
+
+    struct Entry {
+        std::vector<Addr> addrs;
+        int error;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    struct Waiter {
+        Callback callback;
+        bool on_loop;
+    };
+
+    // cache
+    Shard shards_[SHARDS];
+    std::atomic<long long> ttl_ms_;
+    std::atomic<long long> negative_ttl_ms_;
+
+    // worker threads, queries of the same name in flight are merged
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::string> queue_;
+    std::unordered_map<std::string, std::vector<Waiter>> waiting_;
+    std::vector<std::thread> workers_;
+    size_t max_workers_;
+    bool stopping_;
+
+    // callbacks to run on the attached loop
+    std::mutex done_mutex_;
+    std::vector<std::function<void()>> done_;
+    int notify_fd_;
+    EventLoop* loop_;
+
+public:
+
+    // ctor & dtor, the workers are started on the first asynchronous query
+    Resolver(size_t workers = 2);
+    virtual ~Resolver();
+
+    // uncopyable & unmovable
+    Resolver(const Resolver&) = delete;
+    Resolver& operator=(const Resolver&) = delete;
+
+    // the process-wide resolver used by Addr
+    static Resolver& global();
+
+    // how long answers and failures are cached, 0 disables caching
+    void ttl(std::chrono::milliseconds positive,
+        std::chrono::milliseconds negative) noexcept;
+
+    // blocks on a cache miss, returns 0 or a getaddrinfo() error code
+    int resolve(std::string_view name, std::vector<Addr>& addrs);
+
+    // never blocks, the callback runs at once on a cache hit, otherwise on
+    // a worker thread or on the attached loop
+    void resolve(std::string_view name, Callback callback);
+
+    // never blocks, the future throws NanoExcept on failure
+    std::future<std::vector<Addr>> resolve_async(std::string_view name);
+
+    // drop every cached answer
+    void clear() noexcept;
+
+    static const char* error_string(int error) noexcept;
+
+#ifdef NANO_LINUX
+    // run the callbacks of asynchronous queries on the loop thread,
+    // call both from the loop thread
+    void attach(EventLoop& loop);
+    void detach() noexcept;
+#endif
+
+private:
+    bool lookup_(const std::string& name, std::vector<Addr>& addrs,
+        int& error);
+    void store_(const std::string& name, const std::vector<Addr>& addrs,
+        int error);
+    void enqueue_(std::string name, Callback callback, bool on_loop);
+    void work_();
+    void dispatch_();
+
+}; // class Resolver
+
+} // namespace nano
+
+// C++20 only, the rest of NanoNet stays C++17
+#if defined(NANO_LINUX) && defined(__cpp_impl_coroutine) \
+    && __has_include(<coroutine>)
+
+#define NANO_COROUTINE 1
+
+// C++
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nano {
+
+template <class T = void>
+class Task;
+
+namespace detail {
+
+// recycles coroutine frames by size class, per thread
+class FramePool {
+
+    static constexpr size_t GRANULE = 64;
+    static constexpr size_t CLASSES = 64;
+    static constexpr size_t CAPACITY = 1024;
+
+    struct Block {
+        Block* next;
+    };
+
+    Block* free_[CLASSES] = {};
+    size_t count_[CLASSES] = {};
+
+public:
+
+    ~FramePool() {
+        for (Block* block : free_) {
+            while (block) {
+                Block* next = block->next;
+                ::operator delete(block);
+                block = next;
+            }
+        }
+    }
+
+    void* allocate(size_t size) {
+        size_t index = (size + GRANULE - 1) / GRANULE;
+        if (index == 0 || index > CLASSES) return ::operator new(size);
+        Block*& head = free_[index - 1];
+        if (head == nullptr) return ::operator new(index * GRANULE);
+        Block* block = head;
+        head = block->next;
+        --count_[index - 1];
+        return block;
+    }
+
+    void deallocate(void* ptr, size_t size) noexcept {
+        size_t index = (size + GRANULE - 1) / GRANULE;
+        if (index == 0 || index > CLASSES || count_[index - 1] == CAPACITY) {
+            ::operator delete(ptr);
+            return;
+        }
+        Block* block = static_cast<Block*>(ptr);
+        block->next = free_[index - 1];
+        free_[index - 1] = block;
+        ++count_[index - 1];
+    }
+
+    static FramePool& local() noexcept {
+        thread_local FramePool pool;
+        return pool;
+    }
+
+}; // class FramePool
+
+struct PromiseBase {
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+    bool detached = false;
+
+    static void* operator new(size_t size) {
+        return FramePool::local().allocate(size);
+    }
+
+    static void operator delete(void* ptr, size_t size) noexcept {
+        FramePool::local().deallocate(ptr, size);
+    }
+
+    // resume the awaiting coroutine, or free a detached frame
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<Promise> handle) noexcept {
+            PromiseBase& promise = handle.promise();
+            if (promise.detached) {
+                // like std::thread, nobody can see the exception
+                if (promise.exception) std::terminate();
+                handle.destroy();
+                return std::noop_coroutine();
+            }
+            if (promise.continuation) return promise.continuation;
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() noexcept {
+        exception = std::current_exception();
+    }
+
+}; // struct PromiseBase
+
+template <class T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+
+    template <class U>
+    void return_value(U&& result) {
+        value.emplace(std::forward<U>(result));
+    }
+
+    T result() {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+}; // struct Promise
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() {
+        if (exception) std::rethrow_exception(exception);
+    }
+}; // struct Promise<void>
+
+// an operation waiting for its socket to become ready
+struct IoWaiter {
+    std::coroutine_handle<> handle;
+
+    // retry the operation, true if it is done
+    virtual bool try_complete() = 0;
+
+protected:
+    ~IoWaiter() = default;
+};
+
+struct IoWaiters {
+    IoWaiter* reader = nullptr;
+    IoWaiter* writer = nullptr;
+};
+
+inline void resume_(IoWaiter*& slot) {
+    IoWaiter* waiter = slot;
+    if (waiter == nullptr || !waiter->try_complete()) return;
+    slot = nullptr;
+    waiter->handle.resume();
+}
+
+using WatchRegistry = std::unordered_map<EventLoop*,
+    std::unordered_map<sock_t, std::shared_ptr<IoWaiters>>>;
+
+// the sockets watched by the coroutines of this thread, per loop
+inline WatchRegistry& registry_() noexcept {
+    thread_local WatchRegistry registry;
+    return registry;
+}
+
+// register a socket with the loop once, its callbacks resume the waiters
+inline std::shared_ptr<IoWaiters> watch_(EventLoop& loop, sock_t fd) {
+    auto& sockets = registry_()[&loop];
+    if (loop.contains(fd)) {
+        auto it = sockets.find(fd);
+        if (it == sockets.end()) {
+            throw NanoExcept("[Coroutine] Socket " + std::to_string(fd)
+                + " is registered with other callbacks");
+        }
+        return it->second;
+    }
+    auto waiters = std::make_shared<IoWaiters>();
+    loop.add(fd, EventLoop::READABLE | EventLoop::WRITABLE,
+        [waiters] { resume_(waiters->reader); },
+        [waiters] { resume_(waiters->writer); },
+        [waiters] {
+            resume_(waiters->reader);
+            resume_(waiters->writer);
+        });
+    sockets[fd] = waiters;
+    return waiters;
+}
+
+// forget a socket before its fd is closed and reused, returns its waiters
+inline std::shared_ptr<IoWaiters> unwatch_(EventLoop& loop,
+        sock_t fd) noexcept {
+    WatchRegistry& registry = registry_();
+    auto it = registry.find(&loop);
+    if (it == registry.end()) return nullptr;
+    auto found = it->second.find(fd);
+    if (found == it->second.end()) return nullptr;
+    std::shared_ptr<IoWaiters> waiters = std::move(found->second);
+    it->second.erase(found);
+    if (it->second.empty()) registry.erase(it);
+    loop.remove(fd);
+    return waiters;
+}
+
+// tries Op at once, and again each time the socket becomes ready
+template <class Op>
+class IoAwaiter : public IoWaiter {
+
+    EventLoop& loop_;
+    sock_t fd_;
+    bool write_;
+    Op op_;
+    std::shared_ptr<IoWaiters> waiters_;
+
+    IoWaiter*& slot_() noexcept {
+        return write_ ? waiters_->writer : waiters_->reader;
+    }
+
+public:
+
+    IoAwaiter(EventLoop& loop, sock_t fd, bool write, Op op)
+        : loop_(loop), fd_(fd), write_(write), op_(std::move(op)) {}
+
+    IoAwaiter(const IoAwaiter&) = delete;
+    IoAwaiter& operator=(const IoAwaiter&) = delete;
+
+    // the coroutine was destroyed while waiting
+    ~IoAwaiter() {
+        if (waiters_ && slot_() == this) slot_() = nullptr;
+    }
+
+    bool await_ready() {
+        // registering makes the socket non-blocking
+        waiters_ = watch_(loop_, fd_);
+        return op_();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) noexcept {
+        this->handle = handle;
+        slot_() = this;
+    }
+
+    auto await_resume() {
+        return op_.result();
+    }
+
+    virtual bool try_complete() override {
+        return op_();
+    }
+
+}; // class IoAwaiter
+
+struct ReceiveOp {
+    TransSocket& sock;
+    char* buf;
+    size_t size;
+    IoResult ret;
+
+    bool operator()() noexcept {
+        ret = sock.try_receive(buf, size);
+        return !ret.would_block();
+    }
+
+    IoResult result() noexcept { return ret; }
+};
+
+struct SendOp {
+    TransSocket& sock;
+    const char* msg;
+    size_t length;
+    size_t sent;
+    IoResult ret;
+
+    bool operator()() noexcept {
+        while (sent < length) {
+            IoResult part = sock.try_send(msg + sent, length - sent);
+            if (part.would_block()) return false;
+            if (!part) {
+                ret = IoResult{static_cast<int>(sent), part.error};
+                return true;
+            }
+            sent += static_cast<size_t>(part.bytes);
+        }
+        ret = IoResult{static_cast<int>(sent), 0};
+        return true;
+    }
+
+    IoResult result() noexcept { return ret; }
+};
+
+struct ReceiveFromOp {
+    UdpSocket& sock;
+    char* buf;
+    size_t size;
+    AddrPort& from;
+    IoResult ret;
+
+    bool operator()() noexcept {
+        ret = sock.try_receive_from(buf, size, from);
+        return !ret.would_block();
+    }
+
+    IoResult result() noexcept { return ret; }
+};
+
+struct AcceptOp {
+    ServerSocket& server;
+    std::vector<Socket> sockets;
+    std::exception_ptr exception;
+
+    bool operator()() noexcept {
+        try {
+            return server.accept_batch(sockets, 1) > 0;
+        } catch (...) {
+            exception = std::current_exception();
+            return true;
+        }
+    }
+
+    Socket result() {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(sockets.front());
+    }
+};
+
+} // namespace detail
+
+// lazily started coroutine, co_await it to run it
+template <class T>
+class Task {
+public:
+
+    using promise_type = detail::Promise<T>;
+
+private:
+
+    std::coroutine_handle<promise_type> handle_;
+
+public:
+
+    // ctor & dtor
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+        : handle_(handle) {}
+
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    // move
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    // uncopyable
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    bool done() const noexcept {
+        return !handle_ || handle_.done();
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{handle_};
+    }
+
+    // start a task nobody awaits, its frame is freed when it finishes
+    friend void spawn(Task<void>&& task);
+
+    // start the task and run the loop until it finishes
+    template <class U>
+    friend U sync_wait(EventLoop& loop, Task<U>&& task);
+
+}; // class Task
+
+namespace detail {
+
+template <class T>
+inline Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(
+        std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+inline void spawn(Task<void>&& task) {
+    auto handle = std::exchange(task.handle_, {});
+    if (!handle) return;
+    handle.promise().detached = true;
+    handle.resume();
+}
+
+template <class T>
+inline T sync_wait(EventLoop& loop, Task<T>&& task) {
+    task.handle_.resume();
+    while (!task.handle_.done()) loop.run_once();
+    return task.handle_.promise().result();
+}
+
+// receive once, IoResult as from TransSocket::try_receive()
+inline auto async_receive(EventLoop& loop, TransSocket& sock,
+        char* buf, size_t size) {
+    return detail::IoAwaiter<detail::ReceiveOp>(loop, sock.get(), false,
+        detail::ReceiveOp{sock, buf, size, IoResult{0, 0}});
+}
+
+// send every byte, or stop at the first error
+inline auto async_send(EventLoop& loop, TransSocket& sock,
+        const char* msg, size_t length) {
+    return detail::IoAwaiter<detail::SendOp>(loop, sock.get(), true,
+        detail::SendOp{sock, msg, length, 0, IoResult{0, 0}});
+}
+
+inline auto async_receive_from(EventLoop& loop, UdpSocket& sock,
+        char* buf, size_t size, AddrPort& from) {
+    return detail::IoAwaiter<detail::ReceiveFromOp>(loop, sock.get(), false,
+        detail::ReceiveFromOp{sock, buf, size, from, IoResult{0, 0}});
+}
+
+// the accepted socket is non-blocking, errors are thrown as by accept()
+inline auto async_accept(EventLoop& loop, ServerSocket& server) {
+    return detail::IoAwaiter<detail::AcceptOp>(loop, server.get(), false,
+        detail::AcceptOp{server, {}, nullptr});
+}
+
+// close a socket used with the functions above, a plain close() leaves
+// it registered and a socket reusing the fd would never be woken up,
+// coroutines still waiting on it resume with the error of the closed fd
+inline void close(EventLoop& loop, SocketBase& sock) {
+    auto waiters = detail::unwatch_(loop, sock.get());
+    sock.close();
+    if (waiters) {
+        detail::resume_(waiters->reader);
+        detail::resume_(waiters->writer);
+    }
+}
+
+} // namespace nano
+
+#endif // __cpp_impl_coroutine
 
 #endif // __NANONET__
@@ -25,82 +25,86 @@
  */
 
 #include "Addr.h"
+#include "Resolver.h"
+
+// C++
+#include <type_traits>
 
 namespace nano {
 
 namespace {
 
-// convert C string to addr_t
-inline addr_t parse_(const char* addr) {
-    if (is_valid_ipv4(addr)) {
-        return inet_addr(addr);
-    } else {
-        try {
-            return dns_query_single(addr);
-        } catch (const NanoExcept& ne) {
-            throw_except("[Addr] ", ne.what());
-        }
-    }
-    return 0; // never
+// convert string to Addr, host names go through the resolver cache and
+// prefer IPv4 when both families are known
+inline Addr parse_(std::string_view addr) {
+    addr_t value = 0;
+    if (parse_ipv4(addr, value)) return Addr(addr_ntoh(value));
+    uint8_t bytes[16] = {};
+    if (parse_ipv6(addr, bytes)) return Addr(bytes);
+    std::vector<Addr> addrs;
+    int error = Resolver::global().resolve(addr, addrs);
+    assert_throw_nanoexcept(error == 0,
+        "[Addr] ", Resolver::error_string(error));
+    for (const Addr& result : addrs)
+        if (result.is_ipv4()) return result;
+    return addrs.front();
 }
 
 } // anonymous namespace
 
+static_assert(std::is_trivially_copyable_v<Addr>
+    && sizeof(Addr) == 16, "Addr must stay a plain value");
+
 // constructor
-Addr::Addr(addr_t val) noexcept : val_(addr_hton(val)) {}
+Addr::Addr(const in6_addr& addr) noexcept {
+    std::memcpy(val_, &addr, sizeof(val_));
+}
 
-Addr::Addr(std::string_view addr) : val_(parse_(addr.data())) {}
+Addr::Addr(std::string_view addr) : Addr(parse_(addr)) {}
 
 // assign
-Addr& Addr::operator=(addr_t other) noexcept {
-    this->val_ = addr_hton(other);
-    return *this;
-}
-
 Addr& Addr::operator=(std::string_view addr) {
-    this->val_ = parse_(addr.data());
-    return *this;
-}
-
-bool Addr::operator==(addr_t other) const noexcept {
-    return this->val_ == addr_hton(other);
+    return *this = parse_(addr);
 }
 
 bool Addr::operator==(std::string_view other) const {
     try {
-        return val_ == parse_(other.data());
+        return *this == parse_(other);
     } catch (...) {
         return false;
     }
 }
 
-bool Addr::operator!=(addr_t other) const noexcept {
-    return this->val_ != addr_hton(other);
-}
-
 bool Addr::operator!=(std::string_view other) const {
     try {
-        return val_ != parse_(other.data());
+        return *this != parse_(other);
     } catch (...) {
         return true;
     }
 }
 
-// setter & getter
-addr_t Addr::get(bool net_order) const noexcept {
-    return net_order ? this->val_ : addr_ntoh(this->val_);
+// IPv6
+in6_addr Addr::get6() const noexcept {
+    in6_addr addr;
+    std::memcpy(&addr, val_, sizeof(val_));
+    return addr;
 }
 
-void Addr::set(addr_t val) noexcept {
-    this->val_ = addr_hton(val);
+void Addr::set6(const in6_addr& addr) noexcept {
+    std::memcpy(val_, &addr, sizeof(val_));
 }
 
 // to string
 std::string Addr::to_string() const noexcept {
+    if (this->is_ipv6()) {
+        char buf[INET6_ADDRSTRLEN] = {};
+        ::inet_ntop(AF_INET6, val_, buf, sizeof(buf));
+        return buf;
+    }
     try {
-        return addr_ntos(this->val_);
+        return addr_ntos(val_[3]);
     } catch (const NanoExcept& e) {
-        throw_except("[Addr] ", e.what());
+        throw_except("[Addr] ", e);
     }
     return std::string(); // never
 }
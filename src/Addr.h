@@ -32,6 +32,7 @@
 #include <cstring>
 
 // C++
+#include <functional>
 #include <string>
 #include <string_view>
 
@@ -42,41 +43,145 @@ namespace nano {
 
 class Addr {
 
-    // net byte order addr (ipv4)
-    addr_t val_;
+    friend struct std::hash<Addr>;
+
+    // the mapped prefix of IPv4 addresses, ::ffff:0:0/96
+    static constexpr uint32_t MAPPED = static_cast<uint32_t>(addr_hton(0xFFFF));
+
+    // net byte order, IPv4 is kept as an IPv4-mapped IPv6 address so
+    // that both families fit 16 bytes
+    uint32_t val_[4];
 
 public:
 
-    // ctor & dtor
-    Addr(addr_t val = 0) noexcept;
+    // ctor & dtor, trivially copyable so it packs into flat tables
+    constexpr Addr(addr_t val = 0) noexcept
+        : val_{0, 0, MAPPED, static_cast<uint32_t>(addr_hton(val))} {}
+    explicit constexpr Addr(const uint8_t (&bytes)[16]) noexcept
+        : val_{word_(bytes, 0), word_(bytes, 4), word_(bytes, 8),
+        word_(bytes, 12)} {}
+    explicit Addr(const in6_addr& addr) noexcept;
     Addr(std::string_view addr);
 
     Addr(const Addr&) = default;
     Addr(Addr&&) = default;
-    virtual ~Addr() = default;
+    ~Addr() = default;
 
     // assignment
     Addr& operator=(const Addr&) = default;
     Addr& operator=(Addr&&) = default;
 
-    Addr& operator=(addr_t other) noexcept;
+    constexpr Addr& operator=(addr_t other) noexcept {
+        return *this = Addr(other);
+    }
     Addr& operator=(std::string_view addr);
 
-    bool operator==(addr_t other) const noexcept;
+    constexpr bool operator==(addr_t other) const noexcept {
+        return *this == Addr(other);
+    }
     bool operator==(std::string_view other) const;
 
-    bool operator!=(addr_t other) const noexcept;
+    constexpr bool operator!=(addr_t other) const noexcept {
+        return !(*this == Addr(other));
+    }
     bool operator!=(std::string_view other) const;
 
-    // setter & getter
-    addr_t get(bool net_order = true) const noexcept;
-    void set(addr_t val) noexcept;
+    // compare & order by the numeric value of the 128-bit address, IPv4
+    // counts as ::ffff:a.b.c.d, after ::1 and before 2000::
+    friend constexpr bool operator==(const Addr& a, const Addr& b) noexcept {
+        return a.val_[0] == b.val_[0] && a.val_[1] == b.val_[1]
+            && a.val_[2] == b.val_[2] && a.val_[3] == b.val_[3];
+    }
+    friend constexpr bool operator!=(const Addr& a, const Addr& b) noexcept {
+        return !(a == b);
+    }
+    friend constexpr bool operator<(const Addr& a, const Addr& b) noexcept {
+        for (int i = 0; i < 4; ++i) {
+            if (a.val_[i] != b.val_[i])
+                return addr_ntoh(a.val_[i]) < addr_ntoh(b.val_[i]);
+        }
+        return false;
+    }
+    friend constexpr bool operator>(const Addr& a, const Addr& b) noexcept {
+        return b < a;
+    }
+    friend constexpr bool operator<=(const Addr& a, const Addr& b) noexcept {
+        return !(b < a);
+    }
+    friend constexpr bool operator>=(const Addr& a, const Addr& b) noexcept {
+        return !(a < b);
+    }
+
+    // dotted-decimal or IPv6, never resolves a host name, usable at compile
+    // time for literals
+    static constexpr Addr parse(std::string_view addr) {
+        addr_t ipv4 = 0;
+        if (parse_ipv4(addr, ipv4)) return Addr(addr_ntoh(ipv4));
+        uint8_t bytes[16] = {};
+        if (!parse_ipv6(addr, bytes))
+            throw NanoExcept("[Addr] parse(): \'" + std::string(addr)
+                + "\' is not an IPv4 or IPv6 address");
+        return Addr(bytes);
+    }
+
+    // family
+    constexpr bool is_ipv4() const noexcept {
+        return val_[0] == 0 && val_[1] == 0 && val_[2] == MAPPED;
+    }
+    constexpr bool is_ipv6() const noexcept {
+        return !this->is_ipv4();
+    }
+    constexpr int family() const noexcept {
+        return this->is_ipv4() ? AF_INET : AF_INET6;
+    }
+
+    // 0.0.0.0 or ::
+    constexpr bool is_unspecified() const noexcept {
+        return val_[0] == 0 && val_[1] == 0
+            && (val_[2] == 0 || val_[2] == MAPPED) && val_[3] == 0;
+    }
+
+    // setter & getter of the IPv4 address, get() is only meaningful if
+    // is_ipv4(), for IPv6 it returns the low 32 bits
+    constexpr addr_t get(bool net_order = true) const noexcept {
+        return net_order ? val_[3] : addr_ntoh(val_[3]);
+    }
+    constexpr void set(addr_t val) noexcept {
+        *this = Addr(val);
+    }
+
+    // the IPv6 address, IPv4 is mapped
+    in6_addr get6() const noexcept;
+    void set6(const in6_addr& addr) noexcept;
 
     // to string
     std::string to_string() const noexcept;
 
+private:
+    static constexpr uint32_t word_(const uint8_t (&bytes)[16], int i) {
+        return static_cast<uint32_t>(addr_hton(static_cast<addr_t>(
+            (static_cast<uint32_t>(bytes[i]) << 24)
+            | (static_cast<uint32_t>(bytes[i + 1]) << 16)
+            | (static_cast<uint32_t>(bytes[i + 2]) << 8) | bytes[i + 3])));
+    }
+
 };  // class Addr
 
 }  // namespace nano
 
+namespace std {
+
+template <>
+struct hash<::nano::Addr> {
+    size_t operator()(const ::nano::Addr& addr) const noexcept {
+        uint64_t high = (static_cast<uint64_t>(addr.val_[0]) << 32)
+            | addr.val_[1];
+        uint64_t low = (static_cast<uint64_t>(addr.val_[2]) << 32)
+            | addr.val_[3];
+        return hash<uint64_t>()((high * 0x9E3779B97F4A7C15ULL) ^ low);
+    }
+};
+
+} // namespace std
+
 #endif  // NANONET_ADDR_H
@@ -26,50 +26,80 @@
 
 #include "AddrPort.h"
 
+// C++
+#include <type_traits>
+
 namespace nano {
 
 namespace {
 
-// convert C string to Addr/Port
-inline void parse_(const char* str, char separator, Addr& addr, Port& port) {
-    const char* p = str;
-    for (; *p && *p != ':'; ++p);
-    assert_throw_nanoexcept(*p == ':',
+// convert string to Addr/Port, numeric addresses take the fast path
+inline void parse_(std::string_view str, char separator,
+        Addr& addr, Port& port) {
+    addr_t addr_value = 0;
+    port_t port_value = 0;
+    if (parse_addrport(str, addr_value, port_value, separator)) {
+        addr = Addr(addr_ntoh(addr_value));
+        port = Port(port_ntoh(port_value));
+        return;
+    }
+    size_t pos = str.rfind(separator);
+    assert_throw_nanoexcept(pos != std::string_view::npos,
         "[AddrPort] AddrPort(): Cannot be constructed from the string \'",
-        str, "\'");
-    addr = std::string(str, p - str);
-    port = p + 1;
+        std::string(str), "\'");
+    // [ipv6]:port
+    std::string_view host = str.substr(0, pos);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+        host = host.substr(1, host.size() - 2);
+    addr = host;
+    port = str.substr(pos + 1);
 }
 
 } // anonymous namespace
 
-// constructor
-AddrPort::AddrPort(const Addr& addr, const Port& port) noexcept
-    : addr_(addr), port_(port) {}
+static_assert(std::is_trivially_copyable_v<AddrPort>
+    && sizeof(AddrPort) == 20, "AddrPort must stay a plain value");
 
+// constructor
 AddrPort::AddrPort(std::string_view addrport, char separator) {
-    parse_(addrport.data(), separator, this->addr_, this->port_);
-}
-
-// getter & setter
-void AddrPort::addr(const Addr& addr) noexcept {
-    this->addr_ = addr;
-}
-
-Addr AddrPort::addr() const noexcept {
-    return this->addr_;
+    parse_(addrport, separator, this->addr_, this->port_);
 }
 
-void AddrPort::port(const Port& port) noexcept {
-    this->port_ = port;
+// socket address
+socklen_t AddrPort::to_sockaddr(sockaddr_storage& addr,
+        int family) const noexcept {
+    if (family == AF_INET6 || (family != AF_INET && addr_.is_ipv6())) {
+        sockaddr_in6& sa = reinterpret_cast<sockaddr_in6&>(addr);
+        sa = sockaddr_in6{};
+        sa.sin6_family = AF_INET6;
+        sa.sin6_addr = addr_.get6();
+        sa.sin6_port = port_.get();
+        return sizeof(sa);
+    }
+    if (addr_.is_ipv6()) return 0;
+    sockaddr_in& sa = reinterpret_cast<sockaddr_in&>(addr);
+    sa = sockaddr_in{};
+    make_sockaddr4(&sa, addr_.get(), port_.get());
+    return sizeof(sa);
 }
 
-Port AddrPort::port() const noexcept {
-    return this->port_;
+AddrPort AddrPort::from_sockaddr(const sockaddr_storage& addr) noexcept {
+    if (addr.ss_family == AF_INET6) {
+        const sockaddr_in6& sa = reinterpret_cast<const sockaddr_in6&>(addr);
+        return AddrPort(Addr(sa.sin6_addr), Port(port_ntoh(sa.sin6_port)));
+    }
+    if (addr.ss_family == AF_INET) {
+        const sockaddr_in& sa = reinterpret_cast<const sockaddr_in&>(addr);
+        return AddrPort(Addr(addr_ntoh(sa.sin_addr.s_addr)),
+            Port(port_ntoh(sa.sin_port)));
+    }
+    return AddrPort();
 }
 
 // to string
 std::string AddrPort::to_string(char separator) const noexcept {
+    if (addr_.is_ipv6())
+        return '[' + addr_.to_string() + ']' + separator + port_.to_string();
     return this->addr_.to_string() + separator + this->port_.to_string();
 }
 
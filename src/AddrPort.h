@@ -41,31 +41,104 @@ class AddrPort {
 
 public:
 
-    // ctor & dtor
-    AddrPort() = default;
-    AddrPort(const Addr& addr, const Port& port) noexcept;
+    // ctor & dtor, trivially copyable so it packs into flat tables
+    constexpr AddrPort() noexcept = default;
+    constexpr AddrPort(const Addr& addr, const Port& port) noexcept
+        : addr_(addr), port_(port) {}
     AddrPort(std::string_view addrport, char separator = ':');
 
     AddrPort(const AddrPort&) = default;
     AddrPort(AddrPort&&) = default;
-    virtual ~AddrPort() = default;
+    ~AddrPort() = default;
 
     // assignment
     AddrPort& operator=(const AddrPort&) = default;
     AddrPort& operator=(AddrPort&&) = default;
 
+    // "a.b.c.d:port" or "[ipv6]:port", never resolves a host name, usable
+    // at compile time for literals
+    static constexpr AddrPort parse(std::string_view addrport,
+            char separator = ':') {
+        addr_t addr = 0;
+        port_t port = 0;
+        if (parse_addrport(addrport, addr, port, separator))
+            return AddrPort(Addr(addr_ntoh(addr)), Port(port_ntoh(port)));
+        size_t close = addrport.find(']');
+        uint8_t bytes[16] = {};
+        if (addrport.size() > 0 && addrport[0] == '['
+                && close != std::string_view::npos
+                && close + 1 < addrport.size()
+                && addrport[close + 1] == separator
+                && parse_ipv6(addrport.substr(1, close - 1), bytes)
+                && parse_port(addrport.substr(close + 2), port))
+            return AddrPort(Addr(bytes), Port(port_ntoh(port)));
+        throw NanoExcept("[AddrPort] parse(): \'" + std::string(addrport)
+            + "\' is not an address and port");
+    }
+
+    // compare & order by address, then port
+    friend constexpr bool operator==(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return a.addr_ == b.addr_ && a.port_ == b.port_;
+    }
+    friend constexpr bool operator!=(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return !(a == b);
+    }
+    friend constexpr bool operator<(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return a.addr_ < b.addr_ || (a.addr_ == b.addr_ && a.port_ < b.port_);
+    }
+    friend constexpr bool operator>(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return b < a;
+    }
+    friend constexpr bool operator<=(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return !(b < a);
+    }
+    friend constexpr bool operator>=(const AddrPort& a,
+            const AddrPort& b) noexcept {
+        return !(a < b);
+    }
+
     // getter & setter
-    Addr addr() const noexcept;
-    void addr(const Addr& addr) noexcept;
+    constexpr Addr addr() const noexcept { return addr_; }
+    constexpr void addr(const Addr& addr) noexcept { addr_ = addr; }
+
+    constexpr Port port() const noexcept { return port_; }
+    constexpr void port(const Port& port) noexcept { port_ = port; }
 
-    Port port() const noexcept;
-    void port(const Port& port) noexcept;
+    // socket address for a socket of the family, IPv4 is mapped on IPv6
+    // sockets, returns the length, or 0 if an IPv6 address does not fit
+    socklen_t to_sockaddr(sockaddr_storage& addr,
+        int family = AF_UNSPEC) const noexcept;
+    static AddrPort from_sockaddr(const sockaddr_storage& addr) noexcept;
 
-    // to string
+    // to string, IPv6 addresses are enclosed in brackets
     std::string to_string(char separator = ':') const noexcept;
 
 }; // class AddrPort
 
 } // namespace nano
 
+namespace std {
+
+template <>
+struct hash<::nano::AddrPort> {
+    // mixed so that neighbouring hosts and ports spread over the buckets
+    // of power-of-two tables
+    size_t operator()(const ::nano::AddrPort& addrport) const noexcept {
+        uint64_t key = (static_cast<uint64_t>(
+            hash<::nano::Addr>()(addrport.addr())) << 16)
+            ^ addrport.port().get();
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+};
+
+} // namespace std
+
 #endif // NANONET_ADDR_PORT_H
@@ -0,0 +1,242 @@
+// File:     src/ConnectionPool.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ConnectionPool.h"
+
+// C++
+#include <algorithm>
+#include <climits>
+
+namespace nano {
+
+namespace {
+
+// nothing to read and not closed, a pooled connection must be quiet
+inline bool alive_(const Socket& sock) noexcept {
+    char c;
+#ifdef NANO_LINUX
+    IoResult ret = try_recv_msg(sock.get(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+#elif NANO_WINDOWS
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(sock.get(), &set);
+    timeval zero = {0, 0};
+    if (::select(0, &set, nullptr, nullptr, &zero) == 0) return true;
+    IoResult ret = try_recv_msg(sock.get(), &c, 1, MSG_PEEK);
+#endif
+    return ret.would_block();
+}
+
+} // anonymous namespace
+
+// lease
+ConnectionPool::Lease::Lease(ConnectionPool* pool, const AddrPort& remote,
+        Socket&& sock) : pool_(pool), remote_(remote),
+        sock_(std::move(sock)) {}
+
+ConnectionPool::Lease::Lease() noexcept : pool_(nullptr), sock_(false) {}
+
+ConnectionPool::Lease::~Lease() {
+    this->release(false);
+}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), remote_(other.remote_),
+    sock_(std::move(other.sock_)) {
+    other.pool_ = nullptr;
+}
+
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(
+        Lease&& other) noexcept {
+    if (this != &other) {
+        this->release(false);
+        pool_ = other.pool_;
+        remote_ = other.remote_;
+        sock_ = std::move(other.sock_);
+        other.pool_ = nullptr;
+    }
+    return *this;
+}
+
+void ConnectionPool::Lease::release(bool reusable) noexcept {
+    if (!pool_) return;
+    pool_->release_(remote_, std::move(sock_), reusable);
+    pool_ = nullptr;
+}
+
+Socket& ConnectionPool::Lease::socket() noexcept {
+    return sock_;
+}
+
+Socket* ConnectionPool::Lease::operator->() noexcept {
+    return &sock_;
+}
+
+ConnectionPool::Lease::operator bool() const noexcept {
+    return pool_ != nullptr;
+}
+
+// constructor
+ConnectionPool::ConnectionPool(size_t max_per_host,
+        std::chrono::milliseconds max_idle)
+    : max_per_host_(max_per_host > 0 ? max_per_host : 1),
+    max_idle_(max_idle) {}
+
+ConnectionPool::~ConnectionPool() {
+    this->clear();
+}
+
+// get a connection
+ConnectionPool::Lease ConnectionPool::acquire(const AddrPort& remote,
+        std::chrono::milliseconds timeout) {
+    // the wait and the connect share the timeout
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(mutex_);
+    // looked up again after every wakeup, the entry may be gone meanwhile
+    auto ready = [&remote, this] {
+        return hosts_[remote].active < max_per_host_;
+    };
+    if (timeout.count() < 0) {
+        cond_.wait(lock, ready);
+    } else if (!cond_.wait_until(lock, deadline, ready)) {
+        this->erase_unused_(remote);
+        throw_except("[ConnectionPool] acquire(): Timed out waiting for a "
+            "connection to ", remote.to_string());
+    }
+    // stays while it has an active connection
+    Host& host = hosts_[remote];
+    ++host.active;
+    // reuse the warmest connection
+    auto now = std::chrono::steady_clock::now();
+    while (!host.idle.empty()) {
+        Idle idle = std::move(host.idle.back());
+        host.idle.pop_back();
+        if (now - idle.since <= max_idle_ && alive_(idle.sock))
+            return Lease(this, remote, std::move(idle.sock));
+        idle.sock.close();
+    }
+    lock.unlock();
+    try {
+        Socket sock(static_cast<Domain>(remote.addr().family()));
+        try {
+            if (timeout.count() < 0) {
+                sock.connect(remote.addr(), remote.port());
+            } else {
+                // at least 1 ms, or the connect could not even start
+                auto left = std::chrono::ceil<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now());
+                sock.connect(remote.addr(), remote.port(),
+                    static_cast<int>(std::clamp<long long>(left.count(),
+                        1, INT_MAX)));
+            }
+        } catch (const NanoExcept&) {
+            sock.close();
+            throw;
+        }
+        return Lease(this, remote, std::move(sock));
+    } catch (const NanoExcept&) {
+        lock.lock();
+        --host.active;
+        this->erase_unused_(remote);
+        cond_.notify_all();
+        throw;
+    }
+}
+
+// give a connection back to the entry it was leased from
+void ConnectionPool::release_(const AddrPort& remote, Socket&& sock,
+        bool reusable) noexcept {
+    Socket released(std::move(sock));
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(remote);
+    if (it == hosts_.end()) {
+        released.close();
+        return;
+    }
+    Host& host = it->second;
+    if (host.active > 0) --host.active;
+    if (reusable && released.is_open() && host.idle.size() < max_per_host_) {
+        host.idle.push_back(Idle{std::move(released),
+            std::chrono::steady_clock::now()});
+    } else {
+        released.close();
+        this->erase_unused_(remote);
+    }
+    cond_.notify_all();
+}
+
+// drop the entry of remote if nothing refers to it, a waiter in acquire()
+// creates it again
+void ConnectionPool::erase_unused_(const AddrPort& remote) noexcept {
+    auto it = hosts_.find(remote);
+    if (it != hosts_.end() && it->second.active == 0
+            && it->second.idle.empty())
+        hosts_.erase(it);
+}
+
+// eviction
+size_t ConnectionPool::evict_idle() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    size_t count = 0;
+    for (auto it = hosts_.begin(); it != hosts_.end();) {
+        Host& host = it->second;
+        while (!host.idle.empty() && now - host.idle.front().since > max_idle_) {
+            host.idle.front().sock.close();
+            host.idle.pop_front();
+            ++count;
+        }
+        if (host.active == 0 && host.idle.empty()) it = hosts_.erase(it);
+        else ++it;
+    }
+    return count;
+}
+
+void ConnectionPool::clear() noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = hosts_.begin(); it != hosts_.end();) {
+        Host& host = it->second;
+        for (Idle& idle : host.idle) idle.sock.close();
+        host.idle.clear();
+        if (host.active == 0) it = hosts_.erase(it);
+        else ++it;
+    }
+}
+
+size_t ConnectionPool::idle_count() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (auto& [key, host] : hosts_) count += host.idle.size();
+    return count;
+}
+
+size_t ConnectionPool::active_count(const AddrPort& remote) const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = hosts_.find(remote);
+    return it == hosts_.end() ? 0 : it->second.active;
+}
+
+} // namespace nano
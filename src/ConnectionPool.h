@@ -0,0 +1,134 @@
+// File:     src/ConnectionPool.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_CONNECTION_POOL_H
+#define NANONET_CONNECTION_POOL_H
+
+// C++
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+// NanoNet
+#include "Socket.h"
+
+namespace nano {
+
+class ConnectionPool {
+public:
+
+    // a connection handed out by acquire(), it goes back to its pool entry
+    // with release() or is closed with the lease, which must not outlive
+    // the pool
+    class Lease {
+        friend class ConnectionPool;
+
+        ConnectionPool* pool_;
+        AddrPort remote_;
+        Socket sock_;
+
+        Lease(ConnectionPool* pool, const AddrPort& remote, Socket&& sock);
+
+    public:
+
+        // ctor & dtor, a connection still held is closed, it may be in the
+        // middle of a request
+        Lease() noexcept;
+        ~Lease();
+
+        // move
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+
+        // hand the connection back, it is closed unless reusable
+        void release(bool reusable = true) noexcept;
+
+        Socket& socket() noexcept;
+        Socket* operator->() noexcept;
+        explicit operator bool() const noexcept;
+
+    }; // class Lease
+
+private:
+
+    struct Idle {
+        Socket sock;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    // removed once it has neither idle nor active connections
+    struct Host {
+        std::deque<Idle> idle;  // oldest first
+        size_t active = 0;      // leased out by acquire()
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::unordered_map<AddrPort, Host> hosts_;
+
+    size_t max_per_host_;
+    std::chrono::milliseconds max_idle_;
+
+public:
+
+    // ctor & dtor, idle connections are closed with the pool
+    ConnectionPool(size_t max_per_host = 8,
+        std::chrono::milliseconds max_idle = std::chrono::seconds(60));
+    virtual ~ConnectionPool();
+
+    // uncopyable & unmovable
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // the most recently used healthy idle connection, or a new one, waits
+    // while max_per_host connections to remote are leased out, timeout
+    // bounds the wait and the connect together, a negative one waits
+    // forever
+    Lease acquire(const AddrPort& remote,
+        std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
+    // close connections idle for longer than max_idle, returns the number
+    size_t evict_idle();
+
+    // close every idle connection
+    void clear() noexcept;
+
+    size_t idle_count() const noexcept;
+    size_t active_count(const AddrPort& remote) const noexcept;
+
+private:
+    void release_(const AddrPort& remote, Socket&& sock,
+        bool reusable) noexcept;
+    void erase_unused_(const AddrPort& remote) noexcept;
+
+}; // class ConnectionPool
+
+} // namespace nano
+
+#endif // NANONET_CONNECTION_POOL_H
@@ -0,0 +1,515 @@
+// File:     src/Coroutine.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_COROUTINE_H
+#define NANONET_COROUTINE_H
+
+// NanoNet
+#include "EventLoop.h"
+#include "ServerSocket.h"
+#include "UdpSocket.h"
+
+// C++20 only, the rest of NanoNet stays C++17
+#if defined(NANO_LINUX) && defined(__cpp_impl_coroutine) \
+    && __has_include(<coroutine>)
+
+#define NANO_COROUTINE 1
+
+// C++
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nano {
+
+template <class T = void>
+class Task;
+
+namespace detail {
+
+// recycles coroutine frames by size class, per thread
+class FramePool {
+
+    static constexpr size_t GRANULE = 64;
+    static constexpr size_t CLASSES = 64;
+    static constexpr size_t CAPACITY = 1024;
+
+    struct Block {
+        Block* next;
+    };
+
+    Block* free_[CLASSES] = {};
+    size_t count_[CLASSES] = {};
+
+public:
+
+    ~FramePool() {
+        for (Block* block : free_) {
+            while (block) {
+                Block* next = block->next;
+                ::operator delete(block);
+                block = next;
+            }
+        }
+    }
+
+    void* allocate(size_t size) {
+        size_t index = (size + GRANULE - 1) / GRANULE;
+        if (index == 0 || index > CLASSES) return ::operator new(size);
+        Block*& head = free_[index - 1];
+        if (head == nullptr) return ::operator new(index * GRANULE);
+        Block* block = head;
+        head = block->next;
+        --count_[index - 1];
+        return block;
+    }
+
+    void deallocate(void* ptr, size_t size) noexcept {
+        size_t index = (size + GRANULE - 1) / GRANULE;
+        if (index == 0 || index > CLASSES || count_[index - 1] == CAPACITY) {
+            ::operator delete(ptr);
+            return;
+        }
+        Block* block = static_cast<Block*>(ptr);
+        block->next = free_[index - 1];
+        free_[index - 1] = block;
+        ++count_[index - 1];
+    }
+
+    static FramePool& local() noexcept {
+        thread_local FramePool pool;
+        return pool;
+    }
+
+}; // class FramePool
+
+struct PromiseBase {
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+    bool detached = false;
+
+    static void* operator new(size_t size) {
+        return FramePool::local().allocate(size);
+    }
+
+    static void operator delete(void* ptr, size_t size) noexcept {
+        FramePool::local().deallocate(ptr, size);
+    }
+
+    // resume the awaiting coroutine, or free a detached frame
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<Promise> handle) noexcept {
+            PromiseBase& promise = handle.promise();
+            if (promise.detached) {
+                // like std::thread, nobody can see the exception
+                if (promise.exception) std::terminate();
+                handle.destroy();
+                return std::noop_coroutine();
+            }
+            if (promise.continuation) return promise.continuation;
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() noexcept {
+        exception = std::current_exception();
+    }
+
+}; // struct PromiseBase
+
+template <class T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+
+    template <class U>
+    void return_value(U&& result) {
+        value.emplace(std::forward<U>(result));
+    }
+
+    T result() {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+}; // struct Promise
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() {
+        if (exception) std::rethrow_exception(exception);
+    }
+}; // struct Promise<void>
+
+// an operation waiting for its socket to become ready
+struct IoWaiter {
+    std::coroutine_handle<> handle;
+
+    // retry the operation, true if it is done
+    virtual bool try_complete() = 0;
+
+protected:
+    ~IoWaiter() = default;
+};
+
+struct IoWaiters {
+    IoWaiter* reader = nullptr;
+    IoWaiter* writer = nullptr;
+};
+
+inline void resume_(IoWaiter*& slot) {
+    IoWaiter* waiter = slot;
+    if (waiter == nullptr || !waiter->try_complete()) return;
+    slot = nullptr;
+    waiter->handle.resume();
+}
+
+using WatchRegistry = std::unordered_map<EventLoop*,
+    std::unordered_map<sock_t, std::shared_ptr<IoWaiters>>>;
+
+// the sockets watched by the coroutines of this thread, per loop
+inline WatchRegistry& registry_() noexcept {
+    thread_local WatchRegistry registry;
+    return registry;
+}
+
+// register a socket with the loop once, its callbacks resume the waiters
+inline std::shared_ptr<IoWaiters> watch_(EventLoop& loop, sock_t fd) {
+    auto& sockets = registry_()[&loop];
+    if (loop.contains(fd)) {
+        auto it = sockets.find(fd);
+        if (it == sockets.end()) {
+            throw NanoExcept("[Coroutine] Socket " + std::to_string(fd)
+                + " is registered with other callbacks");
+        }
+        return it->second;
+    }
+    auto waiters = std::make_shared<IoWaiters>();
+    loop.add(fd, EventLoop::READABLE | EventLoop::WRITABLE,
+        [waiters] { resume_(waiters->reader); },
+        [waiters] { resume_(waiters->writer); },
+        [waiters] {
+            resume_(waiters->reader);
+            resume_(waiters->writer);
+        });
+    sockets[fd] = waiters;
+    return waiters;
+}
+
+// forget a socket before its fd is closed and reused, returns its waiters
+inline std::shared_ptr<IoWaiters> unwatch_(EventLoop& loop,
+        sock_t fd) noexcept {
+    WatchRegistry& registry = registry_();
+    auto it = registry.find(&loop);
+    if (it == registry.end()) return nullptr;
+    auto found = it->second.find(fd);
+    if (found == it->second.end()) return nullptr;
+    std::shared_ptr<IoWaiters> waiters = std::move(found->second);
+    it->second.erase(found);
+    if (it->second.empty()) registry.erase(it);
+    loop.remove(fd);
+    return waiters;
+}
+
+// tries Op at once, and again each time the socket becomes ready
+template <class Op>
+class IoAwaiter : public IoWaiter {
+
+    EventLoop& loop_;
+    sock_t fd_;
+    bool write_;
+    Op op_;
+    std::shared_ptr<IoWaiters> waiters_;
+
+    IoWaiter*& slot_() noexcept {
+        return write_ ? waiters_->writer : waiters_->reader;
+    }
+
+public:
+
+    IoAwaiter(EventLoop& loop, sock_t fd, bool write, Op op)
+        : loop_(loop), fd_(fd), write_(write), op_(std::move(op)) {}
+
+    IoAwaiter(const IoAwaiter&) = delete;
+    IoAwaiter& operator=(const IoAwaiter&) = delete;
+
+    // the coroutine was destroyed while waiting
+    ~IoAwaiter() {
+        if (waiters_ && slot_() == this) slot_() = nullptr;
+    }
+
+    bool await_ready() {
+        // registering makes the socket non-blocking
+        waiters_ = watch_(loop_, fd_);
+        return op_();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) noexcept {
+        this->handle = handle;
+        slot_() = this;
+    }
+
+    auto await_resume() {
+        return op_.result();
+    }
+
+    virtual bool try_complete() override {
+        return op_();
+    }
+
+}; // class IoAwaiter
+
+struct ReceiveOp {
+    TransSocket& sock;
+    char* buf;
+    size_t size;
+    IoResult ret;
+
+    bool operator()() noexcept {
+        ret = sock.try_receive(buf, size);
+        return !ret.would_block();
+    }
+
+    IoResult result() noexcept { return ret; }
+};
+
+struct SendOp {
+    TransSocket& sock;
+    const char* msg;
+    size_t length;
+    size_t sent;
+    IoResult ret;
+
+    bool operator()() noexcept {
+        while (sent < length) {
+            IoResult part = sock.try_send(msg + sent, length - sent);
+            if (part.would_block()) return false;
+            if (!part) {
+                ret = IoResult{static_cast<int>(sent), part.error};
+                return true;
+            }
+            sent += static_cast<size_t>(part.bytes);
+        }
+        ret = IoResult{static_cast<int>(sent), 0};
+        return true;
+    }
+
+    IoResult result() noexcept { return ret; }
+};
+
+struct ReceiveFromOp {
+    UdpSocket& sock;
+    char* buf;
+    size_t size;
+    AddrPort& from;
+    IoResult ret;
+
+    bool operator()() noexcept {
+        ret = sock.try_receive_from(buf, size, from);
+        return !ret.would_block();
+    }
+
+    IoResult result() noexcept { return ret; }
+};
+
+struct AcceptOp {
+    ServerSocket& server;
+    std::vector<Socket> sockets;
+    std::exception_ptr exception;
+
+    bool operator()() noexcept {
+        try {
+            return server.accept_batch(sockets, 1) > 0;
+        } catch (...) {
+            exception = std::current_exception();
+            return true;
+        }
+    }
+
+    Socket result() {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(sockets.front());
+    }
+};
+
+} // namespace detail
+
+// lazily started coroutine, co_await it to run it
+template <class T>
+class Task {
+public:
+
+    using promise_type = detail::Promise<T>;
+
+private:
+
+    std::coroutine_handle<promise_type> handle_;
+
+public:
+
+    // ctor & dtor
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+        : handle_(handle) {}
+
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    // move
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    // uncopyable
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    bool done() const noexcept {
+        return !handle_ || handle_.done();
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{handle_};
+    }
+
+    // start a task nobody awaits, its frame is freed when it finishes
+    friend void spawn(Task<void>&& task);
+
+    // start the task and run the loop until it finishes
+    template <class U>
+    friend U sync_wait(EventLoop& loop, Task<U>&& task);
+
+}; // class Task
+
+namespace detail {
+
+template <class T>
+inline Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(
+        std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+inline void spawn(Task<void>&& task) {
+    auto handle = std::exchange(task.handle_, {});
+    if (!handle) return;
+    handle.promise().detached = true;
+    handle.resume();
+}
+
+template <class T>
+inline T sync_wait(EventLoop& loop, Task<T>&& task) {
+    task.handle_.resume();
+    while (!task.handle_.done()) loop.run_once();
+    return task.handle_.promise().result();
+}
+
+// receive once, IoResult as from TransSocket::try_receive()
+inline auto async_receive(EventLoop& loop, TransSocket& sock,
+        char* buf, size_t size) {
+    return detail::IoAwaiter<detail::ReceiveOp>(loop, sock.get(), false,
+        detail::ReceiveOp{sock, buf, size, IoResult{0, 0}});
+}
+
+// send every byte, or stop at the first error
+inline auto async_send(EventLoop& loop, TransSocket& sock,
+        const char* msg, size_t length) {
+    return detail::IoAwaiter<detail::SendOp>(loop, sock.get(), true,
+        detail::SendOp{sock, msg, length, 0, IoResult{0, 0}});
+}
+
+inline auto async_receive_from(EventLoop& loop, UdpSocket& sock,
+        char* buf, size_t size, AddrPort& from) {
+    return detail::IoAwaiter<detail::ReceiveFromOp>(loop, sock.get(), false,
+        detail::ReceiveFromOp{sock, buf, size, from, IoResult{0, 0}});
+}
+
+// the accepted socket is non-blocking, errors are thrown as by accept()
+inline auto async_accept(EventLoop& loop, ServerSocket& server) {
+    return detail::IoAwaiter<detail::AcceptOp>(loop, server.get(), false,
+        detail::AcceptOp{server, {}, nullptr});
+}
+
+// close a socket used with the functions above, a plain close() leaves
+// it registered and a socket reusing the fd would never be woken up,
+// coroutines still waiting on it resume with the error of the closed fd
+inline void close(EventLoop& loop, SocketBase& sock) {
+    auto waiters = detail::unwatch_(loop, sock.get());
+    sock.close();
+    if (waiters) {
+        detail::resume_(waiters->reader);
+        detail::resume_(waiters->writer);
+    }
+}
+
+} // namespace nano
+
+#endif // __cpp_impl_coroutine
+
+#endif // NANONET_COROUTINE_H
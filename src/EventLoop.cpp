@@ -0,0 +1,271 @@
+// File:     src/EventLoop.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "EventLoop.h"
+
+#ifdef NANO_LINUX
+
+namespace nano {
+
+// constructor
+EventLoop::EventLoop(int max_events, size_t post_capacity)
+        : epfd_(::epoll_create1(EPOLL_CLOEXEC)), running_(false),
+        wakeup_fd_(-1), posted_(post_capacity), idle_(false),
+        events_(max_events > 0 ? max_events : 1) {
+    assert_throw_nanoexcept(epfd_ != -1,
+        "[EventLoop] epoll_create1(): ", LAST_ERROR);
+    wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    if (wakeup_fd_ == -1
+            || ::epoll_ctl(epfd_, EPOLL_CTL_ADD, wakeup_fd_, &ev) != 0) {
+        SysError error = LAST_ERROR;
+        if (wakeup_fd_ != -1) ::close(wakeup_fd_);
+        ::close(epfd_);
+        throw_except("[EventLoop] eventfd(): ", error);
+    }
+}
+
+EventLoop::~EventLoop() {
+    ::close(wakeup_fd_);
+    ::close(epfd_);
+}
+
+// register a socket
+void EventLoop::add(sock_t fd, uint32_t events, Callback on_read,
+        Callback on_write, Callback on_error) {
+    assert_throw_nanoexcept(fd != INVALID_SOCKET,
+        "[EventLoop] add(): Socket is closed");
+    auto it = handlers_.find(fd);
+    // a socket added by once_writable() alone is taken over
+    Callback once;
+    if (it != handlers_.end() && it->second->temporary) {
+        once = std::move(it->second->on_writable_once);
+        this->remove(fd);
+        it = handlers_.end();
+    }
+    assert_throw_nanoexcept(it == handlers_.end(),
+        "[EventLoop] add(): Socket ", std::to_string(fd),
+        " is already registered");
+    assert_throw_nanoexcept(nano::set_blocking(fd, false),
+        "[EventLoop] add(): ", LAST_ERROR);
+
+    auto handler = std::make_unique<Handler>(Handler{fd, events,
+        std::move(on_read), std::move(on_write), std::move(on_error),
+        std::move(once), false});
+    epoll_event ev {};
+    ev.events = events | EPOLLET | EPOLLRDHUP
+        | (handler->on_writable_once ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.ptr = handler.get();
+    assert_throw_nanoexcept(0 == ::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev),
+        "[EventLoop] add(): ", LAST_ERROR);
+    handlers_.emplace(fd, std::move(handler));
+}
+
+void EventLoop::add(const SocketBase& sock, uint32_t events,
+        Callback on_read, Callback on_write, Callback on_error) {
+    this->add(sock.get(), events, std::move(on_read),
+        std::move(on_write), std::move(on_error));
+}
+
+// change the events of interest
+void EventLoop::modify(sock_t fd, uint32_t events) {
+    auto it = handlers_.find(fd);
+    assert_throw_nanoexcept(it != handlers_.end(),
+        "[EventLoop] modify(): Socket ", std::to_string(fd),
+        " is not registered");
+    it->second->events = events;
+    assert_throw_nanoexcept(this->update_(*it->second),
+        "[EventLoop] modify(): ", LAST_ERROR);
+}
+
+void EventLoop::modify(const SocketBase& sock, uint32_t events) {
+    this->modify(sock.get(), events);
+}
+
+// unregister a socket
+void EventLoop::remove(sock_t fd) noexcept {
+    auto it = handlers_.find(fd);
+    if (it == handlers_.end()) return;
+    ::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+    // the ready list of the current iteration may still point to it
+    it->second->fd = INVALID_SOCKET;
+    removed_.push_back(std::move(it->second));
+    handlers_.erase(it);
+}
+
+void EventLoop::remove(const SocketBase& sock) noexcept {
+    this->remove(sock.get());
+}
+
+bool EventLoop::contains(sock_t fd) const noexcept {
+    return handlers_.find(fd) != handlers_.end();
+}
+
+size_t EventLoop::size() const noexcept {
+    return handlers_.size();
+}
+
+// wait once and dispatch
+int EventLoop::run_once(int timeout_ms) {
+    // posters wake us up from here on, jobs posted before are seen below
+    idle_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!posted_.empty() || !deferred_.empty()) timeout_ms = 0;
+    int n = ::epoll_wait(epfd_, events_.data(),
+        static_cast<int>(events_.size()), timeout_ms);
+    idle_.store(false, std::memory_order_relaxed);
+    if (n < 0) {
+        assert_throw_nanoexcept(errno == EINTR,
+            "[EventLoop] epoll_wait(): ", LAST_ERROR);
+        return 0;
+    }
+    for (int i = 0; i < n; ++i) {
+        Handler* h = static_cast<Handler*>(events_[i].data.ptr);
+        uint32_t ev = events_[i].events;
+        if (h == nullptr) {
+            // woken up
+            eventfd_t value;
+            ::eventfd_read(wakeup_fd_, &value);
+            continue;
+        }
+        if (h->fd == INVALID_SOCKET) continue;
+        // writable or failed, ahead of the callbacks that may close it
+        if ((ev & (EPOLLOUT | EPOLLERR | EPOLLHUP)) && h->on_writable_once) {
+            Callback once = std::move(h->on_writable_once);
+            h->on_writable_once = nullptr;
+            if (h->temporary) this->remove(h->fd);
+            else if (!(h->events & WRITABLE)) this->update_(*h);
+            once();
+            if (h->fd == INVALID_SOCKET) continue;
+        }
+        // error & hang up
+        if ((ev & (EPOLLERR | EPOLLHUP)) && h->on_error) {
+            h->on_error();
+            continue;
+        }
+        // readable, peer closed or error without error callback
+        if ((ev & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) && h->on_read)
+            h->on_read();
+        // writable, unless the read callback removed it
+        if ((ev & EPOLLOUT) && h->fd != INVALID_SOCKET && h->on_write)
+            h->on_write();
+    }
+    removed_.clear();
+    this->run_posted_();
+    this->run_deferred_();
+    // the ready list was full, let it grow
+    if (n == static_cast<int>(events_.size()))
+        events_.resize(events_.size() * 2);
+    return n;
+}
+
+// dispatch until stop() is called
+void EventLoop::run() {
+    running_ = true;
+    while (running_) this->run_once();
+}
+
+void EventLoop::stop() noexcept {
+    running_ = false;
+    this->wakeup();
+}
+
+bool EventLoop::is_running() const noexcept {
+    return running_;
+}
+
+void EventLoop::wakeup() noexcept {
+    ::eventfd_write(wakeup_fd_, 1);
+}
+
+// post a job
+bool EventLoop::post(Job&& job) {
+    if (!posted_.try_push(std::move(job))) return false;
+    // pairs with the fence in run_once(), one of both sees the other
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idle_.exchange(false, std::memory_order_relaxed)) this->wakeup();
+    return true;
+}
+
+void EventLoop::defer(Callback callback) {
+    deferred_.push_back(std::move(callback));
+}
+
+// one-shot interest in EPOLLOUT on top of the events of the socket
+void EventLoop::once_writable(sock_t fd, Callback callback) {
+    auto it = handlers_.find(fd);
+    if (it == handlers_.end()) {
+        this->add(fd, 0, nullptr);
+        it = handlers_.find(fd);
+        it->second->temporary = true;
+    }
+    Handler& handler = *it->second;
+    bool armed = static_cast<bool>(handler.on_writable_once);
+    handler.on_writable_once = std::move(callback);
+    // re-arming the edge reports a socket that is writable already
+    assert_throw_nanoexcept(armed || this->update_(handler),
+        "[EventLoop] once_writable(): ", LAST_ERROR);
+}
+
+void EventLoop::once_writable(const SocketBase& sock, Callback callback) {
+    this->once_writable(sock.get(), std::move(callback));
+}
+
+// write the events of interest and the one-shot EPOLLOUT to epoll
+bool EventLoop::update_(Handler& handler) noexcept {
+    epoll_event ev {};
+    ev.events = handler.events | EPOLLET | EPOLLRDHUP
+        | (handler.on_writable_once ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.ptr = &handler;
+    return ::epoll_ctl(epfd_, EPOLL_CTL_MOD, handler.fd, &ev) == 0;
+}
+
+// run the jobs posted so far, a steady stream of posts cannot keep the
+// loop from polling
+void EventLoop::run_posted_() {
+    Job job;
+    for (size_t n = posted_.capacity(); n > 0 && posted_.try_pop(job); --n) {
+        job();
+        job = nullptr;
+    }
+}
+
+// callbacks deferred by these run in the next iteration
+void EventLoop::run_deferred_() {
+    if (deferred_.empty()) return;
+    std::vector<Callback> callbacks;
+    callbacks.swap(deferred_);
+    for (Callback& callback : callbacks) callback();
+    // keep the capacity for the next iteration
+    callbacks.clear();
+    if (deferred_.empty()) deferred_.swap(callbacks);
+}
+
+} // namespace nano
+
+#endif // NANO_LINUX
@@ -0,0 +1,164 @@
+// File:     src/EventLoop.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_EVENT_LOOP_H
+#define NANONET_EVENT_LOOP_H
+
+// C++
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// NanoNet
+#include "MpscQueue.h"
+#include "SocketBase.h"
+#include "UniqueFunction.h"
+
+#ifdef NANO_LINUX
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+namespace nano {
+
+class EventLoop {
+public:
+
+    // events of interest
+    enum Event : uint32_t {
+        READABLE = EPOLLIN,
+        WRITABLE = EPOLLOUT,
+    };
+
+    using Callback = std::function<void()>;
+
+    // work posted from other threads, may own sockets
+    using Job = UniqueFunction<void()>;
+
+private:
+
+    struct Handler {
+        sock_t fd;
+        uint32_t events;
+        Callback on_read;
+        Callback on_write;
+        Callback on_error;
+        // once_writable(), and whether only it registered the socket
+        Callback on_writable_once;
+        bool temporary;
+    };
+
+    // epoll instance
+    int epfd_;
+    std::atomic<bool> running_;
+
+    // eventfd to interrupt a blocking wait
+    int wakeup_fd_;
+
+    // posted jobs, posters write the eventfd only if the loop is idle, so
+    // a burst of posts costs one wakeup
+    MpscQueue<Job> posted_;
+    std::atomic<bool> idle_;
+
+    // run once the current iteration is done
+    std::vector<Callback> deferred_;
+
+    // ready list of a single wait
+    std::vector<epoll_event> events_;
+
+    // registered handlers, and handlers removed while dispatching
+    std::unordered_map<sock_t, std::unique_ptr<Handler>> handlers_;
+    std::vector<std::unique_ptr<Handler>> removed_;
+
+public:
+
+    // ctor & dtor
+    EventLoop(int max_events = 256, size_t post_capacity = 1024);
+    virtual ~EventLoop();
+
+    // uncopyable & unmovable
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // register a socket (switched to non-blocking, edge-triggered)
+    void add(sock_t fd, uint32_t events, Callback on_read,
+        Callback on_write = nullptr, Callback on_error = nullptr);
+    void add(const SocketBase& sock, uint32_t events, Callback on_read,
+        Callback on_write = nullptr, Callback on_error = nullptr);
+
+    // change the events of interest
+    void modify(sock_t fd, uint32_t events);
+    void modify(const SocketBase& sock, uint32_t events);
+
+    // unregister a socket
+    void remove(sock_t fd) noexcept;
+    void remove(const SocketBase& sock) noexcept;
+
+    bool contains(sock_t fd) const noexcept;
+    size_t size() const noexcept;
+
+    // wait once and dispatch, returns the number of ready sockets
+    int run_once(int timeout_ms = -1);
+
+    // dispatch until stop() is called
+    void run();
+    void stop() noexcept;
+    bool is_running() const noexcept;
+
+    // interrupt a blocking wait, callable from any thread
+    void wakeup() noexcept;
+
+    // run job on the loop thread after the current iteration, callable
+    // from any thread, returns false and leaves job alone if the queue
+    // is full
+    bool post(Job&& job);
+
+    // run callback on the loop thread once the events and posted jobs of
+    // the current iteration are handled, e.g. to flush coalesced writes,
+    // call from the loop thread
+    void defer(Callback callback);
+
+    // run callback once the socket is writable or fails, e.g. to resume a
+    // flush the socket cut short, whether or not it was added, replaces
+    // an earlier callback, call from the loop thread
+    void once_writable(sock_t fd, Callback callback);
+    void once_writable(const SocketBase& sock, Callback callback);
+
+private:
+    bool update_(Handler& handler) noexcept;
+    void run_posted_();
+    void run_deferred_();
+
+}; // class EventLoop
+
+} // namespace nano
+
+#endif // NANO_LINUX
+
+#endif // NANONET_EVENT_LOOP_H
@@ -0,0 +1,113 @@
+// File:     src/FrameReader.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "FrameReader.h"
+
+// C++
+#include <algorithm>
+
+namespace nano {
+
+// constructor
+FrameReader::FrameReader(size_t capacity, size_t max_frame)
+    : buf_(new char[std::max(capacity, HEADER_SIZE)]),
+    capacity_(std::max(capacity, HEADER_SIZE)),
+    begin_(0), end_(0), max_frame_(max_frame) {}
+
+// receive once
+int FrameReader::read_from(const SocketBase& sock) {
+    // avoid trickling into a nearly full tail, but do not grow for it
+    size_t room = this->reserve_(std::max<size_t>(1,
+        std::min(capacity_ / 4, capacity_ - (end_ - begin_))));
+    IoResult ret = try_recv_raw(sock.get(), buf_.get() + end_, room);
+    if (!ret.ok()) return -ret.error;
+    end_ += static_cast<size_t>(ret.bytes);
+    return ret.bytes;
+}
+
+void FrameReader::append(const char* data, size_t length) {
+    while (length > 0) {
+        size_t n = std::min(length, this->reserve_(length));
+        std::copy(data, data + n, buf_.get() + end_);
+        end_ += n;
+        data += n;
+        length -= n;
+    }
+}
+
+// next complete frame
+bool FrameReader::next(std::string_view& frame) {
+    size_t avail = end_ - begin_;
+    if (avail < HEADER_SIZE) return false;
+    auto* p = reinterpret_cast<const unsigned char*>(buf_.get() + begin_);
+    size_t length = (static_cast<size_t>(p[0]) << 24)
+        | (static_cast<size_t>(p[1]) << 16)
+        | (static_cast<size_t>(p[2]) << 8) | p[3];
+    assert_throw_nanoexcept(length <= max_frame_,
+        "[FrameReader] next(): Frame of ", std::to_string(length),
+        " bytes exceeds the limit of ", std::to_string(max_frame_));
+    if (avail < HEADER_SIZE + length) return false;
+    frame = std::string_view(buf_.get() + begin_ + HEADER_SIZE, length);
+    begin_ += HEADER_SIZE + length;
+    return true;
+}
+
+size_t FrameReader::buffered() const noexcept {
+    return end_ - begin_;
+}
+
+// make room for at least length bytes and the frame in progress, moves
+// the unread bytes to the front, returns the free room
+size_t FrameReader::reserve_(size_t length) {
+    size_t avail = end_ - begin_;
+    size_t need = avail + length;
+    // the whole frame in progress should fit in one piece
+    if (avail >= HEADER_SIZE) {
+        auto* p = reinterpret_cast<const unsigned char*>(buf_.get() + begin_);
+        size_t frame = (static_cast<size_t>(p[0]) << 24)
+            | (static_cast<size_t>(p[1]) << 16)
+            | (static_cast<size_t>(p[2]) << 8) | p[3];
+        if (frame <= max_frame_) need = std::max(need, HEADER_SIZE + frame);
+    }
+    if (need > capacity_) {
+        size_t capacity = std::max(need, capacity_ * 2);
+        std::unique_ptr<char[]> buf(new char[capacity]);
+        std::copy(buf_.get() + begin_, buf_.get() + end_, buf.get());
+        buf_ = std::move(buf);
+        capacity_ = capacity;
+    } else if (begin_ > 0 && (avail == 0 || capacity_ - end_ < length
+            || capacity_ - begin_ < need)) {
+        // only the unread tail is copied, usually part of one frame
+        std::copy(buf_.get() + begin_, buf_.get() + end_, buf_.get());
+    } else {
+        return capacity_ - end_;
+    }
+    begin_ = 0;
+    end_ = avail;
+    return capacity_ - end_;
+}
+
+} // namespace nano
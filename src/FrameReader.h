@@ -0,0 +1,94 @@
+// File:     src/FrameReader.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_FRAME_READER_H
+#define NANONET_FRAME_READER_H
+
+// C++
+#include <memory>
+#include <string_view>
+
+// NanoNet
+#include "SocketBase.h"
+
+namespace nano {
+
+// splits a stream into the frames written by FrameWriter, every frame that
+// arrived with one receive is handed out in place
+class FrameReader {
+public:
+
+    static constexpr size_t HEADER_SIZE = 4;
+
+    // larger frames are taken as a corrupt stream
+    static constexpr size_t MAX_FRAME = 16 * 1024 * 1024;
+
+private:
+
+    // buf_[begin_, end_) is received and not handed out
+    std::unique_ptr<char[]> buf_;
+    size_t capacity_;
+    size_t begin_;
+    size_t end_;
+    size_t max_frame_;
+
+public:
+
+    // ctor & dtor, the buffer grows for frames larger than capacity
+    FrameReader(size_t capacity = 65536, size_t max_frame = MAX_FRAME);
+    virtual ~FrameReader() = default;
+
+    // move
+    FrameReader(FrameReader&&) = default;
+    FrameReader& operator=(FrameReader&&) = default;
+
+    // uncopyable
+    FrameReader(const FrameReader&) = delete;
+    FrameReader& operator=(const FrameReader&) = delete;
+
+    // receive once into the buffer, returns the bytes read, 0 if the
+    // peer closed, or -ERR_CODE
+    int read_from(const SocketBase& sock);
+
+    // add bytes received elsewhere
+    void append(const char* data, size_t length);
+
+    // the next complete frame, valid until the next read_from() or
+    // append(), throws if its length exceeds the limit
+    bool next(std::string_view& frame);
+
+    // received bytes not handed out yet
+    size_t buffered() const noexcept;
+
+private:
+    size_t reserve_(size_t length);
+
+}; // class FrameReader
+
+} // namespace nano
+
+#endif // NANONET_FRAME_READER_H
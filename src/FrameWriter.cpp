@@ -0,0 +1,170 @@
+// File:     src/FrameWriter.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "FrameWriter.h"
+
+namespace nano {
+
+namespace {
+
+// big-endian length prefix
+inline void encode_header_(char (&header)[FrameWriter::HEADER_SIZE],
+        size_t length) noexcept {
+    auto value = static_cast<uint32_t>(length);
+    header[0] = static_cast<char>(value >> 24);
+    header[1] = static_cast<char>(value >> 16);
+    header[2] = static_cast<char>(value >> 8);
+    header[3] = static_cast<char>(value);
+}
+
+} // anonymous namespace
+
+// constructor
+FrameWriter::FrameWriter() noexcept : size_(0) {}
+
+// queue a frame
+void FrameWriter::write(std::string_view payload) {
+    assert_throw_nanoexcept(payload.size() <= UINT32_MAX,
+        "[FrameWriter] write(): Frame of ", std::to_string(payload.size()),
+        " bytes is too large");
+    char header[HEADER_SIZE];
+    encode_header_(header, payload.size());
+    this->append_(header, HEADER_SIZE);
+    this->append_(payload.data(), payload.size());
+}
+
+void FrameWriter::write_ref(std::string_view payload) {
+    assert_throw_nanoexcept(payload.size() <= UINT32_MAX,
+        "[FrameWriter] write_ref(): Frame of ",
+        std::to_string(payload.size()), " bytes is too large");
+    char header[HEADER_SIZE];
+    encode_header_(header, payload.size());
+    this->append_(header, HEADER_SIZE);
+    if (payload.empty()) return;
+    segments_.push_back({payload.data(), 0, payload.size()});
+    size_ += payload.size();
+}
+
+// send the queued bytes
+size_t FrameWriter::flush(const SocketBase& sock) {
+    if (size_ == 0) return 0;
+    size_t sent = 0;
+    try {
+#ifdef NANO_LINUX
+        // no allocation for a typical batch, buf_ stays put while flushing
+        iovec local[64];
+        std::vector<iovec> heap;
+        iovec* iov = local;
+        if (segments_.size() > sizeof(local) / sizeof(local[0])) {
+            heap.resize(segments_.size());
+            iov = heap.data();
+        }
+        for (size_t i = 0; i < segments_.size(); ++i) {
+            const Segment& seg = segments_[i];
+            const char* data = seg.data ? seg.data : buf_.data() + seg.offset;
+            iov[i] = {const_cast<char*>(data), seg.length};
+        }
+        sent = send_msg_iov(sock.get(), iov, segments_.size());
+#elif NANO_WINDOWS
+        // one send per segment, stopping where the socket would block
+        for (const Segment& seg : segments_) {
+            const char* data = seg.data ? seg.data : buf_.data() + seg.offset;
+            IoResult ret = try_send_msg(sock.get(), data, seg.length);
+            if (ret.would_block()) break;
+            assert_throw_nanoexcept(ret.ok(), SysError(ret.error));
+            sent += static_cast<size_t>(ret.bytes);
+            if (static_cast<size_t>(ret.bytes) < seg.length) break;
+        }
+#endif
+    } catch (const NanoExcept& e) {
+        throw_except("[FrameWriter] flush(): ", e);
+    }
+    this->consume_(sent);
+    return sent;
+}
+
+size_t FrameWriter::pending() const noexcept {
+    return size_;
+}
+
+bool FrameWriter::empty() const noexcept {
+    return size_ == 0;
+}
+
+void FrameWriter::clear() noexcept {
+    buf_.clear();
+    segments_.clear();
+    size_ = 0;
+}
+
+// copy to buf_, extending the last segment if it ends there
+void FrameWriter::append_(const char* data, size_t length) {
+    if (length == 0) return;
+    if (segments_.empty() || segments_.back().data
+            || segments_.back().offset + segments_.back().length
+            != buf_.size()) {
+        segments_.push_back({nullptr, buf_.size(), 0});
+    }
+    buf_.append(data, length);
+    segments_.back().length += length;
+    size_ += length;
+}
+
+// drop sent bytes from the head
+void FrameWriter::consume_(size_t length) noexcept {
+    if (length >= size_) {
+        this->clear();
+        return;
+    }
+    size_ -= length;
+    size_t index = 0;
+    while (length >= segments_[index].length)
+        length -= segments_[index++].length;
+    Segment& seg = segments_[index];
+    if (seg.data) seg.data += length;
+    else seg.offset += length;
+    seg.length -= length;
+    segments_.erase(segments_.begin(), segments_.begin() + index);
+    this->compact_();
+}
+
+// release the sent head of buf_ once it is most of it, so a writer that
+// never drains completely does not grow without bound
+void FrameWriter::compact_() noexcept {
+    size_t head = buf_.size();
+    for (const Segment& seg : segments_) {
+        if (seg.data == nullptr) {
+            head = seg.offset;
+            break;
+        }
+    }
+    if (head == 0 || head < buf_.size() - head) return;
+    buf_.erase(0, head);
+    for (Segment& seg : segments_)
+        if (seg.data == nullptr) seg.offset -= head;
+}
+
+} // namespace nano
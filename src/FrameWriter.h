@@ -0,0 +1,101 @@
+// File:     src/FrameWriter.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_FRAME_WRITER_H
+#define NANONET_FRAME_WRITER_H
+
+// C++
+#include <string>
+#include <string_view>
+#include <vector>
+
+// NanoNet
+#include "SocketBase.h"
+
+namespace nano {
+
+// queues frames of a 4-byte big-endian length and the payload, and sends
+// all of them in as few calls as possible
+class FrameWriter {
+public:
+
+    static constexpr size_t HEADER_SIZE = 4;
+
+private:
+
+    // bytes in buf_ at offset, or a payload the caller keeps alive
+    struct Segment {
+        const char* data;
+        size_t offset;
+        size_t length;
+    };
+
+    std::string buf_;
+    std::vector<Segment> segments_;
+    size_t size_;
+
+public:
+
+    // ctor & dtor
+    FrameWriter() noexcept;
+    virtual ~FrameWriter() = default;
+
+    // move
+    FrameWriter(FrameWriter&&) = default;
+    FrameWriter& operator=(FrameWriter&&) = default;
+
+    // uncopyable
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    // queue a frame, the payload is copied
+    void write(std::string_view payload);
+
+    // queue a frame without copying the payload, which must stay valid
+    // until it is flushed
+    void write_ref(std::string_view payload);
+
+    // send the queued bytes, returns the bytes sent, fewer than pending()
+    // only if a non-blocking socket would block, the rest stays queued and
+    // the copied bytes already sent are released
+    size_t flush(const SocketBase& sock);
+
+    // queued bytes, headers included
+    size_t pending() const noexcept;
+    bool empty() const noexcept;
+    void clear() noexcept;
+
+private:
+    void append_(const char* data, size_t length);
+    void consume_(size_t length) noexcept;
+    void compact_() noexcept;
+
+}; // class FrameWriter
+
+} // namespace nano
+
+#endif // NANONET_FRAME_WRITER_H
@@ -0,0 +1,332 @@
+// File:     src/IOBuffer.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "IOBuffer.h"
+
+// C
+#include <cstring>
+
+// C++
+#include <algorithm>
+#include <vector>
+
+namespace nano {
+
+namespace {
+
+// free chunks kept per thread
+constexpr size_t POOL_CAPACITY = 64;
+
+struct ChunkPool {
+    std::vector<char*> chunks;
+    ~ChunkPool() {
+        for (char* chunk : chunks) delete[] chunk;
+    }
+};
+
+thread_local ChunkPool pool_;
+
+inline char* alloc_chunk_() {
+    if (pool_.chunks.empty()) return new char[IOBuffer::CHUNK_SIZE];
+    char* chunk = pool_.chunks.back();
+    pool_.chunks.pop_back();
+    return chunk;
+}
+
+inline void free_chunk_(char* chunk) noexcept {
+    if (pool_.chunks.size() < POOL_CAPACITY) {
+        try {
+            pool_.chunks.push_back(chunk);
+            return;
+        } catch (...) {}
+    }
+    delete[] chunk;
+}
+
+#ifdef NANO_LINUX
+
+// iovec array on the stack for a few chunks
+class IovArray {
+    iovec local_[16];
+    std::vector<iovec> heap_;
+public:
+    iovec* get(size_t count) {
+        if (count <= sizeof(local_) / sizeof(local_[0])) return local_;
+        heap_.resize(count);
+        return heap_.data();
+    }
+};
+
+#endif
+
+} // anonymous namespace
+
+// constructor
+IOBuffer::IOBuffer(size_t high_water, size_t low_water) noexcept
+    : size_(0), high_water_(high_water), low_water_(low_water) {}
+
+IOBuffer::~IOBuffer() {
+    this->clear();
+}
+
+// move
+IOBuffer::IOBuffer(IOBuffer&& other) noexcept
+        : chunks_(std::move(other.chunks_)), size_(other.size_),
+        high_water_(other.high_water_), low_water_(other.low_water_) {
+    other.chunks_.clear();
+    other.size_ = 0;
+}
+
+IOBuffer& IOBuffer::operator=(IOBuffer&& other) noexcept {
+    if (this == &other) return *this;
+    this->clear();
+    chunks_ = std::move(other.chunks_);
+    size_ = other.size_;
+    high_water_ = other.high_water_;
+    low_water_ = other.low_water_;
+    other.chunks_.clear();
+    other.size_ = 0;
+    return *this;
+}
+
+size_t IOBuffer::size() const noexcept {
+    return size_;
+}
+
+bool IOBuffer::empty() const noexcept {
+    return size_ == 0;
+}
+
+void IOBuffer::clear() noexcept {
+    for (Chunk& chunk : chunks_) free_chunk_(chunk.data);
+    chunks_.clear();
+    size_ = 0;
+}
+
+// write to the tail
+void IOBuffer::append(const char* data, size_t length) {
+    if (length == 0) return;
+    size_t index = this->reserve_(length);
+    while (length > 0) {
+        Chunk& chunk = chunks_[index++];
+        size_t n = std::min(length, CHUNK_SIZE - chunk.end);
+        std::memcpy(chunk.data + chunk.end, data, n);
+        chunk.end += n;
+        data += n;
+        length -= n;
+        size_ += n;
+    }
+}
+
+void IOBuffer::append(std::string_view data) {
+    this->append(data.data(), data.size());
+}
+
+// views
+std::string_view IOBuffer::front() const noexcept {
+    if (chunks_.empty()) return std::string_view();
+    const Chunk& chunk = chunks_.front();
+    return std::string_view(chunk.data + chunk.begin, chunk.end - chunk.begin);
+}
+
+std::string_view IOBuffer::peek(size_t length) {
+    assert_throw_nanoexcept(length <= CHUNK_SIZE,
+        "[IOBuffer] peek(): Length ", std::to_string(length),
+        " exceeds the chunk size");
+    assert_throw_nanoexcept(length <= size_,
+        "[IOBuffer] peek(): Length ", std::to_string(length),
+        " exceeds the buffer size");
+    if (length == 0) return std::string_view();
+    Chunk& first = chunks_.front();
+    if (first.end - first.begin < length) {
+        // gather the bytes from the next chunks into the first one
+        if (first.begin + length > CHUNK_SIZE) {
+            std::memmove(first.data, first.data + first.begin,
+                first.end - first.begin);
+            first.end -= first.begin;
+            first.begin = 0;
+        }
+        while (chunks_[0].end - chunks_[0].begin < length) {
+            // erase() may move the first chunk, look it up every round
+            Chunk& head = chunks_[0];
+            Chunk& next = chunks_[1];
+            size_t n = std::min(length - (head.end - head.begin),
+                next.end - next.begin);
+            std::memcpy(head.data + head.end, next.data + next.begin, n);
+            head.end += n;
+            next.begin += n;
+            if (next.begin == next.end) {
+                free_chunk_(next.data);
+                chunks_.erase(chunks_.begin() + 1);
+            }
+        }
+    }
+    const Chunk& head = chunks_.front();
+    return std::string_view(head.data + head.begin, length);
+}
+
+size_t IOBuffer::find(char c) const noexcept {
+    size_t offset = 0;
+    for (const Chunk& chunk : chunks_) {
+        size_t length = chunk.end - chunk.begin;
+        const void* p = std::memchr(chunk.data + chunk.begin, c, length);
+        if (p) return offset + (static_cast<const char*>(p)
+            - (chunk.data + chunk.begin));
+        offset += length;
+    }
+    return npos;
+}
+
+// read from the head
+void IOBuffer::consume(size_t length) noexcept {
+    length = std::min(length, size_);
+    size_ -= length;
+    while (length > 0) {
+        Chunk& chunk = chunks_.front();
+        size_t n = std::min(length, chunk.end - chunk.begin);
+        chunk.begin += n;
+        length -= n;
+        if (chunk.begin == chunk.end) {
+            free_chunk_(chunk.data);
+            chunks_.pop_front();
+        }
+    }
+}
+
+size_t IOBuffer::read(char* buf, size_t length) noexcept {
+    length = std::min(length, size_);
+    size_t done = 0;
+    for (const Chunk& chunk : chunks_) {
+        if (done == length) break;
+        size_t n = std::min(length - done, chunk.end - chunk.begin);
+        std::memcpy(buf + done, chunk.data + chunk.begin, n);
+        done += n;
+    }
+    this->consume(length);
+    return length;
+}
+
+std::string IOBuffer::read_string(size_t length) {
+    std::string result(std::min(length, size_), '\0');
+    this->read(result.data(), result.size());
+    return result;
+}
+
+// socket I/O
+int IOBuffer::read_from(const SocketBase& sock, size_t max_bytes) {
+    if (max_bytes == 0) return 0;
+    size_t index = this->reserve_(max_bytes);
+#ifdef NANO_LINUX
+    IovArray array;
+    size_t count = chunks_.size() - index;
+    iovec* iov = array.get(count);
+    for (size_t i = 0; i < count; ++i) {
+        Chunk& chunk = chunks_[index + i];
+        iov[i] = {chunk.data + chunk.end, CHUNK_SIZE - chunk.end};
+    }
+    // the reserved room may be a chunk more than asked for
+    size_t extra = CHUNK_SIZE - chunks_[index].end + (count - 1) * CHUNK_SIZE
+        - max_bytes;
+    iov[count - 1].iov_len -= extra;
+    int ret = static_cast<int>(recv_msg_iov(sock.get(), iov, count));
+#elif NANO_WINDOWS
+    Chunk& tail = chunks_[index];
+    int ret = recv_msg(sock.get(), tail.data + tail.end,
+        std::min(max_bytes, CHUNK_SIZE - tail.end));
+#endif
+    for (size_t left = ret > 0 ? ret : 0; left > 0; ++index) {
+        Chunk& chunk = chunks_[index];
+        size_t n = std::min(left, CHUNK_SIZE - chunk.end);
+        chunk.end += n;
+        left -= n;
+        size_ += n;
+    }
+    this->trim_();
+    return ret;
+}
+
+size_t IOBuffer::write_to(const SocketBase& sock) {
+    size_t sent = 0;
+    try {
+#ifdef NANO_LINUX
+        IovArray array;
+        iovec* iov = array.get(chunks_.size());
+        for (size_t i = 0; i < chunks_.size(); ++i) {
+            Chunk& chunk = chunks_[i];
+            iov[i] = {chunk.data + chunk.begin, chunk.end - chunk.begin};
+        }
+        sent = send_msg_iov(sock.get(), iov, chunks_.size());
+#elif NANO_WINDOWS
+        for (const Chunk& chunk : chunks_) {
+            for (size_t done = chunk.begin; done < chunk.end;)
+                done += send_msg(sock.get(), chunk.data + done,
+                    chunk.end - done);
+            sent += chunk.end - chunk.begin;
+        }
+#endif
+    } catch (const NanoExcept& e) {
+        throw_except("[IOBuffer] write_to(): ", e);
+    }
+    this->consume(sent);
+    return sent;
+}
+
+// water marks
+void IOBuffer::water_marks(size_t high, size_t low) noexcept {
+    high_water_ = high;
+    low_water_ = low;
+}
+
+bool IOBuffer::above_high_water() const noexcept {
+    return high_water_ != 0 && size_ >= high_water_;
+}
+
+bool IOBuffer::below_low_water() const noexcept {
+    return size_ <= low_water_;
+}
+
+// make room for length bytes, returns the chunk writing starts in
+size_t IOBuffer::reserve_(size_t length) {
+    if (chunks_.empty() || chunks_.back().end == CHUNK_SIZE)
+        chunks_.push_back(Chunk{alloc_chunk_(), 0, 0});
+    size_t index = chunks_.size() - 1;
+    size_t room = CHUNK_SIZE - chunks_.back().end;
+    while (room < length) {
+        chunks_.push_back(Chunk{alloc_chunk_(), 0, 0});
+        room += CHUNK_SIZE;
+    }
+    return index;
+}
+
+// give back the reserved chunks nothing was written to
+void IOBuffer::trim_() noexcept {
+    while (!chunks_.empty() && chunks_.back().end == 0) {
+        free_chunk_(chunks_.back().data);
+        chunks_.pop_back();
+    }
+}
+
+} // namespace nano
@@ -0,0 +1,127 @@
+// File:     src/IOBuffer.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_IO_BUFFER_H
+#define NANONET_IO_BUFFER_H
+
+// C++
+#include <deque>
+#include <string>
+#include <string_view>
+
+// NanoNet
+#include "SocketBase.h"
+
+namespace nano {
+
+class IOBuffer {
+public:
+
+    // size of the pooled chunks the buffer is made of
+    static constexpr size_t CHUNK_SIZE = 16384;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+
+    // data[begin, end) is readable, data[end, CHUNK_SIZE) of the last chunk
+    // is free tail space
+    struct Chunk {
+        char* data;
+        size_t begin;
+        size_t end;
+    };
+
+    std::deque<Chunk> chunks_;
+    size_t size_;
+
+    // backpressure
+    size_t high_water_;
+    size_t low_water_;
+
+public:
+
+    // ctor & dtor, a high water mark of 0 means unlimited
+    IOBuffer(size_t high_water = 0, size_t low_water = 0) noexcept;
+    virtual ~IOBuffer();
+
+    // move
+    IOBuffer(IOBuffer&& other) noexcept;
+    IOBuffer& operator=(IOBuffer&& other) noexcept;
+
+    // uncopyable
+    IOBuffer(const IOBuffer&) = delete;
+    IOBuffer& operator=(const IOBuffer&) = delete;
+
+    // readable bytes
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+    void clear() noexcept;
+
+    // write to the tail
+    void append(const char* data, size_t length);
+    void append(std::string_view data);
+
+    // the readable bytes of the first chunk
+    std::string_view front() const noexcept;
+
+    // the first length bytes as one view, copies only if they span chunks,
+    // length must not exceed CHUNK_SIZE
+    std::string_view peek(size_t length);
+
+    // offset of the first c, or npos
+    size_t find(char c) const noexcept;
+
+    // drop bytes from the head, freed chunks go back to the pool
+    void consume(size_t length) noexcept;
+
+    // copy and consume up to length bytes, returns the bytes read
+    size_t read(char* buf, size_t length) noexcept;
+    std::string read_string(size_t length);
+
+    // read from the socket into the tail, up to max_bytes in one call,
+    // returns the bytes read, 0 if the peer closed, or -ERR_CODE
+    int read_from(const SocketBase& sock, size_t max_bytes = 65536);
+
+    // send from the head and consume what was sent, returns the bytes
+    // sent before a non-blocking socket would block
+    size_t write_to(const SocketBase& sock);
+
+    // water marks
+    void water_marks(size_t high, size_t low) noexcept;
+    bool above_high_water() const noexcept;
+    bool below_low_water() const noexcept;
+
+private:
+    size_t reserve_(size_t length);
+    void trim_() noexcept;
+
+}; // class IOBuffer
+
+} // namespace nano
+
+#endif // NANONET_IO_BUFFER_H
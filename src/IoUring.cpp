@@ -0,0 +1,615 @@
+// File:     src/IoUring.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "IoUring.h"
+
+#ifdef NANO_LINUX
+
+#if __has_include(<linux/io_uring.h>)
+#define NANO_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#endif
+
+namespace nano {
+
+struct IoUring::Op {
+    enum Kind { ACCEPT, RECV, SEND, CLOSE, WAKEUP } kind;
+    sock_t fd;
+    Callback callback;
+    AcceptCallback accept_callback;
+    RecvCallback recv_callback;
+    int domain = AF_INET;
+    // counter read from the eventfd by WAKEUP
+    uint64_t value = 0;
+};
+
+#ifdef NANO_IO_URING
+
+namespace {
+
+inline int setup_(unsigned entries, io_uring_params* params) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+inline int register_(int fd, unsigned opcode, void* arg,
+        unsigned nr_args) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_register,
+        fd, opcode, arg, nr_args));
+}
+
+inline unsigned* at_(void* base, unsigned offset) noexcept {
+    return reinterpret_cast<unsigned*>(static_cast<char*>(base) + offset);
+}
+
+constexpr unsigned short BUF_GROUP = 0;
+
+// Some kernels accept IORING_REGISTER_PBUF_RING but fail every receive
+// on the ring with ENOBUFS although it is full, seen on 6.18, so try one
+// receive on a scratch ring first
+bool buf_ring_works_() noexcept {
+    static const bool result = [] {
+        io_uring_params params {};
+        int fd = setup_(2, &params);
+        if (fd < 0) return false;
+        size_t ring_size = std::max<size_t>(
+            params.sq_off.array + params.sq_entries * sizeof(unsigned),
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        size_t sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        long page = ::sysconf(_SC_PAGESIZE);
+        void* ring = ::mmap(nullptr, ring_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        void* sqes = ::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        void* bufs = ::mmap(nullptr, static_cast<size_t>(page),
+            PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        int socks[2] = {-1, -1};
+        bool ok = false;
+        char data[16];
+        if ((params.features & IORING_FEAT_SINGLE_MMAP)
+                && ring != MAP_FAILED && sqes != MAP_FAILED
+                && bufs != MAP_FAILED && create_socket_pair(SOCK_STREAM, socks)
+                && ::write(socks[1], "x", 1) == 1) {
+            auto* buf_ring = static_cast<io_uring_buf_ring*>(bufs);
+            buf_ring->bufs[0].addr = reinterpret_cast<__u64>(data);
+            buf_ring->bufs[0].len = sizeof(data);
+            buf_ring->bufs[0].bid = 0;
+            __atomic_store_n(&buf_ring->tail, 1, __ATOMIC_RELEASE);
+            io_uring_buf_reg reg {};
+            reg.ring_addr = reinterpret_cast<__u64>(bufs);
+            reg.ring_entries = 1;
+            reg.bgid = BUF_GROUP;
+            if (register_(fd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0) {
+                auto* sqe = static_cast<io_uring_sqe*>(sqes);
+                std::memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = IORING_OP_RECV;
+                sqe->fd = socks[0];
+                sqe->flags = IOSQE_BUFFER_SELECT;
+                sqe->buf_group = BUF_GROUP;
+                *at_(ring, params.sq_off.array) = 0;
+                __atomic_store_n(at_(ring, params.sq_off.tail), 1,
+                    __ATOMIC_RELEASE);
+                int ret = static_cast<int>(::syscall(__NR_io_uring_enter,
+                    fd, 1, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+                auto* cqes = reinterpret_cast<io_uring_cqe*>(
+                    static_cast<char*>(ring) + params.cq_off.cqes);
+                ok = ret == 1 && cqes[0].res == 1;
+            }
+        }
+        if (socks[0] != -1) ::close(socks[0]);
+        if (socks[1] != -1) ::close(socks[1]);
+        // closing the ring drops the registration
+        ::close(fd);
+        if (bufs != MAP_FAILED) ::munmap(bufs, static_cast<size_t>(page));
+        if (sqes != MAP_FAILED) ::munmap(sqes, sqes_size);
+        if (ring != MAP_FAILED) ::munmap(ring, ring_size);
+        return ok;
+    }();
+    return result;
+}
+
+} // anonymous namespace
+
+// constructor
+IoUring::IoUring(unsigned entries) : ring_fd_(-1), wakeup_fd_(-1),
+        running_(false), sq_ring_(MAP_FAILED), sq_ring_size_(0), sq_pending_(0),
+        sqes_(nullptr), cq_ring_(MAP_FAILED), cq_ring_size_(0),
+        buf_ring_(nullptr), buf_ring_size_(0), buf_base_(nullptr),
+        buf_count_(0), buf_size_(0), buf_tail_(0) {
+    // blocking, io_uring would fail a read on a nonblocking one with EAGAIN
+    // instead of waiting for it
+    wakeup_fd_ = ::eventfd(0, EFD_CLOEXEC);
+    assert_throw_nanoexcept(wakeup_fd_ != -1,
+        "[IoUring] eventfd(): ", LAST_ERROR);
+    io_uring_params params {};
+    ring_fd_ = setup_(entries, &params);
+    if (ring_fd_ < 0) {
+        SysError error = LAST_ERROR;
+        ::close(wakeup_fd_);
+        throw_except("[IoUring] io_uring_setup(): ", error);
+    }
+
+    // map the rings, shared by one mapping on newer kernels
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes
+        + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single && cq_ring_size_ > sq_ring_size_)
+        sq_ring_size_ = cq_ring_size_;
+    sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ != MAP_FAILED) {
+        cq_ring_ = single ? sq_ring_ : ::mmap(nullptr, cq_ring_size_,
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_CQ_RING);
+    }
+    void* sqes = MAP_FAILED;
+    if (cq_ring_ != MAP_FAILED) {
+        sqes = ::mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe),
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_SQES);
+    }
+    if (sqes == MAP_FAILED) {
+        SysError error = LAST_ERROR;
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+            ::munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_ != MAP_FAILED) ::munmap(sq_ring_, sq_ring_size_);
+        ::close(ring_fd_);
+        ::close(wakeup_fd_);
+        throw_except("[IoUring] mmap(): ", error);
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_head_ = at_(sq_ring_, params.sq_off.head);
+    sq_tail_ = at_(sq_ring_, params.sq_off.tail);
+    sq_array_ = at_(sq_ring_, params.sq_off.array);
+    sq_mask_ = *at_(sq_ring_, params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+
+    cq_head_ = at_(cq_ring_, params.cq_off.head);
+    cq_tail_ = at_(cq_ring_, params.cq_off.tail);
+    cq_mask_ = *at_(cq_ring_, params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(
+        static_cast<char*>(cq_ring_) + params.cq_off.cqes);
+
+    // keep a read on the eventfd armed, so stop() can end a blocking wait
+    Op* op = new Op{Op::WAKEUP, wakeup_fd_, nullptr, nullptr, nullptr};
+    ops_.insert(op);
+    prep_wakeup_(op);
+}
+
+IoUring::~IoUring() {
+    // the kernel may write into the buffers until the armed receives are
+    // canceled and their last completions reaped
+    bool idle = this->cancel_all_();
+    for (Op* op : ops_) delete op;
+    if (idle) {
+        if (buf_ring_) {
+            io_uring_buf_reg reg {};
+            reg.bgid = BUF_GROUP;
+            register_(ring_fd_, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+            ::munmap(buf_ring_, buf_ring_size_);
+        }
+        delete[] buf_base_;
+    }
+    // otherwise leak them, the ring is torn down asynchronously
+    ::munmap(sqes_, sq_entries_ * sizeof(io_uring_sqe));
+    if (cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_ring_size_);
+    ::munmap(sq_ring_, sq_ring_size_);
+    ::close(ring_fd_);
+    ::close(wakeup_fd_);
+}
+
+bool IoUring::available() noexcept {
+    static const bool result = [] {
+        io_uring_params params {};
+        int fd = setup_(2, &params);
+        if (fd < 0) return false;
+        // multishot receive came with SEND_ZC in 6.0
+        std::vector<char> buf(sizeof(io_uring_probe)
+            + 256 * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(buf.data());
+        bool ok = (params.features & IORING_FEAT_EXT_ARG)
+            && register_(fd, IORING_REGISTER_PROBE, probe, 256) == 0
+            && probe->last_op >= IORING_OP_SEND_ZC
+            && (probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED);
+        ::close(fd);
+        return ok;
+    }();
+    return result;
+}
+
+// register the buffer ring, the kernel picks a buffer per receive
+void IoUring::provide_buffers(unsigned count, unsigned size) {
+    assert_throw_nanoexcept(buf_base_ == nullptr,
+        "[IoUring] provide_buffers(): Buffers are already provided");
+    assert_throw_nanoexcept(count > 0 && count <= 32768
+        && (count & (count - 1)) == 0 && size > 0,
+        "[IoUring] provide_buffers(): Invalid buffer count or size");
+    if (!buf_ring_works_()) {
+        // handed to the kernel with the next submit
+        buf_base_ = new char[static_cast<size_t>(count) * size];
+        buf_count_ = count;
+        buf_size_ = size;
+        buf_recycled_.reserve(count);
+        for (unsigned i = 0; i < count; ++i)
+            recycle_buffer_(static_cast<unsigned short>(i));
+        return;
+    }
+    size_t ring_size = count * sizeof(io_uring_buf);
+    void* ring = ::mmap(nullptr, ring_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert_throw_nanoexcept(ring != MAP_FAILED,
+        "[IoUring] provide_buffers(): ", LAST_ERROR);
+    io_uring_buf_reg reg {};
+    reg.ring_addr = reinterpret_cast<__u64>(ring);
+    reg.ring_entries = count;
+    reg.bgid = BUF_GROUP;
+    if (register_(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        SysError error = LAST_ERROR;
+        ::munmap(ring, ring_size);
+        throw_except("[IoUring] IORING_REGISTER_PBUF_RING: ", error);
+    }
+    buf_ring_ = static_cast<io_uring_buf_ring*>(ring);
+    buf_ring_size_ = ring_size;
+    buf_base_ = new char[static_cast<size_t>(count) * size];
+    buf_count_ = count;
+    buf_size_ = size;
+    buf_tail_ = 0;
+    for (unsigned i = 0; i < count; ++i)
+        recycle_buffer_(static_cast<unsigned short>(i));
+}
+
+// multishot accept
+void IoUring::accept(const ServerSocket& server, AcceptCallback callback) {
+    assert_throw_nanoexcept(server.is_open(),
+        "[IoUring] accept(): Socket is closed");
+    Op* op = new Op{Op::ACCEPT, server.get(), nullptr,
+        std::move(callback), nullptr};
+    op->domain = server.domain();
+    ops_.insert(op);
+    prep_accept_(op);
+}
+
+// multishot receive
+void IoUring::receive(const SocketBase& sock, RecvCallback callback) {
+    assert_throw_nanoexcept(sock.is_open(),
+        "[IoUring] receive(): Socket is closed");
+    assert_throw_nanoexcept(buf_base_ != nullptr,
+        "[IoUring] receive(): Call provide_buffers() first");
+    Op* op = new Op{Op::RECV, sock.get(), nullptr,
+        nullptr, std::move(callback)};
+    ops_.insert(op);
+    prep_receive_(op);
+}
+
+void IoUring::send(const SocketBase& sock, const char* msg,
+        size_t length, Callback callback) {
+    assert_throw_nanoexcept(sock.is_open(),
+        "[IoUring] send(): Socket is closed");
+    std::unique_ptr<Op> op(new Op{Op::SEND, sock.get(),
+        std::move(callback), nullptr, nullptr});
+    io_uring_sqe* sqe = get_sqe_();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = op->fd;
+    sqe->addr = reinterpret_cast<__u64>(msg);
+    sqe->len = static_cast<__u32>(length);
+    sqe->user_data = reinterpret_cast<__u64>(op.get());
+    ops_.insert(op.release());
+}
+
+void IoUring::close(SocketBase& sock, Callback callback) {
+    sock_t fd = sock.release();
+    if (fd == INVALID_SOCKET) return;
+    std::unique_ptr<Op> op(new Op{Op::CLOSE, fd,
+        std::move(callback), nullptr, nullptr});
+    // cancel the multishot operations on fd, the close runs after it
+    // even if there is nothing to cancel
+    io_uring_sqe* sqe = get_sqe_();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = fd;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    sqe->flags = IOSQE_IO_HARDLINK;
+    sqe = get_sqe_();
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->user_data = reinterpret_cast<__u64>(op.get());
+    ops_.insert(op.release());
+}
+
+// submit queued operations
+int IoUring::submit() {
+    provide_recycled_();
+    if (sq_pending_ == 0) return 0;
+    int ret = enter_(sq_pending_, 0, 0, nullptr, 0);
+    assert_throw_nanoexcept(ret >= 0, "[IoUring] submit(): ", LAST_ERROR);
+    sq_pending_ -= static_cast<unsigned>(ret);
+    return ret;
+}
+
+// submit, wait once and dispatch
+int IoUring::run_once(int timeout_ms) {
+    provide_recycled_();
+    unsigned head = *cq_head_;
+    bool ready = head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    int ret = 0;
+    if (ready || timeout_ms == 0) {
+        if (sq_pending_) ret = enter_(sq_pending_, 0, 0, nullptr, 0);
+    } else if (timeout_ms < 0) {
+        ret = enter_(sq_pending_, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    } else {
+        __kernel_timespec ts {timeout_ms / 1000,
+            timeout_ms % 1000 * 1000000LL};
+        io_uring_getevents_arg arg {};
+        arg.ts = reinterpret_cast<__u64>(&ts);
+        ret = enter_(sq_pending_, 1,
+            IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    }
+    if (ret < 0) {
+        assert_throw_nanoexcept(errno == EINTR || errno == ETIME
+            || errno == EBUSY, "[IoUring] io_uring_enter(): ", LAST_ERROR);
+    } else {
+        sq_pending_ -= std::min(sq_pending_, static_cast<unsigned>(ret));
+    }
+
+    // dispatch completions
+    int count = 0;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head, ++count) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        Op* op = reinterpret_cast<Op*>(cqe.user_data);
+        int res = cqe.res;
+        unsigned flags = cqe.flags;
+        // release the slot before the callback may submit more
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        if (op) complete_(op, res, flags);
+    }
+    return count;
+}
+
+// dispatch until stop() is called
+void IoUring::run() {
+    running_ = true;
+    while (running_) this->run_once();
+}
+
+void IoUring::stop() noexcept {
+    running_ = false;
+    ::eventfd_write(wakeup_fd_, 1);
+}
+
+bool IoUring::is_running() const noexcept {
+    return running_;
+}
+
+io_uring_sqe* IoUring::get_sqe_() {
+    unsigned tail = *sq_tail_;
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+        // the queue is full, hand it to the kernel
+        int ret = enter_(sq_pending_, 0, 0, nullptr, 0);
+        if (ret > 0) sq_pending_ -= static_cast<unsigned>(ret);
+        assert_throw_nanoexcept(
+            tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) < sq_entries_,
+            "[IoUring] Submission queue is full");
+    }
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++sq_pending_;
+    return sqe;
+}
+
+void IoUring::prep_accept_(Op* op) {
+    io_uring_sqe* sqe = get_sqe_();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = op->fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = reinterpret_cast<__u64>(op);
+}
+
+void IoUring::prep_receive_(Op* op) {
+    io_uring_sqe* sqe = get_sqe_();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = op->fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUF_GROUP;
+    sqe->user_data = reinterpret_cast<__u64>(op);
+}
+
+void IoUring::prep_wakeup_(Op* op) {
+    io_uring_sqe* sqe = get_sqe_();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = op->fd;
+    sqe->addr = reinterpret_cast<__u64>(&op->value);
+    sqe->len = sizeof(op->value);
+    sqe->user_data = reinterpret_cast<__u64>(op);
+}
+
+// hand a buffer back to the kernel, no system call needed with the ring
+void IoUring::recycle_buffer_(unsigned short bid) {
+    if (!buf_ring_) {
+        buf_recycled_.push_back(bid);
+        return;
+    }
+    io_uring_buf& buf = buf_ring_->bufs[buf_tail_ & (buf_count_ - 1)];
+    buf.addr = reinterpret_cast<__u64>(buf_base_
+        + static_cast<size_t>(bid) * buf_size_);
+    buf.len = buf_size_;
+    buf.bid = bid;
+    // publish the entry before the tail
+    __atomic_store_n(&buf_ring_->tail, ++buf_tail_, __ATOMIC_RELEASE);
+}
+
+// give the recycled buffers back without the ring, one entry per run of
+// consecutive ids
+void IoUring::provide_recycled_() {
+    size_t n = buf_recycled_.size();
+    for (size_t i = 0; i < n;) {
+        size_t j = i + 1;
+        while (j < n && buf_recycled_[j] == buf_recycled_[j - 1] + 1) ++j;
+        io_uring_sqe* sqe = get_sqe_();
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = static_cast<int>(j - i);
+        sqe->addr = reinterpret_cast<__u64>(buf_base_
+            + static_cast<size_t>(buf_recycled_[i]) * buf_size_);
+        sqe->len = buf_size_;
+        sqe->off = buf_recycled_[i];
+        sqe->buf_group = BUF_GROUP;
+        i = j;
+    }
+    buf_recycled_.clear();
+}
+
+// cancel every operation and reap the completions without callbacks,
+// false if some did not complete in time
+bool IoUring::cancel_all_() noexcept {
+    if (ops_.empty()) return true;
+    try {
+        io_uring_sqe* sqe = get_sqe_();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+    } catch (const NanoExcept&) {
+        return false;
+    }
+    for (int round = 0; round < 10 && !ops_.empty(); ++round) {
+        __kernel_timespec ts {0, 100 * 1000000LL};
+        io_uring_getevents_arg arg {};
+        arg.ts = reinterpret_cast<__u64>(&ts);
+        int ret = enter_(sq_pending_, 1,
+            IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+        if (ret > 0) sq_pending_ -= std::min(sq_pending_,
+            static_cast<unsigned>(ret));
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            Op* op = reinterpret_cast<Op*>(cqe.user_data);
+            if (!op) continue;
+            // nobody takes the connections accepted meanwhile
+            if (op->kind == Op::ACCEPT && cqe.res >= 0) ::close(cqe.res);
+            if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                ops_.erase(op);
+                delete op;
+            }
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+    return ops_.empty();
+}
+
+void IoUring::complete_(Op* op, int res, unsigned flags) {
+    bool more = flags & IORING_CQE_F_MORE;
+    switch (op->kind) {
+    case Op::ACCEPT:
+        if (res >= 0) {
+            Socket sock(false);
+            sock.socket_ = res;
+            sock.domain_ = op->domain;
+            op->accept_callback(std::move(sock), 0);
+        } else {
+            op->accept_callback(Socket(false), -res);
+        }
+        if (!more && res >= 0) {
+            prep_accept_(op);
+            return;
+        }
+        break;
+    case Op::RECV:
+        if (flags & IORING_CQE_F_BUFFER) {
+            auto bid = static_cast<unsigned short>(
+                flags >> IORING_CQE_BUFFER_SHIFT);
+            op->recv_callback(buf_base_
+                + static_cast<size_t>(bid) * buf_size_, res);
+            recycle_buffer_(bid);
+        } else if (res != -ENOBUFS) {
+            op->recv_callback(nullptr, res);
+        }
+        // out of buffers or terminated early, arm it again
+        if (!more && (res > 0 || res == -ENOBUFS)) {
+            prep_receive_(op);
+            return;
+        }
+        break;
+    case Op::SEND:
+    case Op::CLOSE:
+        if (op->callback) op->callback(res);
+        break;
+    case Op::WAKEUP:
+        // the counter is consumed, wait for the next stop()
+        if (res >= 0 || res == -EINTR) {
+            prep_wakeup_(op);
+            return;
+        }
+        break;
+    }
+    if (!more) {
+        ops_.erase(op);
+        delete op;
+    }
+}
+
+int IoUring::enter_(unsigned to_submit, unsigned min_complete,
+        unsigned flags, void* arg, size_t argsz) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd_,
+        to_submit, min_complete, flags, arg, argsz));
+}
+
+#else // NANO_IO_URING
+
+IoUring::IoUring(unsigned) : ring_fd_(-1), wakeup_fd_(-1),
+        running_(false) {
+    throw_except("[IoUring] io_uring is not supported by this build");
+}
+
+IoUring::~IoUring() = default;
+
+bool IoUring::available() noexcept { return false; }
+
+void IoUring::provide_buffers(unsigned, unsigned) {}
+void IoUring::accept(const ServerSocket&, AcceptCallback) {}
+void IoUring::receive(const SocketBase&, RecvCallback) {}
+void IoUring::send(const SocketBase&, const char*, size_t, Callback) {}
+void IoUring::close(SocketBase&, Callback) {}
+int IoUring::submit() { return 0; }
+int IoUring::run_once(int) { return 0; }
+void IoUring::run() {}
+void IoUring::stop() noexcept {}
+bool IoUring::is_running() const noexcept { return false; }
+
+#endif // NANO_IO_URING
+
+} // namespace nano
+
+#endif // NANO_LINUX
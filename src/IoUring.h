@@ -0,0 +1,162 @@
+// File:     src/IoUring.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_IO_URING_H
+#define NANONET_IO_URING_H
+
+// C++
+#include <atomic>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+// NanoNet
+#include "ServerSocket.h"
+
+#ifdef NANO_LINUX
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+namespace nano {
+
+class IoUring {
+public:
+
+    // result is the number of bytes, or a negative error code
+    using Callback = std::function<void(int result)>;
+
+    // error is 0 on success, or a positive error code
+    using AcceptCallback = std::function<void(Socket&& sock, int error)>;
+
+    // data is only valid during the callback, length <= 0 ends the stream
+    using RecvCallback = std::function<void(const char* data, int length)>;
+
+private:
+
+    struct Op;
+
+    int ring_fd_;
+
+    // eventfd read by an armed operation, written by stop()
+    int wakeup_fd_;
+    std::atomic<bool> running_;
+
+    // submission queue
+    void* sq_ring_;
+    size_t sq_ring_size_;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_array_;
+    unsigned sq_mask_;
+    unsigned sq_entries_;
+    unsigned sq_pending_;
+    io_uring_sqe* sqes_;
+
+    // completion queue
+    void* cq_ring_;
+    size_t cq_ring_size_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned cq_mask_;
+    io_uring_cqe* cqes_;
+
+    // ring of provided buffers for receives, shared with the kernel,
+    // nullptr if they are provided with IORING_OP_PROVIDE_BUFFERS
+    io_uring_buf_ring* buf_ring_;
+    size_t buf_ring_size_;
+    char* buf_base_;
+    unsigned buf_count_;
+    unsigned buf_size_;
+    unsigned short buf_tail_;
+    std::vector<unsigned short> buf_recycled_;
+
+    // operations in flight
+    std::unordered_set<Op*> ops_;
+
+public:
+
+    // ctor & dtor
+    IoUring(unsigned entries = 256);
+    virtual ~IoUring();
+
+    // uncopyable & unmovable
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // whether the running kernel supports io_uring
+    static bool available() noexcept;
+
+    // register a ring of count buffers of size bytes for receive(),
+    // count is a power of 2 up to 32768
+    void provide_buffers(unsigned count = 256, unsigned size = 4096);
+
+    // multishot accept, one callback per connection
+    void accept(const ServerSocket& server, AcceptCallback callback);
+
+    // multishot receive into the provided buffers
+    void receive(const SocketBase& sock, RecvCallback callback);
+
+    // msg must stay valid until the callback is called
+    void send(const SocketBase& sock, const char* msg, size_t length,
+        Callback callback = nullptr);
+
+    // the socket is released immediately and closed asynchronously, a
+    // multishot receive or accept on it is canceled first
+    void close(SocketBase& sock, Callback callback = nullptr);
+
+    // submit queued operations, returns the number submitted
+    int submit();
+
+    // submit, wait once and dispatch, returns the number of completions
+    int run_once(int timeout_ms = -1);
+
+    // dispatch until stop() is called, stop() may be called from any thread
+    void run();
+    void stop() noexcept;
+    bool is_running() const noexcept;
+
+private:
+    io_uring_sqe* get_sqe_();
+    void prep_accept_(Op* op);
+    void prep_receive_(Op* op);
+    void prep_wakeup_(Op* op);
+    void recycle_buffer_(unsigned short bid);
+    void provide_recycled_();
+    bool cancel_all_() noexcept;
+    void complete_(Op* op, int res, unsigned flags);
+    int enter_(unsigned to_submit, unsigned min_complete,
+        unsigned flags, void* arg, size_t argsz) noexcept;
+
+}; // class IoUring
+
+} // namespace nano
+
+#endif // NANO_LINUX
+
+#endif // NANONET_IO_URING_H
@@ -0,0 +1,149 @@
+// File:     src/MpscQueue.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_MPSC_QUEUE_H
+#define NANONET_MPSC_QUEUE_H
+
+// C++
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace nano {
+
+// bounded queue for many producers and one consumer, producers claim a
+// slot with one CAS and the consumer never writes a shared counter, a
+// producer stalled between claiming and filling its slot holds back the
+// consumer but no other producer
+template <class T>
+class MpscQueue {
+
+    struct Cell {
+        // pos when free, pos + 1 when filled, pos + capacity when consumed
+        std::atomic<size_t> seq;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+
+    // producers and the consumer write different cache lines
+    alignas(64) std::atomic<size_t> tail_;
+    alignas(64) size_t head_;
+
+public:
+
+    // ctor & dtor, the capacity is rounded up to a power of two
+    explicit MpscQueue(size_t capacity) : mask_(1), tail_(0), head_(0) {
+        while (mask_ + 1 < capacity) mask_ = (mask_ << 1) | 1;
+        cells_.reset(new Cell[mask_ + 1]);
+        for (size_t i = 0; i <= mask_; ++i)
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    ~MpscQueue() {
+        while (T* value = this->front_()) {
+            value->~T();
+            this->advance_();
+        }
+    }
+
+    // uncopyable & unmovable
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // any thread, false if the queue is full
+    template <class... Args>
+    bool try_emplace(Args&&... args) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq - pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                // not consumed yet since the last lap
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        ::new (cell->storage) T(std::forward<Args>(args)...);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(T&& value) {
+        return this->try_emplace(std::move(value));
+    }
+
+    // consumer thread only, false if the queue is empty
+    bool try_pop(T& value) {
+        T* front = this->front_();
+        if (front == nullptr) return false;
+        value = std::move(*front);
+        front->~T();
+        this->advance_();
+        return true;
+    }
+
+    // consumer thread only
+    bool empty() const noexcept {
+        const Cell& cell = cells_[head_ & mask_];
+        return cell.seq.load(std::memory_order_acquire) != head_ + 1;
+    }
+
+    size_t capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+private:
+    T* front_() noexcept {
+        Cell& cell = cells_[head_ & mask_];
+        if (cell.seq.load(std::memory_order_acquire) != head_ + 1)
+            return nullptr;
+        return std::launder(reinterpret_cast<T*>(cell.storage));
+    }
+
+    void advance_() noexcept {
+        cells_[head_ & mask_].seq.store(head_ + mask_ + 1,
+            std::memory_order_release);
+        ++head_;
+    }
+
+}; // class MpscQueue
+
+} // namespace nano
+
+#endif // NANONET_MPSC_QUEUE_H
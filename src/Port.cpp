@@ -26,12 +26,19 @@
 
 #include "Port.h"
 
+// C++
+#include <type_traits>
+
 namespace nano {
 
 namespace {
 
-// convert C string to port_t
-inline port_t parse_(const char* port) {
+// convert string to port_t, plain digits take the fast path
+inline port_t parse_(std::string_view str) {
+    port_t value = 0;
+    if (parse_port(str, value)) return value;
+    std::string copy(str);
+    const char* port = copy.c_str();
     unsigned result = 0;
     for (const char* p = port; *p; ++p) {
         if (*p == ' ') continue;
@@ -44,66 +51,36 @@ inline port_t parse_(const char* port) {
     return port_hton(static_cast<port_t>(result));
 }
 
-// compare port_t and C string
-inline bool equal_(const port_t& port, const char* other) {
-    try {
-        return port == parse_(other);
-    } catch (...) {
-        return false;
-    }
-}
-
 } // anonymous namespace
 
-// constructor
-Port::Port(port_t port) noexcept : val_(port_hton(port)) {}
+static_assert(std::is_trivially_copyable_v<Port>
+    && sizeof(Port) == sizeof(port_t), "Port must stay a plain value");
 
-Port::Port(std::string_view port) : val_(parse_(port.data())) {}
+// constructor
+Port::Port(std::string_view port) : val_(parse_(port)) {}
 
 // assignment
-Port& Port::operator=(port_t other) noexcept {
-    this->val_ = port_hton(other);
-    return *this;
-}
-
 Port& Port::operator=(std::string_view other) {
-    this->val_ = parse_(other.data());
+    this->val_ = parse_(other);
     return *this;
 }
 
-bool Port::operator==(port_t other) const noexcept {
-    return this->val_ == port_hton(other);
-}
-
 bool Port::operator==(std::string_view other) const {
     try {
-        return val_ == parse_(other.data());
+        return val_ == parse_(other);
     } catch (...) {
         return false;
     }
 }
 
-bool Port::operator!=(port_t other) const noexcept {
-    return this->val_ != port_hton(other);
-}
-
 bool Port::operator!=(std::string_view other) const {
     try {
-        return val_ != parse_(other.data());
+        return val_ != parse_(other);
     } catch (...) {
         return true;
     }
 }
 
-// getter & setter
-port_t Port::get(bool net_order) const noexcept {
-    return net_order ? this->val_ : port_ntoh(this->val_);
-}
-
-void Port::set(port_t val) noexcept {
-    this->val_ = port_hton(val);
-}
-
 // to string
 std::string Port::to_string() const noexcept {
     return std::to_string(port_ntoh(this->val_));
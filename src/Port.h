@@ -29,7 +29,9 @@
 #define NANONET_PORT_H
 
 // C++
+#include <functional>
 #include <string>
+#include <string_view>
 
 // NanoNet
 #include "net.h"
@@ -43,30 +45,70 @@ class Port {
 
 public:
 
-    // ctor & dtor
-    Port(port_t val = 0) noexcept;
+    // ctor & dtor, trivially copyable so it packs into flat tables
+    constexpr Port(port_t val = 0) noexcept : val_(port_hton(val)) {}
     Port(std::string_view port);
 
     Port(const Port&) = default;
     Port(Port&&) = default;
-    virtual ~Port() = default;
+    ~Port() = default;
 
     // assignment
     Port& operator=(const Port&) = default;
     Port& operator=(Port&&) = default;
 
-    Port& operator=(port_t other) noexcept;
+    constexpr Port& operator=(port_t other) noexcept {
+        val_ = port_hton(other);
+        return *this;
+    }
     Port& operator=(std::string_view other);
 
-    bool operator==(port_t other) const noexcept;
+    constexpr bool operator==(port_t other) const noexcept {
+        return val_ == port_hton(other);
+    }
     bool operator==(std::string_view other) const;
 
-    bool operator!=(port_t other) const noexcept;
+    constexpr bool operator!=(port_t other) const noexcept {
+        return val_ != port_hton(other);
+    }
     bool operator!=(std::string_view other) const;
 
+    // compare & order by numeric value
+    friend constexpr bool operator==(const Port& a, const Port& b) noexcept {
+        return a.val_ == b.val_;
+    }
+    friend constexpr bool operator!=(const Port& a, const Port& b) noexcept {
+        return a.val_ != b.val_;
+    }
+    friend constexpr bool operator<(const Port& a, const Port& b) noexcept {
+        return port_ntoh(a.val_) < port_ntoh(b.val_);
+    }
+    friend constexpr bool operator>(const Port& a, const Port& b) noexcept {
+        return b < a;
+    }
+    friend constexpr bool operator<=(const Port& a, const Port& b) noexcept {
+        return !(b < a);
+    }
+    friend constexpr bool operator>=(const Port& a, const Port& b) noexcept {
+        return !(a < b);
+    }
+
+    // digits only, usable at compile time for literals
+    static constexpr Port parse(std::string_view port) {
+        Port ret;
+        if (!parse_port(port, ret.val_))
+            throw NanoExcept("[Port] parse(): \'" + std::string(port)
+                + "\' is not a port");
+        return ret;
+    }
+
     // getter & setter
-    port_t get(bool net_order = true) const noexcept;
-    void set(port_t val) noexcept;
+    constexpr port_t get(bool net_order = true) const noexcept {
+        return net_order ? val_ : port_ntoh(val_);
+    }
+    constexpr void set(port_t val) noexcept {
+        val_ = port_hton(val);
+    }
 
     // to string
     std::string to_string() const noexcept;
@@ -75,4 +117,15 @@ public:
 
 } // namespace nano
 
+namespace std {
+
+template <>
+struct hash<::nano::Port> {
+    size_t operator()(const ::nano::Port& port) const noexcept {
+        return hash<::nano::port_t>()(port.get());
+    }
+};
+
+} // namespace std
+
 #endif // NANONET_PORT_H
@@ -0,0 +1,282 @@
+// File:     src/Resolver.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Resolver.h"
+
+#ifdef NANO_LINUX
+#include <sys/eventfd.h>
+#include "EventLoop.h"
+#endif
+
+namespace nano {
+
+namespace {
+
+// query getaddrinfo() for the ipv4 and ipv6 addresses of name, in the
+// order of preference of the system
+inline int query_(const std::string& name, std::vector<Addr>& addrs) {
+    addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    int status = ::getaddrinfo(name.c_str(), nullptr, &hints, &result);
+    addrs.clear();
+    if (status != 0) return status;
+    for (addrinfo* p = result; p; p = p->ai_next) {
+        if (p->ai_family == AF_INET) {
+            addrs.push_back(Addr(addr_ntoh(reinterpret_cast<sockaddr_in*>
+                (p->ai_addr)->sin_addr.s_addr)));
+        } else if (p->ai_family == AF_INET6) {
+            addrs.push_back(Addr(reinterpret_cast<sockaddr_in6*>
+                (p->ai_addr)->sin6_addr));
+        }
+    }
+    ::freeaddrinfo(result);
+    return addrs.empty() ? EAI_NONAME : 0;
+}
+
+} // anonymous namespace
+
+// constructor
+Resolver::Resolver(size_t workers)
+    : ttl_ms_(30000), negative_ttl_ms_(5000),
+    max_workers_(workers > 0 ? workers : 1), stopping_(false),
+    notify_fd_(-1), loop_(nullptr) {}
+
+Resolver::~Resolver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+#ifdef NANO_LINUX
+    this->detach();
+#endif
+}
+
+Resolver& Resolver::global() {
+    static Resolver resolver;
+    return resolver;
+}
+
+void Resolver::ttl(std::chrono::milliseconds positive,
+        std::chrono::milliseconds negative) noexcept {
+    ttl_ms_ = positive.count();
+    negative_ttl_ms_ = negative.count();
+}
+
+// blocking query
+int Resolver::resolve(std::string_view name, std::vector<Addr>& addrs) {
+    std::string key(name);
+    int error = 0;
+    if (this->lookup_(key, addrs, error)) return error;
+    error = query_(key, addrs);
+    this->store_(key, addrs, error);
+    return error;
+}
+
+// asynchronous query
+void Resolver::resolve(std::string_view name, Callback callback) {
+    this->enqueue_(std::string(name), std::move(callback), true);
+}
+
+std::future<std::vector<Addr>> Resolver::resolve_async(
+        std::string_view name) {
+    auto promise = std::make_shared<std::promise<std::vector<Addr>>>();
+    auto future = promise->get_future();
+    // the waiting thread may be the loop thread, do not go through it
+    this->enqueue_(std::string(name), [promise](
+            const std::vector<Addr>& addrs, int error) {
+        if (error == 0) {
+            promise->set_value(addrs);
+        } else {
+            promise->set_exception(std::make_exception_ptr(NanoExcept(
+                std::string("[Resolver] ") + error_string(error))));
+        }
+    }, false);
+    return future;
+}
+
+void Resolver::clear() noexcept {
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+    }
+}
+
+const char* Resolver::error_string(int error) noexcept {
+    return gai_strerror(error);
+}
+
+#ifdef NANO_LINUX
+
+void Resolver::attach(EventLoop& loop) {
+    this->detach();
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    assert_throw_nanoexcept(fd != -1,
+        "[Resolver] attach(): ", LAST_ERROR);
+    try {
+        loop.add(fd, EventLoop::READABLE, [this] { this->dispatch_(); });
+    } catch (const NanoExcept&) {
+        ::close(fd);
+        throw;
+    }
+    std::lock_guard<std::mutex> lock(done_mutex_);
+    notify_fd_ = fd;
+    loop_ = &loop;
+}
+
+void Resolver::detach() noexcept {
+    EventLoop* loop = nullptr;
+    int fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+        std::swap(loop, loop_);
+        std::swap(fd, notify_fd_);
+    }
+    if (loop == nullptr) return;
+    loop->remove(fd);
+    ::close(fd);
+    // run what was left for the loop
+    this->dispatch_();
+}
+
+#endif
+
+// look up the cache, expired entries are dropped
+bool Resolver::lookup_(const std::string& name, std::vector<Addr>& addrs,
+        int& error) {
+    Shard& shard = shards_[std::hash<std::string>{}(name) % SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(name);
+    if (it == shard.entries.end()) return false;
+    if (it->second.expires <= std::chrono::steady_clock::now()) {
+        shard.entries.erase(it);
+        return false;
+    }
+    addrs = it->second.addrs;
+    error = it->second.error;
+    return true;
+}
+
+void Resolver::store_(const std::string& name,
+        const std::vector<Addr>& addrs, int error) {
+    long long ms = error == 0 ? ttl_ms_.load() : negative_ttl_ms_.load();
+    if (ms <= 0) return;
+    auto now = std::chrono::steady_clock::now();
+    Shard& shard = shards_[std::hash<std::string>{}(name) % SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& entries = shard.entries;
+    if (entries.size() >= SHARD_CAPACITY
+            && entries.find(name) == entries.end()) {
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->second.expires <= now) it = entries.erase(it);
+            else ++it;
+        }
+        // still full, make room for the new entry
+        if (entries.size() >= SHARD_CAPACITY) entries.erase(entries.begin());
+    }
+    entries[name] = Entry{addrs, error, now + std::chrono::milliseconds(ms)};
+}
+
+// answer from the cache, or hand the query to a worker
+void Resolver::enqueue_(std::string name, Callback callback, bool on_loop) {
+    std::vector<Addr> addrs;
+    int error = 0;
+    if (this->lookup_(name, addrs, error)) {
+        callback(addrs, error);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& waiters = waiting_[name];
+        waiters.push_back(Waiter{std::move(callback), on_loop});
+        // already in flight
+        if (waiters.size() > 1) return;
+        queue_.push_back(std::move(name));
+        if (workers_.size() < max_workers_)
+            workers_.emplace_back([this] { this->work_(); });
+    }
+    cond_.notify_one();
+}
+
+// worker thread
+void Resolver::work_() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cond_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (stopping_) return;
+        std::string name = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        std::vector<Addr> addrs;
+        int error = query_(name, addrs);
+        this->store_(name, addrs, error);
+
+        lock.lock();
+        std::vector<Waiter> waiters = std::move(waiting_[name]);
+        waiting_.erase(name);
+        lock.unlock();
+
+        for (Waiter& waiter : waiters) {
+            if (waiter.on_loop) {
+                std::lock_guard<std::mutex> done_lock(done_mutex_);
+                if (loop_ != nullptr) {
+                    done_.push_back([callback = std::move(waiter.callback),
+                        addrs, error] { callback(addrs, error); });
+                    continue;
+                }
+            }
+            waiter.callback(addrs, error);
+        }
+#ifdef NANO_LINUX
+        {
+            std::lock_guard<std::mutex> done_lock(done_mutex_);
+            if (!done_.empty() && notify_fd_ != -1)
+                ::eventfd_write(notify_fd_, 1);
+        }
+#endif
+        lock.lock();
+    }
+}
+
+// run the callbacks queued for the loop
+void Resolver::dispatch_() {
+    std::vector<std::function<void()>> done;
+    {
+        std::lock_guard<std::mutex> lock(done_mutex_);
+#ifdef NANO_LINUX
+        eventfd_t value;
+        if (notify_fd_ != -1) ::eventfd_read(notify_fd_, &value);
+#endif
+        done.swap(done_);
+    }
+    for (auto& callback : done) callback();
+}
+
+} // namespace nano
@@ -0,0 +1,153 @@
+// File:     src/Resolver.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_RESOLVER_H
+#define NANONET_RESOLVER_H
+
+// C++
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// NanoNet
+#include "Addr.h"
+
+namespace nano {
+
+class EventLoop;
+
+class Resolver {
+public:
+
+    // error is 0 on success, or a getaddrinfo() error code
+    using Callback = std::function<void(const std::vector<Addr>& addrs,
+        int error)>;
+
+    // the cache is split into shards to keep lock contention low
+    static constexpr size_t SHARDS = 16;
+    static constexpr size_t SHARD_CAPACITY = 1024;
+
+private:
+
+    struct Entry {
+        std::vector<Addr> addrs;
+        int error;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    struct Waiter {
+        Callback callback;
+        bool on_loop;
+    };
+
+    // cache
+    Shard shards_[SHARDS];
+    std::atomic<long long> ttl_ms_;
+    std::atomic<long long> negative_ttl_ms_;
+
+    // worker threads, queries of the same name in flight are merged
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::string> queue_;
+    std::unordered_map<std::string, std::vector<Waiter>> waiting_;
+    std::vector<std::thread> workers_;
+    size_t max_workers_;
+    bool stopping_;
+
+    // callbacks to run on the attached loop
+    std::mutex done_mutex_;
+    std::vector<std::function<void()>> done_;
+    int notify_fd_;
+    EventLoop* loop_;
+
+public:
+
+    // ctor & dtor, the workers are started on the first asynchronous query
+    Resolver(size_t workers = 2);
+    virtual ~Resolver();
+
+    // uncopyable & unmovable
+    Resolver(const Resolver&) = delete;
+    Resolver& operator=(const Resolver&) = delete;
+
+    // the process-wide resolver used by Addr
+    static Resolver& global();
+
+    // how long answers and failures are cached, 0 disables caching
+    void ttl(std::chrono::milliseconds positive,
+        std::chrono::milliseconds negative) noexcept;
+
+    // blocks on a cache miss, returns 0 or a getaddrinfo() error code
+    int resolve(std::string_view name, std::vector<Addr>& addrs);
+
+    // never blocks, the callback runs at once on a cache hit, otherwise on
+    // a worker thread or on the attached loop
+    void resolve(std::string_view name, Callback callback);
+
+    // never blocks, the future throws NanoExcept on failure
+    std::future<std::vector<Addr>> resolve_async(std::string_view name);
+
+    // drop every cached answer
+    void clear() noexcept;
+
+    static const char* error_string(int error) noexcept;
+
+#ifdef NANO_LINUX
+    // run the callbacks of asynchronous queries on the loop thread,
+    // call both from the loop thread
+    void attach(EventLoop& loop);
+    void detach() noexcept;
+#endif
+
+private:
+    bool lookup_(const std::string& name, std::vector<Addr>& addrs,
+        int& error);
+    void store_(const std::string& name, const std::vector<Addr>& addrs,
+        int error);
+    void enqueue_(std::string name, Callback callback, bool on_loop);
+    void work_();
+    void dispatch_();
+
+}; // class Resolver
+
+} // namespace nano
+
+#endif // NANONET_RESOLVER_H
@@ -32,9 +32,13 @@ namespace nano {
 ServerSocket::ServerSocket(bool create)
     : SocketBase(create ? SOCK_STREAM : NULL_SOCKET) {}
 
+ServerSocket::ServerSocket(Domain domain)
+    : SocketBase(SOCK_STREAM, domain) {}
+
 ServerSocket::ServerSocket(const Addr& addr, const Port& port)
-        : SocketBase(SOCK_STREAM) {
+        : SocketBase(SOCK_STREAM, addr.family()) {
     this->reuse_addr(true);
+    if (addr.is_ipv6() && addr.is_unspecified()) this->dual_stack(true);
     SocketBase::bind(addr, port);
 }
 
@@ -49,22 +53,74 @@ void ServerSocket::listen(int backlog) {
         except_name(), "listen(): ", LAST_ERROR);
 }
 
-// accept a new connection
+// accept a new connection, the local address is queried on first use
 Socket ServerSocket::accept() {
     Socket ret(false);
-    ret.socket_ = accept_from(socket_,
-        &ret.remote_addr_, &ret.remote_port_);
-    get_local_address(ret.socket_, &ret.local_addr_, &ret.local_port_);
-    assert_throw_nanoexcept(ret.socket_ >= 0,
+    sockaddr_storage remote;
+    ret.socket_ = accept_from(socket_, &remote);
+    assert_throw_nanoexcept(ret.socket_ != INVALID_SOCKET,
         except_name(), "accept(): ", LAST_ERROR);
+    ret.domain_ = domain_;
+    ret.remote_ = AddrPort::from_sockaddr(remote);
     return std::move(ret);
 }
 
+// drain the backlog
+size_t ServerSocket::accept_batch(std::vector<Socket>& sockets, size_t max) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "accept_batch(): Socket is closed");
+    // a listener bound to a specific address shares it with its sockets
+    AddrPort listen_addr = this->local();
+    bool share_local = !listen_addr.addr().is_unspecified();
+    size_t count = 0;
+    sockaddr_storage remote;
+    while (count < max) {
+        Socket sock(false);
+#ifdef NANO_LINUX
+        sock.socket_ = accept_from(socket_, &remote,
+            SOCK_NONBLOCK | SOCK_CLOEXEC);
+#elif NANO_WINDOWS
+        sock.socket_ = accept_from(socket_, &remote);
+        if (sock.socket_ != INVALID_SOCKET)
+            nano::set_blocking(sock.socket_, false);
+#endif
+        if (sock.socket_ == INVALID_SOCKET) {
+            int err = ERR_CODE;
+#ifdef NANO_LINUX
+            // the connection was reset while waiting in the backlog
+            if (err == ECONNABORTED || err == EINTR) continue;
+            if (err == EAGAIN || err == EWOULDBLOCK) break;
+#elif NANO_WINDOWS
+            if (err == WSAECONNRESET) continue;
+            if (err == WSAEWOULDBLOCK) break;
+#endif
+            // report the error once everything before it is handed out
+            if (count > 0) break;
+            throw_except(except_name(), "accept_batch(): ", LAST_ERROR);
+        }
+        sock.domain_ = domain_;
+        sock.remote_ = AddrPort::from_sockaddr(remote);
+        if (share_local) sock.local_ = listen_addr;
+        sockets.push_back(std::move(sock));
+        ++count;
+    }
+    return count;
+}
+
 // set address reuse
 bool ServerSocket::reuse_addr(bool enable) noexcept {
     return this->set_option(SOL_SOCKET, SO_REUSEADDR, (int)enable);
 }
 
+// set port reuse
+bool ServerSocket::reuse_port(bool enable) noexcept {
+#ifdef SO_REUSEPORT
+    return this->set_option(SOL_SOCKET, SO_REUSEPORT, (int)enable);
+#else
+    return false;
+#endif
+}
+
 const char* ServerSocket::except_name() const noexcept {
     return "[TCP] ";
 }
@@ -38,6 +38,8 @@ public:
 
     // ctor & dtor
     ServerSocket(bool create = true);
+    explicit ServerSocket(Domain domain);
+    // binding to :: accepts IPv4 clients as well
     ServerSocket(const Addr& addr, const Port& port);
     ServerSocket(const AddrPort& addrport);
     virtual ~ServerSocket() = default;
@@ -56,9 +58,17 @@ public:
     // accept from client
     Socket accept();
 
+    // accept until the backlog is drained or max sockets were accepted,
+    // the sockets are non-blocking and close-on-exec
+    size_t accept_batch(std::vector<Socket>& sockets,
+        size_t max = static_cast<size_t>(-1));
+
     // set address reuse
     bool reuse_addr(bool reuseAddr) noexcept;
 
+    // let several sockets bind the same address and port
+    bool reuse_port(bool enable) noexcept;
+
 protected:
     virtual const char* except_name() const noexcept override;
 
@@ -0,0 +1,275 @@
+// File:     src/ShardedServer.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ShardedServer.h"
+
+#ifdef NANO_LINUX
+
+// C++
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+
+// Linux
+#include <linux/filter.h>
+#include <pthread.h>
+#include <sched.h>
+
+namespace nano {
+
+namespace {
+
+// delay before accepting again after an error, doubled per failure
+constexpr int ACCEPT_RETRY_MIN_MS = 10;
+constexpr int ACCEPT_RETRY_MAX_MS = 1000;
+
+// CPUs the process may run on, in ascending order
+std::vector<int> allowed_cpus_() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+    if (cpus.empty()) {
+        int count = static_cast<int>(std::thread::hardware_concurrency());
+        for (int cpu = 0; cpu < std::max(count, 1); ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+} // anonymous namespace
+
+struct ShardedServer::Shard {
+    ServerSocket server;
+    EventLoop loop;
+    std::thread thread;
+    // milliseconds until the next accept, 0 while accepting works
+    int accept_retry_ms = 0;
+    explicit Shard(Domain domain) : server(domain) {}
+};
+
+// constructor
+ShardedServer::ShardedServer(const Addr& addr, const Port& port,
+        size_t shards) : cpus_(allowed_cpus_()), running_(false),
+        pin_threads_(true) {
+    if (shards == 0) shards = cpus_.size();
+    Port bound = port;
+    try {
+        for (size_t i = 0; i < shards; ++i) {
+            shards_.push_back(std::make_unique<Shard>(
+                static_cast<Domain>(addr.family())));
+            ServerSocket& server = shards_.back()->server;
+            server.reuse_addr(true);
+            assert_throw_nanoexcept(server.reuse_port(true),
+                "[ShardedServer] SO_REUSEPORT: ", LAST_ERROR);
+            server.bind(addr, bound);
+            // the other shards share the port picked for the first one
+            if (i == 0 && port.get() == 0) bound = server.local().port();
+        }
+    } catch (const NanoExcept&) {
+        for (auto& shard : shards_) shard->server.close();
+        throw;
+    }
+}
+
+ShardedServer::ShardedServer(const AddrPort& addrport, size_t shards)
+    : ShardedServer(addrport.addr(), addrport.port(), shards) {}
+
+ShardedServer::~ShardedServer() {
+    this->stop();
+    for (auto& shard : shards_) shard->server.close();
+}
+
+// listen on every shard, in shard order
+void ShardedServer::listen(int backlog) {
+    for (auto& shard : shards_) shard->server.listen(backlog);
+}
+
+// classic BPF program mapping the receiving CPU to its shard
+bool ShardedServer::steer_by_cpu() noexcept {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+    auto n = static_cast<uint32_t>(shards_.size());
+    std::vector<sock_filter> code;
+    try {
+        code.push_back({ BPF_LD | BPF_W | BPF_ABS, 0, 0,
+            static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) });
+        // the k-th allowed CPU goes to shard k % n, nothing to look up
+        // if the k-th allowed CPU is CPU k
+        if (cpus_.back() != static_cast<int>(cpus_.size()) - 1) {
+            for (size_t k = 0; k < cpus_.size(); ++k) {
+                code.push_back({ BPF_JMP | BPF_JEQ | BPF_K, 0, 1,
+                    static_cast<uint32_t>(cpus_[k]) });
+                code.push_back({ BPF_RET | BPF_K, 0, 0,
+                    static_cast<uint32_t>(k % n) });
+            }
+        }
+        // CPUs outside the mask
+        code.push_back({ BPF_ALU | BPF_MOD | BPF_K, 0, 0, n });
+        code.push_back({ BPF_RET | BPF_A, 0, 0, 0 });
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    if (code.size() > BPF_MAXINSNS) return false;
+    sock_fprog prog {};
+    prog.len = static_cast<unsigned short>(code.size());
+    prog.filter = code.data();
+    return shards_[0]->server.set_option(SOL_SOCKET,
+        SO_ATTACH_REUSEPORT_CBPF, prog);
+#else
+    return false;
+#endif
+}
+
+void ShardedServer::pin_threads(bool enable) noexcept {
+    pin_threads_ = enable;
+}
+
+void ShardedServer::on_error(ErrorHandler handler) {
+    assert_throw_nanoexcept(!running_,
+        "[ShardedServer] on_error(): Already running");
+    on_error_ = std::move(handler);
+}
+
+// start one loop thread per shard
+void ShardedServer::start(AcceptHandler handler) {
+    assert_throw_nanoexcept(!running_,
+        "[ShardedServer] start(): Already running");
+    handler_ = std::move(handler);
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        Shard* s = shards_[i].get();
+        s->accept_retry_ms = 0;
+        s->loop.add(s->server, EventLoop::READABLE,
+            [this, i] { this->accept_(i); });
+    }
+    running_ = true;
+    for (size_t i = 0; i < shards_.size(); ++i)
+        shards_[i]->thread = std::thread([this, i] { this->run_(i); });
+}
+
+// body of the loop thread of shard index
+void ShardedServer::run_(size_t index) {
+    Shard* s = shards_[index].get();
+    // pin before the first event so no connection is handled elsewhere,
+    // to the same CPUs steer_by_cpu() sends to this shard
+    if (pin_threads_) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        size_t n = shards_.size();
+        if (n < cpus_.size()) {
+            for (size_t k = index; k < cpus_.size(); k += n)
+                CPU_SET(cpus_[k], &set);
+        } else {
+            CPU_SET(cpus_[index % cpus_.size()], &set);
+        }
+        int err = ::pthread_setaffinity_np(::pthread_self(),
+            sizeof(set), &set);
+        if (err != 0) {
+            this->report_(index, NanoExcept("[ShardedServer] "
+                "pthread_setaffinity_np(): " + std::string(std::strerror(err)),
+                err));
+        }
+    }
+    while (running_) {
+        s->loop.run_once(s->accept_retry_ms ? s->accept_retry_ms : -1);
+        // the edge of the failed accept is gone, poll until it works
+        if (s->accept_retry_ms && running_) this->accept_(index);
+    }
+}
+
+// drain the backlog, the socket is edge-triggered
+void ShardedServer::accept_(size_t index) {
+    Shard* s = shards_[index].get();
+    std::vector<Socket> sockets;
+    for (;;) {
+        sockets.clear();
+        try {
+            // a batch cut short by an error returns what came before it
+            if (s->server.accept_batch(sockets) == 0) break;
+        } catch (const NanoExcept& e) {
+            // e.g. EMFILE, the pending connections stay in the backlog
+            s->accept_retry_ms = s->accept_retry_ms
+                ? std::min(s->accept_retry_ms * 2, ACCEPT_RETRY_MAX_MS)
+                : ACCEPT_RETRY_MIN_MS;
+            this->report_(index, e);
+            return;
+        }
+        for (Socket& sock : sockets) {
+            try {
+                handler_(s->loop, std::move(sock));
+            } catch (const std::exception& e) {
+                // drop the connection unless the handler took it
+                sock.close();
+                this->report_(index, e);
+            } catch (...) {
+                sock.close();
+                this->report_(index, NanoExcept("[ShardedServer] "
+                    "Accept handler threw a non-standard exception"));
+            }
+        }
+    }
+    s->accept_retry_ms = 0;
+}
+
+void ShardedServer::report_(size_t index, const std::exception& e) noexcept {
+    if (!on_error_) return;
+    try {
+        on_error_(index, e);
+    } catch (...) {}
+}
+
+// stop and join the loop threads
+void ShardedServer::stop() noexcept {
+    if (!running_.exchange(false)) return;
+    for (auto& shard : shards_) shard->loop.wakeup();
+    for (auto& shard : shards_) {
+        if (shard->thread.joinable()) shard->thread.join();
+        shard->loop.remove(shard->server);
+    }
+}
+
+size_t ShardedServer::size() const noexcept {
+    return shards_.size();
+}
+
+EventLoop& ShardedServer::loop(size_t index) {
+    assert_throw_nanoexcept(index < shards_.size(),
+        "[ShardedServer] loop(): Index ", std::to_string(index),
+        " is out of range");
+    return shards_[index]->loop;
+}
+
+AddrPort ShardedServer::local() const noexcept {
+    return shards_[0]->server.local();
+}
+
+} // namespace nano
+
+#endif // NANO_LINUX
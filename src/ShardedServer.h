@@ -0,0 +1,119 @@
+// File:     src/ShardedServer.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_SHARDED_SERVER_H
+#define NANONET_SHARDED_SERVER_H
+
+// C++
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// NanoNet
+#include "EventLoop.h"
+#include "ServerSocket.h"
+
+#ifdef NANO_LINUX
+
+namespace nano {
+
+class ShardedServer {
+public:
+
+    // called on the loop thread of the shard that accepted the connection
+    using AcceptHandler = std::function<void(EventLoop& loop, Socket&& sock)>;
+
+    // called on the loop thread of the shard that failed, e.g. accept()
+    // out of file descriptors, the handler threw or pinning failed
+    using ErrorHandler = std::function<void(size_t shard,
+        const std::exception& e)>;
+
+private:
+
+    struct Shard;
+
+    // one listening socket, loop and thread per shard
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    // CPUs allowed by the process affinity mask, the k-th of them belongs
+    // to shard k % size() both for steering and for pinning
+    std::vector<int> cpus_;
+    std::atomic<bool> running_;
+    bool pin_threads_;
+    AcceptHandler handler_;
+    ErrorHandler on_error_;
+
+public:
+
+    // ctor & dtor, 0 shards means one per CPU in the affinity mask
+    ShardedServer(const Addr& addr, const Port& port, size_t shards = 0);
+    ShardedServer(const AddrPort& addrport, size_t shards = 0);
+    virtual ~ShardedServer();
+
+    // uncopyable & unmovable
+    ShardedServer(const ShardedServer&) = delete;
+    ShardedServer& operator=(const ShardedServer&) = delete;
+
+    // listen on every shard
+    void listen(int backlog = 20);
+
+    // let the kernel pick the shard of the CPU that received the
+    // connection, call after listen(). With fewer shards than CPUs a shard
+    // serves several CPUs, with more only the first ones get connections.
+    // CPUs outside the affinity mask go to shard cpu % size()
+    bool steer_by_cpu() noexcept;
+
+    // pin the thread of each shard to the CPUs steered to it, or share
+    // one with more shards than CPUs, enabled by default
+    void pin_threads(bool enable) noexcept;
+
+    // errors are dropped without a handler, call before start()
+    void on_error(ErrorHandler handler);
+
+    // start one loop thread per shard
+    void start(AcceptHandler handler);
+
+    // stop and join the loop threads
+    void stop() noexcept;
+
+    size_t size() const noexcept;
+    EventLoop& loop(size_t index);
+    AddrPort local() const noexcept;
+
+private:
+    void run_(size_t index);
+    void accept_(size_t index);
+    void report_(size_t index, const std::exception& e) noexcept;
+
+}; // class ShardedServer
+
+} // namespace nano
+
+#endif // NANO_LINUX
+
+#endif // NANONET_SHARDED_SERVER_H
@@ -25,15 +25,423 @@
  */
 
 #include "Socket.h"
+#include "EventLoop.h"
+#include "Resolver.h"
+
+// C++
+#include <algorithm>
+#include <exception>
+#include <new>
+#include <string>
+#include <utility>
+
+#ifdef NANO_LINUX
+#include <netinet/tcp.h>
+#endif
 
 namespace nano {
 
+#ifdef NANO_LINUX
+
+struct Socket::Cork {
+    Socket* owner;      // nullptr once the socket is gone
+    std::string buf;    // queued, not yet sent
+    size_t threshold;
+    int depth;          // nested cork() scopes
+    EventLoop* loop;    // auto_cork()
+    bool scheduled;     // a flush is deferred on loop
+    bool waiting;       // a deferred flush waits for the socket
+    bool held;          // the kernel holds a segment sent with MSG_MORE
+    std::exception_ptr error;   // of a deferred flush, for the next call
+};
+
+#endif
+
 // constructor
 Socket::Socket(bool create)
-    : TransSocket(create ? SOCK_STREAM : NULL_SOCKET) {}
+    : TransSocket(create ? SOCK_STREAM : NULL_SOCKET), zerocopy_(false),
+    zerocopy_next_(0), zerocopy_done_(0) {}
+
+Socket::Socket(Domain domain)
+    : TransSocket(SOCK_STREAM, domain), zerocopy_(false),
+    zerocopy_next_(0), zerocopy_done_(0) {}
+
+// the queue outlives the socket while a flush is deferred
+Socket::~Socket() {
+#ifdef NANO_LINUX
+    if (cork_) cork_->owner = nullptr;
+#endif
+}
+
+// move
+Socket::Socket(Socket&& other) noexcept
+        : TransSocket(std::move(other)), zerocopy_(other.zerocopy_),
+        zerocopy_next_(other.zerocopy_next_),
+        zerocopy_done_(other.zerocopy_done_) {
+#ifdef NANO_LINUX
+    cork_ = std::move(other.cork_);
+    if (cork_) cork_->owner = this;
+#endif
+}
+
+Socket& Socket::operator=(Socket&& other) noexcept {
+    if (this == &other) return *this;
+    TransSocket::operator=(std::move(other));
+    zerocopy_ = other.zerocopy_;
+    zerocopy_next_ = other.zerocopy_next_;
+    zerocopy_done_ = other.zerocopy_done_;
+#ifdef NANO_LINUX
+    if (cork_) cork_->owner = nullptr;
+    cork_ = std::move(other.cork_);
+    if (cork_) cork_->owner = this;
+#endif
+    return *this;
+}
+
+// happy eyeballs
+Socket Socket::connect_any(const std::vector<Addr>& addrs, const Port& port,
+        int timeout_ms, int stagger_ms) {
+    std::vector<sockaddr_storage> remotes(addrs.size());
+    for (size_t i = 0; i < addrs.size(); ++i)
+        AddrPort(addrs[i], port).to_sockaddr(remotes[i]);
+    size_t index = 0;
+    Socket ret(false);
+    ret.socket_ = connect_race(remotes.data(), remotes.size(),
+        timeout_ms, stagger_ms, &index);
+    assert_throw_nanoexcept(ret.socket_ != INVALID_SOCKET,
+        "[TCP] connect_any(): ", LAST_ERROR);
+    ret.domain_ = addrs[index].family();
+    ret.remote_ = AddrPort(addrs[index], port);
+    return ret;
+}
+
+Socket Socket::connect_any(std::string_view host, const Port& port,
+        int timeout_ms, int stagger_ms) {
+    std::vector<Addr> addrs;
+    int error = Resolver::global().resolve(host, addrs);
+    assert_throw_nanoexcept(error == 0,
+        "[TCP] connect_any(): ", Resolver::error_string(error));
+    // alternate the families, a broken one costs one stagger at most
+    std::vector<Addr> ipv4, ipv6, order;
+    for (const Addr& addr : addrs)
+        (addr.is_ipv4() ? ipv4 : ipv6).push_back(addr);
+    bool first_ipv4 = addrs.front().is_ipv4();
+    std::vector<Addr>& first = first_ipv4 ? ipv4 : ipv6;
+    std::vector<Addr>& second = first_ipv4 ? ipv6 : ipv4;
+    for (size_t i = 0; i < first.size() || i < second.size(); ++i) {
+        if (i < first.size()) order.push_back(first[i]);
+        if (i < second.size()) order.push_back(second[i]);
+    }
+    return connect_any(order, port, timeout_ms, stagger_ms);
+}
+
+// zero-copy file transmission
+size_t Socket::send_file(int fd, off_t offset, size_t count) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "send_file(): Socket is closed");
+#ifdef NANO_LINUX
+    // the file goes out behind the corked bytes
+    if (!this->drain_()) return 0;
+#endif
+    size_t sent = 0;
+    try {
+        sent = nano::send_file(socket_, fd, offset, count);
+    } catch (const NanoExcept& e) {
+        this->count_send_(IoResult{0, e.code()}, count);
+        throw_except(except_name(), "send_file(): ", e);
+    }
+    this->count_send_(sent, count);
+    return sent;
+}
+
+// MSG_ZEROCOPY
+bool Socket::zerocopy(bool enable) noexcept {
+#if defined(NANO_LINUX) && defined(SO_ZEROCOPY)
+    if (!this->set_option(SOL_SOCKET, SO_ZEROCOPY, enable ? 1 : 0))
+        return false;
+    zerocopy_ = enable;
+    return true;
+#else
+    return !enable;
+#endif
+}
+
+int Socket::send_zerocopy(const char* msg, size_t length, uint32_t& id) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "send_zerocopy(): Socket is closed");
+    id = ZEROCOPY_NONE;
+    if (!zerocopy_ || length < ZEROCOPY_MIN) return this->send(msg, length);
+#ifdef NANO_LINUX
+    if (!this->drain_()) return 0;
+    int ret = 0;
+    try {
+        ret = send_msg(socket_, msg, length, MSG_ZEROCOPY);
+    } catch (const NanoExcept& e) {
+        this->count_send_(IoResult{0, e.code()}, length);
+        throw_except(except_name(), "send_zerocopy(): ", e);
+    }
+    this->count_send_(IoResult{ret, 0}, length);
+    // the kernel numbers every successful zero-copy send
+    id = zerocopy_next_++;
+    return ret;
+#else
+    return 0; // never
+#endif
+}
+
+size_t Socket::reap_zerocopy(const ZerocopyCallback& callback) {
+    size_t done = 0;
+#ifdef NANO_LINUX
+    if (socket_ == INVALID_SOCKET) return 0;
+    uint32_t first = 0, last = 0;
+    bool copied = false;
+    int ret = 0;
+    while ((ret = recv_zerocopy_notice(socket_, &first, &last, &copied)) == 0) {
+        uint32_t count = last - first + 1;
+        zerocopy_done_ += count;
+        done += count;
+        if (callback) callback(first, last, copied);
+    }
+    assert_throw_nanoexcept(ret == -EAGAIN, except_name(),
+        "reap_zerocopy(): ", SysError(-ret));
+#endif
+    return done;
+}
+
+size_t Socket::reap_zerocopy(std::vector<uint32_t>& ids) {
+    return this->reap_zerocopy([&ids](uint32_t first, uint32_t last, bool) {
+        for (uint32_t id = first; id != last + 1; ++id) ids.push_back(id);
+    });
+}
+
+uint32_t Socket::zerocopy_pending() const noexcept {
+    return zerocopy_next_ - zerocopy_done_;
+}
 
 const char* Socket::except_name() const noexcept {
     return "[TCP] ";
 }
 
+#ifdef NANO_LINUX
+
+TcpInfo Socket::tcp_info() const {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "tcp_info(): Socket is closed");
+    struct ::tcp_info info {};
+    assert_throw_nanoexcept(this->get_option(IPPROTO_TCP, TCP_INFO, info),
+        except_name(), "tcp_info(): ", LAST_ERROR);
+    TcpInfo ret;
+    ret.state = info.tcpi_state;
+    ret.rtt_us = info.tcpi_rtt;
+    ret.rtt_var_us = info.tcpi_rttvar;
+    ret.snd_cwnd = info.tcpi_snd_cwnd;
+    ret.snd_ssthresh = info.tcpi_snd_ssthresh;
+    ret.snd_mss = info.tcpi_snd_mss;
+    ret.rcv_space = info.tcpi_rcv_space;
+    ret.unacked = info.tcpi_unacked;
+    ret.lost = info.tcpi_lost;
+    ret.retransmits = info.tcpi_retransmits;
+    ret.total_retrans = info.tcpi_total_retrans;
+    return ret;
+}
+
+// coalesce small sends
+void Socket::cork(size_t threshold) {
+    if (!cork_) cork_ = std::make_shared<Cork>(
+        Cork{this, {}, threshold, 0, nullptr, false, false, false, nullptr});
+    cork_->threshold = threshold;
+    ++cork_->depth;
+}
+
+void Socket::uncork() {
+    if (!cork_ || cork_->depth == 0) return;
+    if (--cork_->depth == 0) this->flush();
+    else this->rethrow_();
+}
+
+void Socket::auto_cork(EventLoop* loop, size_t threshold) {
+    if (!cork_) {
+        if (loop == nullptr) return;
+        cork_ = std::make_shared<Cork>(
+            Cork{this, {}, threshold, 0, nullptr, false, false, false, nullptr});
+    }
+    cork_->threshold = threshold;
+    cork_->loop = loop;
+    if (loop == nullptr && cork_->depth == 0) this->flush();
+}
+
+// write the queue without MSG_MORE, which pushes the held segment too
+size_t Socket::flush() {
+    this->rethrow_();
+    if (!cork_ || (cork_->buf.empty() && !cork_->held)) return 0;
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "flush(): Socket is closed");
+    Cork& cork = *cork_;
+    if (cork.buf.empty()) {
+        // nothing left to send it with, uncorking pushes it
+        this->set_option(IPPROTO_TCP, TCP_CORK, 0);
+        cork.held = false;
+        return 0;
+    }
+    iovec iov = {cork.buf.data(), cork.buf.size()};
+    size_t sent = this->write_(&iov, 1, 0);
+    cork.buf.erase(0, sent);
+    if (cork.buf.empty()) cork.held = false;
+    return sent;
+}
+
+size_t Socket::corked() const noexcept {
+    return cork_ ? cork_->buf.size() : 0;
+}
+
+int Socket::send(const char* msg, size_t length) {
+    this->rethrow_();
+    if (!this->corking_()) return TransSocket::send(msg, length);
+    iovec iov = {const_cast<char*>(msg), length};
+    return static_cast<int>(this->send(&iov, 1));
+}
+
+// queue the buffers, or send them with the queue once it is full, what
+// the socket does not take is queued, so all of it counts as sent
+size_t Socket::send(const iovec* iov, size_t count) {
+    this->rethrow_();
+    if (!this->corking_()) return TransSocket::send(iov, count);
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "Socket is closed");
+    Cork& cork = *cork_;
+    size_t length = 0;
+    for (size_t i = 0; i < count; ++i) length += iov[i].iov_len;
+    if (cork.buf.size() + length < cork.threshold) {
+        for (size_t i = 0; i < count; ++i)
+            cork.buf.append(static_cast<const char*>(iov[i].iov_base),
+                iov[i].iov_len);
+        this->schedule_();
+        return length;
+    }
+    // the queue goes first, in the same sendmsg
+    iovec local[16];
+    std::vector<iovec> heap;
+    iovec* all = local;
+    if (count + 1 > sizeof(local) / sizeof(local[0])) {
+        heap.resize(count + 1);
+        all = heap.data();
+    }
+    all[0] = {cork.buf.data(), cork.buf.size()};
+    std::copy(iov, iov + count, all + 1);
+    size_t sent = this->write_(all, count + 1, MSG_MORE);
+    if (sent > 0) cork.held = true;
+    // queue the rest
+    std::string rest;
+    for (size_t i = 0; i <= count; ++i) {
+        size_t skip = std::min(sent, all[i].iov_len);
+        sent -= skip;
+        rest.append(static_cast<const char*>(all[i].iov_base) + skip,
+            all[i].iov_len - skip);
+    }
+    cork.buf.swap(rest);
+    // the held segment needs a flush as well
+    this->schedule_();
+    return length;
+}
+
+void Socket::send_all(const char* msg, size_t length) {
+    this->rethrow_();
+    if (!this->corking_()) return TransSocket::send_all(msg, length);
+    bool queued = cork_->buf.size() + length < cork_->threshold;
+    iovec iov = {const_cast<char*>(msg), length};
+    this->send(&iov, 1);
+    // a non-blocking socket may have left a part of it behind
+    if (queued || cork_->buf.empty()) return;
+    try {
+        send_msg_all(socket_, cork_->buf.data(), cork_->buf.size());
+    } catch (const NanoExcept& e) {
+        this->count_send_(IoResult{0, e.code()}, cork_->buf.size());
+        throw_except(except_name(), "send_all(): ", e);
+    }
+    this->count_send_(cork_->buf.size(), cork_->buf.size());
+    cork_->buf.clear();
+    cork_->held = false;
+}
+
+IoResult Socket::try_send(const char* msg, size_t length) noexcept {
+    if (!this->corking_() && !(cork_ && cork_->error))
+        return TransSocket::try_send(msg, length);
+    if (socket_ == INVALID_SOCKET) return IoResult{0, EBADF};
+    try {
+        iovec iov = {const_cast<char*>(msg), length};
+        return IoResult{static_cast<int>(this->send(&iov, 1)), 0};
+    } catch (const NanoExcept& e) {
+        return IoResult{0, e.code() != 0 ? e.code() : EIO};
+    } catch (const std::bad_alloc&) {
+        // queueing copies the bytes
+        return IoResult{0, ENOMEM};
+    }
+}
+
+bool Socket::corking_() const noexcept {
+    return cork_ && (cork_->depth > 0 || cork_->loop != nullptr);
+}
+
+// report the failure of a deferred flush once
+void Socket::rethrow_() {
+    if (cork_ && cork_->error)
+        std::rethrow_exception(std::exchange(cork_->error, nullptr));
+}
+
+// flush once the callbacks of this iteration ran
+void Socket::schedule_() {
+    if (!cork_->loop || cork_->scheduled || cork_->waiting) return;
+    cork_->scheduled = true;
+    cork_->loop->defer([cork = cork_] {
+        cork->scheduled = false;
+        if (cork->owner && cork->depth == 0) cork->owner->flush_deferred_();
+    });
+}
+
+// flush on the loop, and again each time the socket drains until the
+// queue is empty, errors are kept for the next call
+void Socket::flush_deferred_() noexcept {
+    Cork& cork = *cork_;
+    try {
+        this->flush();
+        if (cork.buf.empty() || !cork.loop) return;
+        cork.waiting = true;
+        cork.loop->once_writable(socket_, [cork = cork_] {
+            cork->waiting = false;
+            if (cork->owner && cork->depth == 0)
+                cork->owner->flush_deferred_();
+        });
+    } catch (...) {
+        cork.error = std::current_exception();
+        cork.waiting = false;
+        cork.buf.clear();
+        cork.held = false;
+    }
+}
+
+size_t Socket::write_(const iovec* iov, size_t count, int flags) {
+    size_t length = 0;
+    for (size_t i = 0; i < count; ++i) length += iov[i].iov_len;
+    size_t sent = 0;
+    try {
+        sent = send_msg_iov(socket_, iov, count, flags);
+    } catch (const NanoExcept& e) {
+        this->count_send_(IoResult{0, e.code()}, length);
+        throw_except(except_name(), e);
+    }
+    this->count_send_(sent, length);
+    return sent;
+}
+
+// send the queue ahead of a send that bypasses it
+bool Socket::drain_() {
+    if (!cork_ || cork_->buf.empty()) return true;
+    iovec iov = {cork_->buf.data(), cork_->buf.size()};
+    cork_->buf.erase(0, this->write_(&iov, 1, MSG_MORE));
+    cork_->held = true;
+    return cork_->buf.empty();
+}
+
+#endif // NANO_LINUX
+
 } // namespace nano
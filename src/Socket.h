@@ -28,33 +28,166 @@
 #ifndef NANONET_SOCKET_H
 #define NANONET_SOCKET_H
 
+// C++
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
 // NanoNet
 #include "TransSocket.h"
 
 namespace nano {
 
+class EventLoop;
+
+#ifdef NANO_LINUX
+
+// Snapshot of TCP_INFO
+struct TcpInfo {
+    uint8_t state;          // TCP_ESTABLISHED, ...
+    uint32_t rtt_us;        // smoothed round-trip time
+    uint32_t rtt_var_us;
+    uint32_t snd_cwnd;      // congestion window in segments
+    uint32_t snd_ssthresh;
+    uint32_t snd_mss;
+    uint32_t rcv_space;     // receive window being advertised
+    uint32_t unacked;       // segments in flight
+    uint32_t lost;
+    uint32_t retransmits;   // retries of the oldest unacked segment
+    uint32_t total_retrans;
+}; // struct TcpInfo
+
+#endif
+
 class Socket : public TransSocket {
 
     // server socket
     friend class ServerSocket;
+    friend class IoUring;
+    friend class UnixSocket;
+
+public:
+
+    // id of a send that was copied and whose buffer is free at once
+    static constexpr uint32_t ZEROCOPY_NONE = UINT32_MAX;
+
+    // smaller payloads are cheaper to copy than to pin
+    static constexpr size_t ZEROCOPY_MIN = 16 * 1024;
+
+    // sends first..last are complete, copied is set if the kernel fell back
+    // to copying and zero-copy is not worth it on this route
+    using ZerocopyCallback = std::function<void(uint32_t first,
+        uint32_t last, bool copied)>;
+
+#ifdef NANO_LINUX
+    // sends are coalesced while corked until this many bytes are queued
+    static constexpr size_t CORK_THRESHOLD = 16 * 1024;
+#endif
+
+private:
+
+    // MSG_ZEROCOPY sends, ids are assigned in order from 0
+    bool zerocopy_;
+    uint32_t zerocopy_next_;
+    uint32_t zerocopy_done_;
+
+#ifdef NANO_LINUX
+    // coalesced sends, shared with the flush deferred on a loop
+    struct Cork;
+    std::shared_ptr<Cork> cork_;
+#endif
 
 public:
 
     // ctor & dtor
     Socket(bool create = true);
-    virtual ~Socket() = default;
+    explicit Socket(Domain domain);
+    virtual ~Socket();
 
     // move
-    Socket(Socket&&) = default;
-    Socket& operator=(Socket&&) = default;
+    Socket(Socket&& other) noexcept;
+    Socket& operator=(Socket&& other) noexcept;
 
     // uncopyable
     Socket(const Socket&) = delete;
     Socket& operator=(const Socket&) = delete;
 
+    // connect to the first address that answers, attempts are started in
+    // order every stagger_ms, or at once when the previous one fails, and
+    // timeout_ms bounds the whole race
+    static Socket connect_any(const std::vector<Addr>& addrs,
+        const Port& port, int timeout_ms = -1, int stagger_ms = 250);
+
+    // race every address the host resolves to
+    static Socket connect_any(std::string_view host, const Port& port,
+        int timeout_ms = -1, int stagger_ms = 250);
+
+    // send count bytes of a file from offset with sendfile, returns the
+    // bytes sent before a non-blocking socket would block
+    size_t send_file(int fd, off_t offset, size_t count);
+
+    // opt in to MSG_ZEROCOPY, returns false if the kernel does not support it
+    bool zerocopy(bool enable) noexcept;
+
+    // send from the pages of msg without copying them, msg must not be
+    // modified until id is reported by reap_zerocopy(), id is ZEROCOPY_NONE
+    // if the payload was copied as usual
+    int send_zerocopy(const char* msg, size_t length, uint32_t& id);
+
+    // reap completions from the error queue without blocking, call it when
+    // the socket reports an error event, returns the number of sends done
+    size_t reap_zerocopy(const ZerocopyCallback& callback);
+    size_t reap_zerocopy(std::vector<uint32_t>& ids);
+
+    // zero-copy sends whose buffers are still in use
+    uint32_t zerocopy_pending() const noexcept;
+
+#ifdef NANO_LINUX
+    // RTT, congestion window, retransmits and more of the connection
+    TcpInfo tcp_info() const;
+
+    // queue small sends until uncork(), then write them with one sendmsg,
+    // scopes nest, a send that fills the queue up to threshold goes out
+    // at once with the queue and MSG_MORE, queued bytes are dropped if
+    // the socket is closed first
+    void cork(size_t threshold = CORK_THRESHOLD);
+    void uncork();
+
+    // cork during every iteration of loop, the queue is flushed once the
+    // callbacks of the iteration ran, nullptr turns it off
+    void auto_cork(EventLoop* loop, size_t threshold = CORK_THRESHOLD);
+
+    // write the queue now, returns the bytes sent, fewer than corked()
+    // only if a non-blocking socket would block, flush again when writable,
+    // with auto_cork() the loop does so on its own
+    size_t flush();
+    size_t corked() const noexcept;
+
+    // the same as in TransSocket, but queued behind or with the corked bytes,
+    // an error of a flush deferred on the loop is thrown by the next of
+    // these, flush() or uncork()
+    using TransSocket::send;
+    virtual int send(const char* msg, size_t length) override;
+    virtual size_t send(const iovec* iov, size_t count) override;
+    virtual void send_all(const char* msg, size_t length) override;
+    virtual IoResult try_send(const char* msg, size_t length) noexcept override;
+#endif
+
 protected:
     virtual const char* except_name() const noexcept override;
 
+#ifdef NANO_LINUX
+private:
+    bool corking_() const noexcept;
+    void rethrow_();
+    void schedule_();
+    void flush_deferred_() noexcept;
+    size_t write_(const iovec* iov, size_t count, int flags);
+    bool drain_();
+#endif
+
 }; // class Socket
 
 } // namespace nano
@@ -29,21 +29,22 @@
 namespace nano {
 
 // constructor
-SocketBase::SocketBase(int type) : socket_(INVALID_SOCKET),
-        local_addr_(0U), local_port_(0U) {
+SocketBase::SocketBase(int type, int domain) : socket_(INVALID_SOCKET),
+        domain_(domain), local_(), stats_(nullptr) {
     if (type == NULL_SOCKET) return;
-    socket_ = ::socket(AF_INET, type, 0);
+    socket_ = ::socket(domain, type, 0);
     assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
     except_name(), "Create socket faild: ", LAST_ERROR);
 }
 
 SocketBase::SocketBase(SocketBase&& other) noexcept
         : socket_(other.socket_),
-        local_addr_(other.local_addr_),
-        local_port_(other.local_port_) {
+        domain_(other.domain_),
+        local_(other.local_),
+        stats_(other.stats_) {
     other.socket_ = INVALID_SOCKET;
-    other.local_addr_ = 0U;
-    other.local_port_ = 0U;
+    other.stats_ = nullptr;
+    other.local_ = AddrPort();
 }
 
 SocketBase& SocketBase::operator=(SocketBase&& other) noexcept {
@@ -51,12 +52,13 @@ SocketBase& SocketBase::operator=(SocketBase&& other) noexcept {
     this->close();
     // copy
     socket_ = other.socket_;
-    local_addr_ = other.local_addr_;
-    local_port_ = other.local_port_;
+    domain_ = other.domain_;
+    local_ = other.local_;
+    stats_ = other.stats_;
     // clear other
     other.socket_ = INVALID_SOCKET;
-    other.local_addr_ = 0U;
-    other.local_port_ = 0U;
+    other.local_ = AddrPort();
+    other.stats_ = nullptr;
     return *this;
 }
 
@@ -80,10 +82,24 @@ sock_t SocketBase::get() const noexcept {
     return socket_;
 }
 
+sock_t SocketBase::release() noexcept {
+    sock_t socket = socket_;
+    socket_ = INVALID_SOCKET;
+    return socket;
+}
+
+int SocketBase::domain() const noexcept {
+    return domain_;
+}
+
 void SocketBase::bind(const Addr& addr, const Port& port) {
     assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
         except_name(), "bind(): Socket is closed");
-    assert_throw_nanoexcept(bind_address(socket_, addr.get(), port.get()),
+    this->match_domain_(addr);
+    sockaddr_storage local;
+    socklen_t len = AddrPort(addr, port).to_sockaddr(local, domain_);
+    assert_throw_nanoexcept(bind_address(socket_,
+        reinterpret_cast<const sockaddr*>(&local), len),
         except_name(), "bind(): Bind address \'",
         AddrPort(addr, port).to_string(), "\' failed: ", LAST_ERROR);
 }
@@ -92,9 +108,19 @@ void SocketBase::bind(const AddrPort& addrport) {
     this->bind(addrport.addr(), addrport.port());
 }
 
+bool SocketBase::dual_stack(bool enable) noexcept {
+    return domain_ == AF_INET6
+        && this->set_option(IPPROTO_IPV6, IPV6_V6ONLY, (int)!enable);
+}
+
 // get local
 AddrPort SocketBase::local() const noexcept {
-    return AddrPort(addr_ntoh(local_addr_), port_ntoh(local_port_));
+    if (local_.port() == 0 && socket_ != INVALID_SOCKET) {
+        sockaddr_storage local;
+        get_local_address(socket_, &local);
+        local_ = AddrPort::from_sockaddr(local);
+    }
+    return local_;
 }
 
 // blocking
@@ -104,8 +130,26 @@ bool SocketBase::set_blocking(bool blocking) {
     return nano::set_blocking(socket_, blocking);
 }
 
+void SocketBase::stats(SocketStats* stats) noexcept {
+    stats_ = stats;
+}
+
+SocketStats* SocketBase::stats() const noexcept {
+    return stats_;
+}
+
 const char* SocketBase::except_name() const noexcept {
     return "[socket] ";
 }
 
+// IPv6 sockets reach IPv4 through mapped addresses, not the other way,
+// the socket is never replaced since its options, blocking mode and
+// event loop registration belong to the descriptor
+void SocketBase::match_domain_(const Addr& addr) const {
+    if (domain_ == AF_INET6 || (domain_ == AF_INET && addr.is_ipv4())) return;
+    throw_except(except_name(), "Address \'", addr.to_string(),
+        "\' does not fit the ", domain_ == AF_INET ? "IPv4" : "non-IP",
+        " socket, create it with the domain of the address");
+}
+
 } // namespace nano
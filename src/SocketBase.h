@@ -30,6 +30,7 @@
 
 // NanoNet
 #include "AddrPort.h"
+#include "SocketStats.h"
 
 #ifdef NANO_LINUX
 
@@ -50,15 +51,18 @@ class SocketBase {
 protected:
 
     sock_t socket_;
+    int domain_;
 
-    // local address
-    addr_t local_addr_;
-    port_t local_port_;
+    // local address, queried on first use when unknown
+    mutable AddrPort local_;
+
+    // I/O counters, none by default
+    SocketStats* stats_;
 
 protected:
 
     // ctor & dtor
-    SocketBase(int type);
+    SocketBase(int type, int domain = AF_INET);
     virtual ~SocketBase() = default;
 
     // move
@@ -76,16 +80,31 @@ public:
     bool is_open() const noexcept;
     sock_t get() const noexcept;
 
-    // bind local
+    // detach the socket without closing it
+    sock_t release() noexcept;
+
+    // AF_INET, AF_INET6 or AF_UNIX
+    int domain() const noexcept;
+
+    // bind local, an IPv4 socket cannot bind an IPv6 address, create it
+    // with Domain::IPv6 instead
     void bind(const Addr& addr, const Port& port);
     void bind(const AddrPort& addrport);
 
+    // accept IPv4 on an IPv6 socket as mapped addresses, call before bind()
+    bool dual_stack(bool enable) noexcept;
+
     // get local
     AddrPort local() const noexcept;
 
     // blocking
     bool set_blocking(bool blocking);
 
+    // count the I/O of this socket into stats, which must outlive it or
+    // be detached with nullptr first, follows the socket when moved
+    void stats(SocketStats* stats) noexcept;
+    SocketStats* stats() const noexcept;
+
     // socket option
     template <class Ty>
     inline bool set_option(int level, int optname, const Ty& optval) const {
@@ -113,6 +132,29 @@ public:
 protected:
     virtual const char* except_name() const noexcept;
 
+    // throw if the socket cannot reach addr
+    void match_domain_(const Addr& addr) const;
+
+    // I/O accounting, a null check without stats
+    void count_send_(const IoResult& ret, size_t length) const noexcept {
+        if (stats_) stats_->on_send(ret, length);
+    }
+
+    void count_send_(size_t sent, size_t length) const noexcept {
+        if (stats_) stats_->on_send(sent, length);
+    }
+
+    void count_receive_(const IoResult& ret) const noexcept {
+        if (stats_) stats_->on_receive(ret);
+    }
+
+    // for calls returning the bytes or -ERR_CODE
+    int count_receive_(int ret) const noexcept {
+        if (stats_) stats_->on_receive(ret < 0
+            ? IoResult{0, -ret} : IoResult{ret, 0});
+        return ret;
+    }
+
 }; // class SocketBase
 
 } // namespace nano
@@ -0,0 +1,153 @@
+// File:     src/SocketStats.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SocketStats.h"
+
+// C++
+#include <mutex>
+#include <utility>
+
+namespace nano {
+
+namespace {
+
+// the live SocketStats and the counts of the destroyed ones
+struct Registry {
+    std::mutex mutex;
+    SocketStats* head = nullptr;
+    IoStats retired;
+};
+
+Registry& registry_() {
+    static Registry registry;
+    return registry;
+}
+
+} // anonymous namespace
+
+IoStats& IoStats::operator+=(const IoStats& other) noexcept {
+    bytes_in += other.bytes_in;
+    bytes_out += other.bytes_out;
+    recv_calls += other.recv_calls;
+    send_calls += other.send_calls;
+    would_block += other.would_block;
+    short_writes += other.short_writes;
+    errors += other.errors;
+    return *this;
+}
+
+// e.g. the traffic between two dumps
+IoStats IoStats::operator-(const IoStats& other) const noexcept {
+    IoStats ret;
+    ret.bytes_in = bytes_in - other.bytes_in;
+    ret.bytes_out = bytes_out - other.bytes_out;
+    ret.recv_calls = recv_calls - other.recv_calls;
+    ret.send_calls = send_calls - other.send_calls;
+    ret.would_block = would_block - other.would_block;
+    ret.short_writes = short_writes - other.short_writes;
+    ret.errors = errors - other.errors;
+    return ret;
+}
+
+// ctor & dtor
+SocketStats::SocketStats(std::string name) : bytes_in_(0), bytes_out_(0),
+        recv_calls_(0), send_calls_(0), would_block_(0), short_writes_(0),
+        errors_(0), name_(std::move(name)), prev_(nullptr), next_(nullptr) {
+    Registry& registry = registry_();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    next_ = registry.head;
+    if (next_) next_->prev_ = this;
+    registry.head = this;
+}
+
+SocketStats::~SocketStats() {
+    Registry& registry = registry_();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (prev_) prev_->next_ = next_;
+    else registry.head = next_;
+    if (next_) next_->prev_ = prev_;
+    registry.retired += this->snapshot();
+}
+
+const std::string& SocketStats::name() const noexcept {
+    return name_;
+}
+
+void SocketStats::on_send(const IoResult& ret, size_t length) noexcept {
+    add_(send_calls_, 1);
+    if (!ret.ok()) return this->count_error_(ret.error);
+    add_(bytes_out_, static_cast<uint64_t>(ret.bytes));
+    if (static_cast<size_t>(ret.bytes) < length) add_(short_writes_, 1);
+}
+
+void SocketStats::on_send(size_t sent, size_t length) noexcept {
+    add_(send_calls_, 1);
+    add_(bytes_out_, sent);
+    if (sent == 0 && length > 0) add_(would_block_, 1);
+    else if (sent < length) add_(short_writes_, 1);
+}
+
+void SocketStats::on_receive(const IoResult& ret) noexcept {
+    add_(recv_calls_, 1);
+    if (!ret.ok()) return this->count_error_(ret.error);
+    add_(bytes_in_, static_cast<uint64_t>(ret.bytes));
+}
+
+void SocketStats::count_error_(int error) noexcept {
+    if (IoResult{0, error}.would_block()) add_(would_block_, 1);
+    else add_(errors_, 1);
+}
+
+IoStats SocketStats::snapshot() const noexcept {
+    IoStats ret;
+    ret.bytes_in = bytes_in_.load(std::memory_order_relaxed);
+    ret.bytes_out = bytes_out_.load(std::memory_order_relaxed);
+    ret.recv_calls = recv_calls_.load(std::memory_order_relaxed);
+    ret.send_calls = send_calls_.load(std::memory_order_relaxed);
+    ret.would_block = would_block_.load(std::memory_order_relaxed);
+    ret.short_writes = short_writes_.load(std::memory_order_relaxed);
+    ret.errors = errors_.load(std::memory_order_relaxed);
+    return ret;
+}
+
+IoStats SocketStats::total() {
+    Registry& registry = registry_();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    IoStats ret = registry.retired;
+    for (SocketStats* stats = registry.head; stats; stats = stats->next_)
+        ret += stats->snapshot();
+    return ret;
+}
+
+void SocketStats::for_each(
+        const std::function<void(const SocketStats&)>& callback) {
+    Registry& registry = registry_();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (SocketStats* stats = registry.head; stats; stats = stats->next_)
+        callback(*stats);
+}
+
+} // namespace nano
@@ -0,0 +1,129 @@
+// File:     src/SocketStats.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_SOCKET_STATS_H
+#define NANONET_SOCKET_STATS_H
+
+// C++
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// NanoNet
+#include "net.h"
+
+namespace nano {
+
+// Plain copy of the counters of a SocketStats
+struct IoStats {
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+
+    // send & receive calls that reached the kernel
+    uint64_t recv_calls = 0;
+    uint64_t send_calls = 0;
+
+    // calls a non-blocking socket turned down
+    uint64_t would_block = 0;
+
+    // sends that took only a part of the bytes
+    uint64_t short_writes = 0;
+
+    // failed calls other than would_block
+    uint64_t errors = 0;
+
+    IoStats& operator+=(const IoStats& other) noexcept;
+    IoStats operator-(const IoStats& other) const noexcept;
+
+}; // struct IoStats
+
+// I/O counters attached to sockets with SocketBase::stats(), a socket
+// without counters pays a null check per call, every SocketStats is
+// listed process-wide for a periodic dump
+class SocketStats {
+
+    // a single thread writes, any thread reads, no atomic add needed
+    using counter_t = std::atomic<uint64_t>;
+
+    counter_t bytes_in_;
+    counter_t bytes_out_;
+    counter_t recv_calls_;
+    counter_t send_calls_;
+    counter_t would_block_;
+    counter_t short_writes_;
+    counter_t errors_;
+
+    std::string name_;
+
+    // process-wide list
+    SocketStats* prev_;
+    SocketStats* next_;
+
+    static void add_(counter_t& counter, uint64_t value) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+            std::memory_order_relaxed);
+    }
+
+    void count_error_(int error) noexcept;
+
+public:
+
+    // ctor & dtor, the counts of a destroyed SocketStats stay in total()
+    explicit SocketStats(std::string name = "");
+    ~SocketStats();
+
+    // uncopyable & unmovable
+    SocketStats(const SocketStats&) = delete;
+    SocketStats& operator=(const SocketStats&) = delete;
+
+    const std::string& name() const noexcept;
+
+    // called by the sockets, share one SocketStats only between sockets
+    // used by the same thread, e.g. all of one EventLoop
+    void on_send(const IoResult& ret, size_t length) noexcept;
+    void on_receive(const IoResult& ret) noexcept;
+
+    // for sends returning the bytes sent before the socket would block
+    void on_send(size_t sent, size_t length) noexcept;
+
+    // the counts so far, safe from any thread
+    IoStats snapshot() const noexcept;
+
+    // the sum of every SocketStats of the process, alive or not
+    static IoStats total();
+
+    // visit the live SocketStats, e.g. to find slow peers, callback must
+    // not create or destroy a SocketStats
+    static void for_each(
+        const std::function<void(const SocketStats&)>& callback);
+
+}; // class SocketStats
+
+} // namespace nano
+
+#endif // NANONET_SOCKET_STATS_H
@@ -0,0 +1,317 @@
+// File:     src/TimerWheel.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TimerWheel.h"
+
+#ifdef NANO_LINUX
+
+// C++
+#include <algorithm>
+
+// Linux
+#include <sys/timerfd.h>
+
+// NanoNet
+#include "EventLoop.h"
+
+namespace nano {
+
+namespace {
+
+// no tick armed
+constexpr uint64_t NEVER = UINT64_MAX;
+
+constexpr size_t SLOT_BITS = 8;
+constexpr uint64_t SLOT_MASK = TimerWheel::SLOTS - 1;
+
+} // anonymous namespace
+
+// constructor
+TimerWheel::TimerWheel(std::chrono::milliseconds tick)
+        : free_(NIL), level_size_(), size_(0),
+        tick_(std::max(tick, std::chrono::milliseconds(1))),
+        start_(std::chrono::steady_clock::now()), now_(0),
+        timer_fd_(::timerfd_create(CLOCK_MONOTONIC,
+            TFD_NONBLOCK | TFD_CLOEXEC)),
+        armed_(NEVER), loop_(nullptr) {
+    assert_throw_nanoexcept(timer_fd_ != -1,
+        "[TimerWheel] timerfd_create(): ", LAST_ERROR);
+    std::fill(std::begin(slots_), std::end(slots_), NIL);
+}
+
+TimerWheel::~TimerWheel() {
+    this->detach();
+    ::close(timer_fd_);
+}
+
+// add a timer
+TimerWheel::TimerId TimerWheel::add(std::chrono::milliseconds delay,
+        Callback callback) {
+    uint32_t index = free_;
+    if (index == NIL) {
+        assert_throw_nanoexcept(nodes_.size() < NIL,
+            "[TimerWheel] add(): Too many timers");
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(Node{nullptr, 0, 1, NIL, NIL, NIL});
+    } else {
+        free_ = nodes_[index].next;
+    }
+    Node& node = nodes_[index];
+    node.callback = std::move(callback);
+    ++size_;
+    this->reschedule((static_cast<TimerId>(index) << 32) | node.generation,
+        delay);
+    return (static_cast<TimerId>(index) << 32) | node.generation;
+}
+
+bool TimerWheel::cancel(TimerId id) noexcept {
+    Node* node = this->find_(id);
+    if (node == nullptr || node->slot == NIL) return false;
+    uint32_t index = static_cast<uint32_t>(id >> 32);
+    this->unlink_(index);
+    this->release_(index);
+    return true;
+}
+
+bool TimerWheel::reschedule(TimerId id,
+        std::chrono::milliseconds delay) noexcept {
+    Node* node = this->find_(id);
+    if (node == nullptr) return false;
+    uint32_t index = static_cast<uint32_t>(id >> 32);
+    // round up to a tick boundary, so a timer never runs early
+    auto at = std::chrono::steady_clock::now() - start_
+        + std::max(delay, std::chrono::milliseconds(0));
+    uint64_t expires = static_cast<uint64_t>(
+        (at.count() + tick_.count() - 1) / tick_.count());
+    if (node->slot != NIL) this->unlink_(index);
+    // after now_, so a timer added by a callback runs on a later tick
+    node->expires = std::max(expires, now_ + 1);
+    this->link_(index);
+    // the timerfd is only touched when the first deadline moves earlier
+    uint64_t due = node->expires;
+    if (node->slot >= SLOTS) {
+        // the tick its slot is cascaded
+        size_t shift = SLOT_BITS * (node->slot / SLOTS);
+        uint64_t base = now_ >> shift;
+        due = (base + (((node->expires >> shift) - base - 1) & SLOT_MASK) + 1)
+            << shift;
+    }
+    if (due < armed_) this->arm_(due);
+    return true;
+}
+
+bool TimerWheel::contains(TimerId id) const noexcept {
+    uint32_t index = static_cast<uint32_t>(id >> 32);
+    return index < nodes_.size()
+        && nodes_[index].generation == static_cast<uint32_t>(id)
+        && nodes_[index].slot != NIL;
+}
+
+size_t TimerWheel::size() const noexcept {
+    return size_;
+}
+
+// run the timers that are due
+size_t TimerWheel::advance() {
+    uint64_t target = this->current_tick_();
+    // left over if a callback threw
+    size_t ran = this->expire_(now_ & SLOT_MASK);
+    while (now_ < target) {
+        if (size_ == 0) {
+            now_ = target;
+            break;
+        }
+        // nothing to do before the next cascade, skip the empty ticks
+        if (level_size_[0] == 0) {
+            now_ = std::min(target, this->next_tick_() - 1);
+            if (now_ == target) break;
+        }
+        ++now_;
+        size_t slot = now_ & SLOT_MASK;
+        if (slot == 0) {
+            for (size_t level = 1; level < LEVELS; ++level) {
+                size_t index = (now_ >> (SLOT_BITS * level)) & SLOT_MASK;
+                this->cascade_(level, index);
+                if (index != 0) break;
+            }
+        }
+        ran += this->expire_(slot);
+    }
+    this->arm_(this->next_tick_());
+    return ran;
+}
+
+int TimerWheel::next_timeout() const noexcept {
+    uint64_t tick = this->next_tick_();
+    if (tick == NEVER) return -1;
+    auto left = start_ + tick_ * tick - std::chrono::steady_clock::now();
+    if (left.count() <= 0) return 0;
+    // round up, waking early would find nothing to do
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(
+        left).count());
+}
+
+int TimerWheel::fd() const noexcept {
+    return timer_fd_;
+}
+
+// event loop
+void TimerWheel::attach(EventLoop& loop) {
+    this->detach();
+    loop.add(timer_fd_, EventLoop::READABLE, [this] {
+        uint64_t expirations;
+        while (::read(timer_fd_, &expirations, sizeof(expirations)) > 0) {}
+        // the timer is one-shot, it is no longer armed
+        armed_ = NEVER;
+        this->advance();
+    });
+    loop_ = &loop;
+}
+
+void TimerWheel::detach() noexcept {
+    if (loop_ == nullptr) return;
+    loop_->remove(timer_fd_);
+    loop_ = nullptr;
+}
+
+uint64_t TimerWheel::current_tick_() const noexcept {
+    return static_cast<uint64_t>(
+        (std::chrono::steady_clock::now() - start_) / tick_);
+}
+
+// the next tick that expires timers or cascades them
+uint64_t TimerWheel::next_tick_() const noexcept {
+    if (size_ == 0) return NEVER;
+    uint64_t next = NEVER;
+    // the first non-empty slot of a level is cascaded when its index
+    // comes up next
+    for (size_t level = 1; level < LEVELS; ++level) {
+        if (level_size_[level] == 0) continue;
+        size_t shift = SLOT_BITS * level;
+        uint64_t base = now_ >> shift;
+        for (uint64_t index = base + 1; index <= base + SLOTS; ++index) {
+            if (slots_[level * SLOTS + (index & SLOT_MASK)] != NIL) {
+                next = std::min(next, index << shift);
+                break;
+            }
+        }
+    }
+    if (level_size_[0] > 0) {
+        for (uint64_t tick = now_; tick < now_ + SLOTS; ++tick) {
+            if (slots_[tick & SLOT_MASK] != NIL)
+                return std::min(next, tick);
+        }
+    }
+    return next;
+}
+
+TimerWheel::Node* TimerWheel::find_(TimerId id) noexcept {
+    uint32_t index = static_cast<uint32_t>(id >> 32);
+    if (index >= nodes_.size()) return nullptr;
+    Node& node = nodes_[index];
+    if (node.generation != static_cast<uint32_t>(id)) return nullptr;
+    return &node;
+}
+
+// put a node in the slot of its expiry, relative to now_
+void TimerWheel::link_(uint32_t index) noexcept {
+    Node& node = nodes_[index];
+    uint64_t delta = node.expires > now_ ? node.expires - now_ : 0;
+    size_t level = 0;
+    while (level + 1 < LEVELS && delta >= (1ULL << (SLOT_BITS * (level + 1))))
+        ++level;
+    // beyond the last level, the node comes back up when cascaded
+    node.slot = static_cast<uint32_t>(level * SLOTS
+        + ((node.expires >> (SLOT_BITS * level)) & SLOT_MASK));
+    node.prev = NIL;
+    node.next = slots_[node.slot];
+    if (node.next != NIL) nodes_[node.next].prev = index;
+    slots_[node.slot] = index;
+    ++level_size_[level];
+}
+
+void TimerWheel::unlink_(uint32_t index) noexcept {
+    Node& node = nodes_[index];
+    if (node.prev != NIL) nodes_[node.prev].next = node.next;
+    else slots_[node.slot] = node.next;
+    if (node.next != NIL) nodes_[node.next].prev = node.prev;
+    --level_size_[node.slot / SLOTS];
+    node.slot = NIL;
+}
+
+// back to the pool, the new generation invalidates the old id
+void TimerWheel::release_(uint32_t index) noexcept {
+    Node& node = nodes_[index];
+    node.callback = nullptr;
+    if (++node.generation == 0) node.generation = 1;
+    node.next = free_;
+    free_ = index;
+    --size_;
+}
+
+// move the nodes of a slot to the lower levels
+void TimerWheel::cascade_(size_t level, size_t slot) noexcept {
+    uint32_t index = slots_[level * SLOTS + slot];
+    slots_[level * SLOTS + slot] = NIL;
+    while (index != NIL) {
+        uint32_t next = nodes_[index].next;
+        --level_size_[level];
+        this->link_(index);
+        index = next;
+    }
+}
+
+// run the nodes of a level 0 slot
+size_t TimerWheel::expire_(size_t slot) {
+    size_t ran = 0;
+    while (slots_[slot] != NIL) {
+        uint32_t index = slots_[slot];
+        this->unlink_(index);
+        Callback callback = std::move(nodes_[index].callback);
+        this->release_(index);
+        ++ran;
+        if (callback) callback();
+    }
+    return ran;
+}
+
+// wake up at a tick, or never
+void TimerWheel::arm_(uint64_t tick) noexcept {
+    if (tick == armed_) return;
+    armed_ = tick;
+    itimerspec spec {};
+    if (tick != NEVER) {
+        auto when = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            (start_ + tick_ * tick).time_since_epoch()).count();
+        spec.it_value.tv_sec = when / 1000000000;
+        spec.it_value.tv_nsec = when % 1000000000;
+    }
+    ::timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+} // namespace nano
+
+#endif // NANO_LINUX
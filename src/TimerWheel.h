@@ -0,0 +1,142 @@
+// File:     src/TimerWheel.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_TIMER_WHEEL_H
+#define NANONET_TIMER_WHEEL_H
+
+// C++
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// NanoNet
+#include "net.h"
+
+#ifdef NANO_LINUX
+
+namespace nano {
+
+class EventLoop;
+
+class TimerWheel {
+public:
+
+    // slot index << 32 | generation, 0 is never a valid id
+    using TimerId = uint64_t;
+
+    using Callback = std::function<void()>;
+
+    // 4 levels of 256 slots cover 2^32 ticks
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOTS = 256;
+
+private:
+
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    // pooled timer, linked into the list of its slot
+    struct Node {
+        Callback callback;
+        uint64_t expires;
+        uint32_t generation;
+        uint32_t prev;
+        uint32_t next;
+        uint32_t slot;
+    };
+
+    std::vector<Node> nodes_;
+    uint32_t free_;
+    uint32_t slots_[LEVELS * SLOTS];
+    size_t level_size_[LEVELS];
+    size_t size_;
+
+    // time in ticks since start_
+    std::chrono::steady_clock::duration tick_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t now_;
+
+    // timerfd armed for the tick armed_
+    int timer_fd_;
+    uint64_t armed_;
+    EventLoop* loop_;
+
+public:
+
+    // ctor & dtor
+    TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(1));
+    virtual ~TimerWheel();
+
+    // uncopyable & unmovable
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // run callback once after delay, rounded up to whole ticks
+    TimerId add(std::chrono::milliseconds delay, Callback callback);
+
+    // stop a pending timer, false if it already ran or was canceled
+    bool cancel(TimerId id) noexcept;
+
+    // move a pending timer to delay from now, e.g. an idle timeout on
+    // activity, false if it already ran or was canceled
+    bool reschedule(TimerId id, std::chrono::milliseconds delay) noexcept;
+
+    bool contains(TimerId id) const noexcept;
+    size_t size() const noexcept;
+
+    // run the timers that are due, returns the number run
+    size_t advance();
+
+    // milliseconds until the next tick with work to do, -1 if none,
+    // for a loop that does not use the timerfd
+    int next_timeout() const noexcept;
+
+    // timerfd readable when advance() has work to do
+    int fd() const noexcept;
+
+    // run the timers on the loop thread, call both from the loop thread
+    void attach(EventLoop& loop);
+    void detach() noexcept;
+
+private:
+    uint64_t current_tick_() const noexcept;
+    uint64_t next_tick_() const noexcept;
+    Node* find_(TimerId id) noexcept;
+    void link_(uint32_t index) noexcept;
+    void unlink_(uint32_t index) noexcept;
+    void release_(uint32_t index) noexcept;
+    void cascade_(size_t level, size_t slot) noexcept;
+    size_t expire_(size_t slot);
+    void arm_(uint64_t tick) noexcept;
+
+}; // class TimerWheel
+
+} // namespace nano
+
+#endif // NANO_LINUX
+
+#endif // NANONET_TIMER_WHEEL_H
@@ -28,56 +28,141 @@
 
 namespace nano {
 
-TransSocket::TransSocket(int type) : SocketBase(type),
-    remote_addr_(0U), remote_port_(0U) {}
+TransSocket::TransSocket(int type, int domain) : SocketBase(type, domain),
+    remote_() {}
 
 TransSocket::TransSocket(TransSocket&& other) noexcept
         : SocketBase(std::move(other)),
-        remote_addr_(other.remote_addr_),
-        remote_port_(other.remote_port_) {
-    other.remote_addr_ = 0U;
-    other.remote_port_ = 0U;
+        remote_(other.remote_) {
+    other.remote_ = AddrPort();
 }
 
 TransSocket& TransSocket::operator=(TransSocket&& other) noexcept {
     SocketBase::operator=(std::move(other));
     // copy
-    remote_addr_ = other.remote_addr_;
-    remote_port_ = other.remote_port_;
+    remote_ = other.remote_;
     // clear
-    other.remote_addr_ = 0U;
-    other.remote_port_ = 0U;
+    other.remote_ = AddrPort();
     return *this;
 }
 
 AddrPort TransSocket::remote() const noexcept {
-    return AddrPort(addr_ntoh(remote_addr_), port_ntoh(remote_port_));
+    if (remote_.port() == 0 && socket_ != INVALID_SOCKET) {
+        sockaddr_storage remote;
+        get_remote_address(socket_, &remote);
+        remote_ = AddrPort::from_sockaddr(remote);
+    }
+    return remote_;
 }
 
 void TransSocket::connect(const Addr& addr, const Port& port) {
-    // set remote
+    this->connect(addr, port, -1);
+}
+
+void TransSocket::connect(const Addr& addr, const Port& port,
+        int timeout_ms) {
     assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
         except_name(), "connect(): Socket is closed");
-    // connect to remote
-    assert_throw_nanoexcept(connect_to(socket_, addr.get(), port.get()),
+    this->match_domain_(addr);
+    sockaddr_storage remote;
+    socklen_t len = AddrPort(addr, port).to_sockaddr(remote, domain_);
+    // connect to remote, a deadline replaces the kernel SYN retries
+    assert_throw_nanoexcept(connect_to(socket_,
+        reinterpret_cast<const sockaddr*>(&remote), len, timeout_ms),
         except_name(), "connect(): ", LAST_ERROR);
-    // get local address and port
-    get_local_address(socket_, &local_addr_, &local_port_);
+    // set remote, the local address is queried on first use
+    remote_ = AddrPort(addr, port);
 }
 
 int TransSocket::send(const char* msg, size_t length) {
     assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
         except_name(), "Socket is closed");
+    IoResult ret = this->try_send(msg, length);
+    assert_throw_nanoexcept(ret.ok(), except_name(), SysError(ret.error));
+    return ret.bytes;
+}
+
+int TransSocket::receive(char* buf, size_t buf_size) {
+    return this->count_receive_(recv_msg(socket_, buf, buf_size));
+}
+
+void TransSocket::send_all(const char* msg, size_t length) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "send_all(): Socket is closed");
     try {
-        return send_msg(socket_, msg, length);
+        send_msg_all(socket_, msg, length);
     } catch (const NanoExcept& e) {
-        throw_except(except_name(), e.what());
+        this->count_send_(IoResult{0, e.code()}, length);
+        throw_except(except_name(), "send_all(): ", e);
     }
-    return 0; // never
+    this->count_send_(length, length);
 }
 
-int TransSocket::receive(char* buf, size_t buf_size) {
-    return recv_msg(socket_, buf, buf_size);
+int TransSocket::receive_exact(char* buf, size_t length) {
+    return this->count_receive_(recv_msg_all(socket_, buf, length));
+}
+
+IoResult TransSocket::try_send(const char* msg, size_t length) noexcept {
+    IoResult ret = try_send_msg(socket_, msg, length);
+    this->count_send_(ret, length);
+    return ret;
+}
+
+IoResult TransSocket::try_receive(char* buf, size_t buf_size) noexcept {
+    IoResult ret = try_recv_msg(socket_, buf, buf_size);
+    this->count_receive_(ret);
+    return ret;
+}
+
+#ifdef NANO_LINUX
+
+// scatter & gather
+size_t TransSocket::send(const iovec* iov, size_t count) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "Socket is closed");
+    size_t length = 0;
+    for (size_t i = 0; i < count; ++i) length += iov[i].iov_len;
+    size_t sent = 0;
+    try {
+        sent = send_msg_iov(socket_, iov, count);
+    } catch (const NanoExcept& e) {
+        this->count_send_(IoResult{0, e.code()}, length);
+        throw_except(except_name(), e);
+    }
+    this->count_send_(sent, length);
+    return sent;
+}
+
+int TransSocket::receive(iovec* iov, size_t count) {
+    ssize_t ret = recv_msg_iov(socket_, iov, count);
+    return this->count_receive_(static_cast<int>(ret));
+}
+
+#endif
+
+size_t TransSocket::send(std::initializer_list<std::string_view> bufs) {
+#ifdef NANO_LINUX
+    // no allocation for the common case of a few buffers
+    iovec local[16];
+    std::vector<iovec> heap;
+    iovec* iov = local;
+    if (bufs.size() > sizeof(local) / sizeof(local[0])) {
+        heap.resize(bufs.size());
+        iov = heap.data();
+    }
+    size_t count = 0;
+    for (std::string_view buf : bufs)
+        iov[count++] = {const_cast<char*>(buf.data()), buf.size()};
+    return this->send(iov, count);
+#elif NANO_WINDOWS
+    size_t sent = 0;
+    for (std::string_view buf : bufs) {
+        for (size_t done = 0; done < buf.size();)
+            done += this->send(buf.data() + done, buf.size() - done);
+        sent += buf.size();
+    }
+    return sent;
+#endif
 }
 
 bool TransSocket::recv_timeout(long ms) const noexcept {
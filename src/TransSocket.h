@@ -28,18 +28,22 @@
 #ifndef NANONET_TRANSPORT_SOCKET_H
 #define NANONET_TRANSPORT_SOCKET_H
 
+// C++
+#include <initializer_list>
+#include <string_view>
+
+// NanoNet
 #include "SocketBase.h"
 
 namespace nano {
 
 class TransSocket : public SocketBase {
 protected:
-    // remote address
-    addr_t remote_addr_;
-    port_t remote_port_;
+    // remote address, queried on first use when unknown
+    mutable AddrPort remote_;
 
     // ctor & dtor
-    TransSocket(int type);
+    TransSocket(int type, int domain = AF_INET);
     virtual ~TransSocket() = default;
 
     // move
@@ -54,11 +58,42 @@ public:
 
     AddrPort remote() const noexcept;
 
-    // connect to remote
+    // connect to remote, an IPv6 remote needs a socket created with
+    // Domain::IPv6, which reaches IPv4 remotes too
     void connect(const Addr& addr, const Port& port);
-    int send(const char* msg, size_t length);
+
+    // fail with ETIMEDOUT if not connected within timeout_ms
+    void connect(const Addr& addr, const Port& port, int timeout_ms);
+
+    // the sends are virtual so a Socket reached through TransSocket& still
+    // queues behind its corked bytes
+    virtual int send(const char* msg, size_t length);
     int receive(char* buf, size_t buf_size);
 
+    // send everything, waiting while a non-blocking socket would block
+    virtual void send_all(const char* msg, size_t length);
+
+    // receive exactly length bytes (MSG_WAITALL), returns length, fewer
+    // if the peer closed first, or -ERR_CODE, never stores a '\0', a
+    // non-blocking socket or a receive timeout also returns fewer after
+    // some bytes, so a short count alone does not mean end of stream,
+    // receive() again tells 0 for closed from -EAGAIN
+    int receive_exact(char* buf, size_t length);
+
+    // never throw, for non-blocking sockets where would_block() is routine
+    virtual IoResult try_send(const char* msg, size_t length) noexcept;
+    IoResult try_receive(char* buf, size_t buf_size) noexcept;
+
+#ifdef NANO_LINUX
+    // gather and scatter with sendmsg & recvmsg, send() returns the bytes
+    // sent, fewer than requested only if a non-blocking socket would block
+    virtual size_t send(const iovec* iov, size_t count);
+    int receive(iovec* iov, size_t count);
+#endif
+
+    // send several buffers as if they were one
+    size_t send(std::initializer_list<std::string_view> bufs);
+
     bool recv_timeout(long ms) const noexcept;
 
 }; // class TransSocket
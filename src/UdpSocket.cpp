@@ -26,43 +26,234 @@
 
 #include "UdpSocket.h"
 
+// C++
+#include <algorithm>
+
+#ifdef NANO_LINUX
+#include <netinet/udp.h>
+#endif
+
 namespace nano {
 
+namespace {
+
+// datagrams per sendmmsg/recvmmsg call
+constexpr size_t BATCH_SIZE = 64;
+
+// per UDP_SEGMENT send: UDP_MAX_SEGMENTS of older kernels and the
+// largest IPv4 UDP payload, the IPv6 one is a little larger
+constexpr size_t GSO_MAX_SEGMENTS = 64;
+constexpr size_t GSO_MAX_BYTES = 65535 - 20 - 8;
+
+} // anonymous namespace
+
 // constructor
 UdpSocket::UdpSocket(bool create)
     : TransSocket(create ? SOCK_DGRAM : NULL_SOCKET) {}
 
+UdpSocket::UdpSocket(Domain domain)
+    : TransSocket(SOCK_DGRAM, domain) {}
+
 UdpSocket::UdpSocket(const Addr& addr, const Port& port)
-        : TransSocket(SOCK_DGRAM) {
+        : TransSocket(SOCK_DGRAM, addr.family()) {
     SocketBase::bind(addr, port);
 }
 
 // send to the specified remote
 int UdpSocket::send_to(const char* msg,
         size_t length, const AddrPort& remote) {
-    try {
-        return send_msg_to(socket_, msg, length,
-            remote.addr().get(), remote.port().get());
-    } catch (const NanoExcept& e) {
-        throw_except(except_name(), e.what());
-    }
-    return 0; // never
+    IoResult ret = this->try_send_to(msg, length, remote);
+    assert_throw_nanoexcept(ret.ok(), except_name(), SysError(ret.error));
+    return ret.bytes;
 }
 
 // receive from the specified remote
 int UdpSocket::receive_from(char* buf, size_t buf_size, AddrPort& addrport) {
-    addr_t addr = 0;
-    port_t port = 0;
-    int ret = recv_msg_from(socket_, buf, buf_size, &addr, &port);
-    if (ret >= 0) {
-        addrport.addr(addr_ntoh(addr));
-        addrport.port(port_ntoh(port));
+    IoResult ret = this->try_receive_from(buf, buf_size, addrport);
+    return ret.ok() ? ret.bytes : -ret.error;
+}
+
+int UdpSocket::receive_from(char* buf, size_t buf_size) {
+    return this->count_receive_(
+        recv_msg_from(socket_, buf, buf_size, nullptr, nullptr));
+}
+
+IoResult UdpSocket::try_send_to(const char* msg, size_t length,
+        const AddrPort& remote) noexcept {
+    sockaddr_storage addr;
+    socklen_t len = remote.to_sockaddr(addr, domain_);
+    if (len == 0) {
+        // an IPv6 remote on an IPv4 socket
+#ifdef NANO_LINUX
+        return IoResult{0, EAFNOSUPPORT};
+#elif NANO_WINDOWS
+        return IoResult{0, WSAEAFNOSUPPORT};
+#endif
     }
+    IoResult ret = try_send_msg_to(socket_, msg, length,
+        reinterpret_cast<const sockaddr*>(&addr), len);
+    this->count_send_(ret, length);
     return ret;
 }
 
-int UdpSocket::receive_from(char* buf, size_t buf_size) {
-    return recv_msg_from(socket_, buf, buf_size, nullptr, nullptr);
+IoResult UdpSocket::try_receive_from(char* buf, size_t buf_size,
+        AddrPort& addrport) noexcept {
+    sockaddr_storage addr;
+    IoResult ret = try_recv_msg_from(socket_, buf, buf_size, &addr);
+    this->count_receive_(ret);
+    if (ret.ok()) addrport = AddrPort::from_sockaddr(addr);
+    return ret;
+}
+
+// send a batch of datagrams
+int UdpSocket::send_batch(const Datagram* dgrams, size_t count) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "send_batch(): Socket is closed");
+    // sendmmsg would take an empty address and fail in the middle
+    if (domain_ == AF_INET) {
+        for (size_t i = 0; i < count; ++i) {
+            assert_throw_nanoexcept(!dgrams[i].addrport.addr().is_ipv6(),
+                except_name(), "send_batch(): Datagram ", std::to_string(i),
+                " has an IPv6 remote, but the socket is IPv4");
+        }
+    }
+#ifdef NANO_LINUX
+    mmsghdr msgs[BATCH_SIZE];
+    iovec iovs[BATCH_SIZE];
+    sockaddr_storage addrs[BATCH_SIZE];
+    size_t sent = 0;
+    while (sent < count) {
+        unsigned n = static_cast<unsigned>(
+            std::min<size_t>(count - sent, BATCH_SIZE));
+        size_t length = 0;
+        for (unsigned i = 0; i < n; ++i) {
+            const Datagram& dgram = dgrams[sent + i];
+            socklen_t len = dgram.addrport.to_sockaddr(addrs[i], domain_);
+            iovs[i] = {dgram.buf, dgram.length};
+            msgs[i].msg_hdr = {&addrs[i], len, &iovs[i], 1, nullptr, 0, 0};
+            length += dgram.length;
+        }
+        int ret = ::sendmmsg(socket_, msgs, n, 0);
+        if (ret < 0) {
+            SysError error(ERR_CODE);
+            this->count_send_(IoResult{0, error.code}, length);
+            // report the error once everything before it is sent
+            if (sent > 0) break;
+            throw_except(except_name(), "send_batch(): ", error);
+        }
+        if (stats_) {
+            size_t bytes = 0;
+            for (int i = 0; i < ret; ++i) bytes += msgs[i].msg_len;
+            this->count_send_(bytes, length);
+        }
+        sent += static_cast<size_t>(ret);
+        if (static_cast<unsigned>(ret) < n) break;
+    }
+    return static_cast<int>(sent);
+#elif NANO_WINDOWS
+    for (size_t i = 0; i < count; ++i)
+        this->send_to(dgrams[i].buf, dgrams[i].length, dgrams[i].addrport);
+    return static_cast<int>(count);
+#endif
+}
+
+// receive a batch of datagrams, waits for the first one only
+int UdpSocket::receive_batch(Datagram* dgrams, size_t count) {
+#ifdef NANO_LINUX
+    mmsghdr msgs[BATCH_SIZE];
+    iovec iovs[BATCH_SIZE];
+    sockaddr_storage addrs[BATCH_SIZE];
+    unsigned n = static_cast<unsigned>(std::min<size_t>(count, BATCH_SIZE));
+    for (unsigned i = 0; i < n; ++i) {
+        iovs[i] = {dgrams[i].buf, dgrams[i].size};
+        msgs[i].msg_hdr = {&addrs[i], sizeof(addrs[i]),
+            &iovs[i], 1, nullptr, 0, 0};
+    }
+    int ret = ::recvmmsg(socket_, msgs, n, MSG_WAITFORONE, nullptr);
+    if (ret < 0) return this->count_receive_(-ERR_CODE);
+    int bytes = 0;
+    for (int i = 0; i < ret; ++i) {
+        dgrams[i].length = msgs[i].msg_len;
+        dgrams[i].addrport = AddrPort::from_sockaddr(addrs[i]);
+        bytes += static_cast<int>(msgs[i].msg_len);
+    }
+    this->count_receive_(IoResult{bytes, 0});
+    return ret;
+#elif NANO_WINDOWS
+    if (count == 0) return 0;
+    int ret = this->receive_from(dgrams[0].buf,
+        dgrams[0].size, dgrams[0].addrport);
+    if (ret < 0) return ret;
+    dgrams[0].length = static_cast<size_t>(ret);
+    return 1;
+#endif
+}
+
+// send as segment_size datagrams
+int UdpSocket::send_to(const char* msg, size_t length,
+        const AddrPort& remote, size_t segment_size) {
+    if (segment_size == 0 || segment_size >= length)
+        return this->send_to(msg, length, remote);
+#ifdef NANO_LINUX
+    assert_throw_nanoexcept(segment_size <= GSO_MAX_BYTES, except_name(),
+        "send_to(): Segment size ", std::to_string(segment_size),
+        " is larger than ", std::to_string(GSO_MAX_BYTES));
+    sockaddr_storage addr;
+    socklen_t len = remote.to_sockaddr(addr, domain_);
+    assert_throw_nanoexcept(len != 0, except_name(),
+        "send_to(): The remote is IPv6, but the socket is IPv4");
+    // whole segments within both limits
+    size_t chunk = std::min(GSO_MAX_SEGMENTS,
+        GSO_MAX_BYTES / segment_size) * segment_size;
+    size_t sent = 0;
+    while (sent < length) {
+        size_t n = std::min(chunk, length - sent);
+        int ret = 0;
+        try {
+            ret = send_msg_to_gso(socket_, msg + sent, n,
+                reinterpret_cast<const sockaddr*>(&addr), len, segment_size);
+        } catch (const NanoExcept& e) {
+            this->count_send_(IoResult{0, e.code()}, n);
+            // report the error once everything before it is sent
+            if (sent > 0) break;
+            throw_except(except_name(), e);
+        }
+        this->count_send_(IoResult{ret, 0}, n);
+        sent += static_cast<size_t>(ret);
+    }
+    return static_cast<int>(sent);
+#elif NANO_WINDOWS
+    size_t sent = 0;
+    for (; sent < length; sent += segment_size) {
+        this->send_to(msg + sent,
+            std::min(segment_size, length - sent), remote);
+    }
+    return static_cast<int>(length);
+#endif
+}
+
+// receive datagrams that may have been coalesced
+int UdpSocket::receive_from(char* buf, size_t buf_size,
+        AddrPort& addrport, size_t& segment_size) {
+#ifdef NANO_LINUX
+    sockaddr_storage addr;
+    int ret = this->count_receive_(recv_msg_from_gro(socket_, buf, buf_size,
+        &addr, &segment_size));
+    if (ret >= 0) addrport = AddrPort::from_sockaddr(addr);
+    return ret;
+#elif NANO_WINDOWS
+    int ret = this->receive_from(buf, buf_size, addrport);
+    if (ret >= 0) segment_size = static_cast<size_t>(ret);
+    return ret;
+#endif
+}
+
+bool UdpSocket::enable_gro(bool enable) noexcept {
+#if defined(NANO_LINUX) && defined(UDP_GRO)
+    return this->set_option(SOL_UDP, UDP_GRO, (int)enable);
+#else
+    return !enable;
+#endif
 }
 
 const char* UdpSocket::except_name() const noexcept {
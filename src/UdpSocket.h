@@ -33,11 +33,20 @@
 
 namespace nano {
 
+// a datagram of a batch
+struct Datagram {
+    char* buf;          // payload
+    size_t size;        // capacity of buf, when receiving
+    size_t length;      // bytes to send, or bytes received
+    AddrPort addrport;  // destination, or source
+};
+
 class UdpSocket : public TransSocket {
 public:
 
     // ctor & dtor
     UdpSocket(bool create = true);
+    explicit UdpSocket(Domain domain);
     UdpSocket(const Addr& addr, const Port& port);
     virtual ~UdpSocket() = default;
 
@@ -56,6 +65,31 @@ public:
     int receive_from(char* buf, size_t buf_size, AddrPort& addrport);
     int receive_from(char* buf, size_t buf_size);
 
+    // never throw, see TransSocket::try_send()
+    IoResult try_send_to(const char* msg, size_t length,
+        const AddrPort& remote) noexcept;
+    IoResult try_receive_from(char* buf, size_t buf_size,
+        AddrPort& addrport) noexcept;
+
+    // send or receive up to count datagrams in one call, returns the
+    // number of datagrams transferred, an IPv6 remote on an IPv4 socket
+    // throws before anything is sent
+    int send_batch(const Datagram* dgrams, size_t count);
+    int receive_batch(Datagram* dgrams, size_t count);
+
+    // segmentation offload, msg is sent as segment_size datagrams and
+    // segment_size is set to the datagram size of a coalesced receive,
+    // the kernel takes at most 64 segments and 65507 bytes per call, so
+    // longer messages are sent in several calls, segment_size must fit
+    // in the path MTU, returns the bytes sent
+    int send_to(const char* msg, size_t length,
+        const AddrPort& remote, size_t segment_size);
+    int receive_from(char* buf, size_t buf_size,
+        AddrPort& addrport, size_t& segment_size);
+
+    // let the kernel coalesce received datagrams (UDP GRO)
+    bool enable_gro(bool enable) noexcept;
+
 protected:
     virtual const char* except_name() const noexcept override;
 
@@ -0,0 +1,163 @@
+// File:     src/UniqueFunction.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_UNIQUE_FUNCTION_H
+#define NANONET_UNIQUE_FUNCTION_H
+
+// C++
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace nano {
+
+template <class Signature>
+class UniqueFunction;
+
+// std::function for move-only callables, such as a lambda owning a Socket,
+// small callables are stored inline
+template <class R, class... Args>
+class UniqueFunction<R(Args...)> {
+
+    // a lambda capturing a Socket and a pointer fits
+    static constexpr size_t INLINE_SIZE = 88;
+
+    struct Ops {
+        R (*call)(void* storage, Args&&... args);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <class Fn>
+    static constexpr bool is_inline_ = sizeof(Fn) <= INLINE_SIZE
+        && alignof(Fn) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible_v<Fn>;
+
+    alignas(std::max_align_t) unsigned char storage_[INLINE_SIZE];
+    const Ops* ops_;
+
+public:
+
+    // ctor & dtor
+    UniqueFunction() noexcept : ops_(nullptr) {}
+    UniqueFunction(std::nullptr_t) noexcept : ops_(nullptr) {}
+
+    template <class Fn, class F = std::decay_t<Fn>, class = std::enable_if_t<
+        !std::is_same_v<F, UniqueFunction>
+        && std::is_invocable_r_v<R, F&, Args...>>>
+    UniqueFunction(Fn&& fn) : ops_(&OPS_<F>) {
+        if constexpr (is_inline_<F>) {
+            ::new (storage_) F(std::forward<Fn>(fn));
+        } else {
+            ::new (storage_) F*(new F(std::forward<Fn>(fn)));
+        }
+    }
+
+    ~UniqueFunction() {
+        if (ops_) ops_->destroy(storage_);
+    }
+
+    // move
+    UniqueFunction(UniqueFunction&& other) noexcept : ops_(other.ops_) {
+        if (ops_) ops_->move(storage_, other.storage_);
+        other.ops_ = nullptr;
+    }
+
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+        if (this == &other) return *this;
+        if (ops_) ops_->destroy(storage_);
+        ops_ = other.ops_;
+        if (ops_) ops_->move(storage_, other.storage_);
+        other.ops_ = nullptr;
+        return *this;
+    }
+
+    UniqueFunction& operator=(std::nullptr_t) noexcept {
+        if (ops_) ops_->destroy(storage_);
+        ops_ = nullptr;
+        return *this;
+    }
+
+    // uncopyable
+    UniqueFunction(const UniqueFunction&) = delete;
+    UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+    explicit operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    R operator()(Args... args) {
+        if (ops_ == nullptr) throw std::bad_function_call();
+        return ops_->call(storage_, std::forward<Args>(args)...);
+    }
+
+private:
+    template <class F>
+    static F* target_(void* storage) noexcept {
+        if constexpr (is_inline_<F>) {
+            return std::launder(reinterpret_cast<F*>(storage));
+        } else {
+            return *std::launder(reinterpret_cast<F**>(storage));
+        }
+    }
+
+    template <class F>
+    static R call_(void* storage, Args&&... args) {
+        return std::invoke(*target_<F>(storage), std::forward<Args>(args)...);
+    }
+
+    // the source is left empty, inline callables are destroyed there
+    template <class F>
+    static void move_(void* dst, void* src) noexcept {
+        if constexpr (is_inline_<F>) {
+            F* fn = target_<F>(src);
+            ::new (dst) F(std::move(*fn));
+            fn->~F();
+        } else {
+            ::new (dst) F*(target_<F>(src));
+        }
+    }
+
+    template <class F>
+    static void destroy_(void* storage) noexcept {
+        if constexpr (is_inline_<F>) {
+            target_<F>(storage)->~F();
+        } else {
+            delete target_<F>(storage);
+        }
+    }
+
+    template <class F>
+    static constexpr Ops OPS_ = {&call_<F>, &move_<F>, &destroy_<F>};
+
+}; // class UniqueFunction
+
+} // namespace nano
+
+#endif // NANONET_UNIQUE_FUNCTION_H
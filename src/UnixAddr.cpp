@@ -0,0 +1,168 @@
+// File:     src/UnixAddr.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "UnixAddr.h"
+
+#ifdef NANO_LINUX
+
+// C
+#include <cstddef>
+#include <cstring>
+
+// Linux
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C++
+#include <algorithm>
+
+namespace nano {
+
+namespace {
+
+constexpr size_t PATH_MAX_ = sizeof(sockaddr_un::sun_path);
+
+// connect to the name with a socket of each type until one fits, returns
+// the errno of the last attempt, 0 if something answered
+int probe_(const sockaddr_un& addr, socklen_t len) noexcept {
+    int err = 0;
+    for (int type : {SOCK_STREAM, SOCK_SEQPACKET, SOCK_DGRAM}) {
+        int fd = ::socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return errno;
+        int ret;
+        do ret = ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), len);
+        while (ret != 0 && errno == EINTR);
+        err = ret == 0 ? 0 : errno;
+        ::close(fd);
+        // bound by a socket of another type
+        if (err != EPROTOTYPE) break;
+    }
+    return err;
+}
+
+} // anonymous namespace
+
+// constructor
+UnixAddr::UnixAddr(std::string_view path) {
+    if (!path.empty() && path[0] == '@') {
+        *this = UnixAddr::abstract(path.substr(1));
+        return;
+    }
+    // room for the terminating '\0'
+    assert_throw_nanoexcept(path.size() < PATH_MAX_,
+        "[UnixAddr] UnixAddr(): The path \'", std::string(path),
+        "\' is too long");
+    assert_throw_nanoexcept(path.find('\0') == std::string_view::npos,
+        "[UnixAddr] UnixAddr(): The path contains \'\\0\'");
+    path_ = path;
+}
+
+UnixAddr::UnixAddr(const char* path)
+    : UnixAddr(std::string_view(path)) {}
+
+UnixAddr UnixAddr::abstract(std::string_view name) {
+    assert_throw_nanoexcept(name.size() < PATH_MAX_,
+        "[UnixAddr] abstract(): The name \'", std::string(name),
+        "\' is too long");
+    UnixAddr ret;
+    ret.path_.reserve(name.size() + 1);
+    ret.path_.push_back('\0');
+    ret.path_.append(name);
+    return ret;
+}
+
+// getter
+bool UnixAddr::empty() const noexcept {
+    return path_.empty();
+}
+
+bool UnixAddr::is_abstract() const noexcept {
+    return !path_.empty() && path_[0] == '\0';
+}
+
+const std::string& UnixAddr::path() const noexcept {
+    return path_;
+}
+
+// socket address, abstract names are not '\0' terminated
+socklen_t UnixAddr::to_sockaddr(sockaddr_un& addr) const noexcept {
+    addr = sockaddr_un{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path_.data(), path_.size());
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path)
+        + path_.size() + (this->is_abstract() ? 0 : 1));
+}
+
+UnixAddr UnixAddr::from_sockaddr(const sockaddr_un& addr, socklen_t len) {
+    UnixAddr ret;
+    size_t offset = offsetof(sockaddr_un, sun_path);
+    if (addr.sun_family != AF_UNIX || len <= offset) return ret;
+    size_t size = std::min<size_t>(len - offset, PATH_MAX_);
+    if (addr.sun_path[0] == '\0') {
+        ret.path_.assign(addr.sun_path, size);
+    } else {
+        ret.path_.assign(addr.sun_path, ::strnlen(addr.sun_path, size));
+    }
+    return ret;
+}
+
+bool UnixAddr::remove_stale() const noexcept {
+    struct stat st;
+    if (path_.empty() || this->is_abstract()
+            || ::lstat(path_.c_str(), &st) != 0 || !S_ISSOCK(st.st_mode))
+        return false;
+    // a full backlog (EAGAIN) still has a listener behind it
+    sockaddr_un addr;
+    socklen_t len = this->to_sockaddr(addr);
+    if (probe_(addr, len) != ECONNREFUSED) return false;
+    return ::unlink(path_.c_str()) == 0;
+}
+
+UnixAddr UnixAddr::local_of(sock_t socket) {
+    sockaddr_un addr {};
+    socklen_t len = sizeof(addr);
+    if (::getsockname(socket, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+        return UnixAddr();
+    return UnixAddr::from_sockaddr(addr, len);
+}
+
+UnixAddr UnixAddr::remote_of(sock_t socket) {
+    sockaddr_un addr {};
+    socklen_t len = sizeof(addr);
+    if (::getpeername(socket, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+        return UnixAddr();
+    return UnixAddr::from_sockaddr(addr, len);
+}
+
+// to string
+std::string UnixAddr::to_string() const {
+    if (!this->is_abstract()) return path_;
+    return '@' + path_.substr(1);
+}
+
+} // namespace nano
+
+#endif // NANO_LINUX
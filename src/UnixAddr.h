@@ -0,0 +1,101 @@
+// File:     src/UnixAddr.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_UNIX_ADDR_H
+#define NANONET_UNIX_ADDR_H
+
+// C++
+#include <string>
+#include <string_view>
+
+// NanoNet
+#include "net.h"
+
+#ifdef NANO_LINUX
+
+namespace nano {
+
+class UnixAddr {
+
+    // a file system path, or an abstract name after a leading '\0'
+    std::string path_;
+
+public:
+
+    // ctor & dtor, a leading '@' names an abstract socket, the empty
+    // address is an unnamed socket
+    UnixAddr() = default;
+    UnixAddr(std::string_view path);
+    UnixAddr(const char* path);
+
+    UnixAddr(const UnixAddr&) = default;
+    UnixAddr(UnixAddr&&) = default;
+    ~UnixAddr() = default;
+
+    // assignment
+    UnixAddr& operator=(const UnixAddr&) = default;
+    UnixAddr& operator=(UnixAddr&&) = default;
+
+    // a name in the abstract namespace, gone with the last socket using it
+    static UnixAddr abstract(std::string_view name);
+
+    // compare
+    friend bool operator==(const UnixAddr& a, const UnixAddr& b) noexcept {
+        return a.path_ == b.path_;
+    }
+    friend bool operator!=(const UnixAddr& a, const UnixAddr& b) noexcept {
+        return a.path_ != b.path_;
+    }
+
+    // getter
+    bool empty() const noexcept;
+    bool is_abstract() const noexcept;
+    const std::string& path() const noexcept;
+
+    // socket address, returns the length
+    socklen_t to_sockaddr(sockaddr_un& addr) const noexcept;
+    static UnixAddr from_sockaddr(const sockaddr_un& addr, socklen_t len);
+
+    // remove the socket file left by a previous run, never a regular file
+    // or a socket something still listens on, so binding it then fails
+    // with EADDRINUSE
+    bool remove_stale() const noexcept;
+
+    // the name a socket is bound or connected to
+    static UnixAddr local_of(sock_t socket);
+    static UnixAddr remote_of(sock_t socket);
+
+    // to string, abstract names start with '@'
+    std::string to_string() const;
+
+}; // class UnixAddr
+
+} // namespace nano
+
+#endif // NANO_LINUX
+
+#endif // NANONET_UNIX_ADDR_H
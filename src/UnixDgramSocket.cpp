@@ -0,0 +1,136 @@
+// File:     src/UnixDgramSocket.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "UnixDgramSocket.h"
+
+#ifdef NANO_LINUX
+
+namespace nano {
+
+// constructor
+UnixDgramSocket::UnixDgramSocket(bool create)
+    : TransSocket(create ? SOCK_DGRAM : NULL_SOCKET, AF_UNIX) {}
+
+UnixDgramSocket::UnixDgramSocket(const UnixAddr& addr)
+        : TransSocket(SOCK_DGRAM, AF_UNIX) {
+    this->bind(addr);
+}
+
+// connected pair
+std::pair<UnixDgramSocket, UnixDgramSocket> UnixDgramSocket::pair() {
+    sock_t socks[2];
+    assert_throw_nanoexcept(create_socket_pair(SOCK_DGRAM, socks),
+        "[UNIX] pair(): ", LAST_ERROR);
+    std::pair<UnixDgramSocket, UnixDgramSocket> ret(false, false);
+    ret.first.socket_ = socks[0];
+    ret.second.socket_ = socks[1];
+    return ret;
+}
+
+void UnixDgramSocket::bind(const UnixAddr& addr) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "bind(): Socket is closed");
+    addr.remove_stale();
+    sockaddr_un local;
+    socklen_t len = addr.to_sockaddr(local);
+    assert_throw_nanoexcept(bind_address(socket_,
+        reinterpret_cast<const sockaddr*>(&local), len),
+        except_name(), "bind(): Bind address \'", addr.to_string(),
+        "\' failed: ", LAST_ERROR);
+}
+
+void UnixDgramSocket::connect(const UnixAddr& addr) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "connect(): Socket is closed");
+    sockaddr_un remote;
+    socklen_t len = addr.to_sockaddr(remote);
+    assert_throw_nanoexcept(connect_to(socket_,
+        reinterpret_cast<const sockaddr*>(&remote), len),
+        except_name(), "connect(): Connect to \'", addr.to_string(),
+        "\' failed: ", LAST_ERROR);
+}
+
+// local & remote
+UnixAddr UnixDgramSocket::local() const {
+    return UnixAddr::local_of(socket_);
+}
+
+UnixAddr UnixDgramSocket::remote() const {
+    return UnixAddr::remote_of(socket_);
+}
+
+// send to the specified remote
+int UnixDgramSocket::send_to(const char* msg, size_t length,
+        const UnixAddr& remote) {
+    IoResult ret = this->try_send_to(msg, length, remote);
+    assert_throw_nanoexcept(ret.ok(), except_name(), SysError(ret.error));
+    return ret.bytes;
+}
+
+// receive from the specified remote
+int UnixDgramSocket::receive_from(char* buf, size_t buf_size,
+        UnixAddr& addr) {
+    IoResult ret = this->try_receive_from(buf, buf_size, addr);
+    return ret.ok() ? ret.bytes : -ret.error;
+}
+
+IoResult UnixDgramSocket::try_send_to(const char* msg, size_t length,
+        const UnixAddr& remote) noexcept {
+    sockaddr_un addr;
+    socklen_t len = remote.to_sockaddr(addr);
+    IoResult ret = try_send_msg_to(socket_, msg, length,
+        reinterpret_cast<const sockaddr*>(&addr), len);
+    this->count_send_(ret, length);
+    return ret;
+}
+
+IoResult UnixDgramSocket::try_receive_from(char* buf, size_t buf_size,
+        UnixAddr& addr) noexcept {
+    sockaddr_un remote {};
+    socklen_t socklen = sizeof(remote);
+    int len = static_cast<int>(::recvfrom(socket_, buf, buf_size, 0,
+        reinterpret_cast<sockaddr*>(&remote), &socklen));
+    if (len < 0) {
+        IoResult ret{0, ERR_CODE};
+        this->count_receive_(ret);
+        return ret;
+    }
+    this->count_receive_(IoResult{len, 0});
+    try {
+        addr = UnixAddr::from_sockaddr(remote, socklen);
+    } catch (...) {
+        addr = UnixAddr();
+    }
+    return IoResult{len, 0};
+}
+
+const char* UnixDgramSocket::except_name() const noexcept {
+    return "[UNIX] ";
+}
+
+} // namespace nano
+
+#endif // NANO_LINUX
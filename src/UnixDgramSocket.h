@@ -0,0 +1,92 @@
+// File:     src/UnixDgramSocket.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_UNIX_DGRAM_SOCKET_H
+#define NANONET_UNIX_DGRAM_SOCKET_H
+
+// C++
+#include <utility>
+
+// NanoNet
+#include "TransSocket.h"
+#include "UnixAddr.h"
+
+#ifdef NANO_LINUX
+
+namespace nano {
+
+class UnixDgramSocket : public TransSocket {
+public:
+
+    // ctor & dtor, an unbound socket can send but gets no replies
+    UnixDgramSocket(bool create = true);
+    UnixDgramSocket(const UnixAddr& addr);
+    virtual ~UnixDgramSocket() = default;
+
+    // move
+    UnixDgramSocket(UnixDgramSocket&&) = default;
+    UnixDgramSocket& operator=(UnixDgramSocket&&) = default;
+
+    // uncopyable
+    UnixDgramSocket(const UnixDgramSocket&) = delete;
+    UnixDgramSocket& operator=(const UnixDgramSocket&) = delete;
+
+    // two connected sockets, e.g. for a parent and its child
+    static std::pair<UnixDgramSocket, UnixDgramSocket> pair();
+
+    // bind local, a socket file left by a previous run is removed first
+    void bind(const UnixAddr& addr);
+
+    // set the default destination of send()
+    void connect(const UnixAddr& addr);
+
+    // local & remote, empty for unnamed sockets
+    UnixAddr local() const;
+    UnixAddr remote() const;
+
+    // send to the specified remote
+    int send_to(const char* msg, size_t length, const UnixAddr& remote);
+
+    // receive from the specified remote, never stores a '\0' after the data
+    int receive_from(char* buf, size_t buf_size, UnixAddr& addr);
+
+    // never throw, see TransSocket::try_send()
+    IoResult try_send_to(const char* msg, size_t length,
+        const UnixAddr& remote) noexcept;
+    IoResult try_receive_from(char* buf, size_t buf_size,
+        UnixAddr& addr) noexcept;
+
+protected:
+    virtual const char* except_name() const noexcept override;
+
+}; // class UnixDgramSocket
+
+} // namespace nano
+
+#endif // NANO_LINUX
+
+#endif // NANONET_UNIX_DGRAM_SOCKET_H
@@ -0,0 +1,81 @@
+// File:     src/UnixServerSocket.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "UnixServerSocket.h"
+
+#ifdef NANO_LINUX
+
+namespace nano {
+
+// constructor
+UnixServerSocket::UnixServerSocket(bool create)
+    : SocketBase(create ? SOCK_STREAM : NULL_SOCKET, AF_UNIX) {}
+
+UnixServerSocket::UnixServerSocket(const UnixAddr& addr)
+        : SocketBase(SOCK_STREAM, AF_UNIX) {
+    this->bind(addr);
+}
+
+void UnixServerSocket::bind(const UnixAddr& addr) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "bind(): Socket is closed");
+    addr.remove_stale();
+    sockaddr_un local;
+    socklen_t len = addr.to_sockaddr(local);
+    assert_throw_nanoexcept(bind_address(socket_,
+        reinterpret_cast<const sockaddr*>(&local), len),
+        except_name(), "bind(): Bind address \'", addr.to_string(),
+        "\' failed: ", LAST_ERROR);
+}
+
+// listen
+void UnixServerSocket::listen(int backlog) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "listen(): Socket is closed");
+    assert_throw_nanoexcept(enable_listening(socket_, backlog),
+        except_name(), "listen(): ", LAST_ERROR);
+}
+
+// accept a new connection
+UnixSocket UnixServerSocket::accept() {
+    UnixSocket ret(false);
+    ret.socket_ = ::accept4(socket_, nullptr, nullptr, SOCK_CLOEXEC);
+    assert_throw_nanoexcept(ret.socket_ != INVALID_SOCKET,
+        except_name(), "accept(): ", LAST_ERROR);
+    return ret;
+}
+
+UnixAddr UnixServerSocket::local() const {
+    return UnixAddr::local_of(socket_);
+}
+
+const char* UnixServerSocket::except_name() const noexcept {
+    return "[UNIX] ";
+}
+
+} // namespace nano
+
+#endif // NANO_LINUX
@@ -0,0 +1,76 @@
+// File:     src/UnixServerSocket.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_UNIX_SERVER_SOCKET_H
+#define NANONET_UNIX_SERVER_SOCKET_H
+
+// NanoNet
+#include "UnixSocket.h"
+
+#ifdef NANO_LINUX
+
+namespace nano {
+
+class UnixServerSocket : public SocketBase {
+public:
+
+    // ctor & dtor
+    UnixServerSocket(bool create = true);
+    UnixServerSocket(const UnixAddr& addr);
+    virtual ~UnixServerSocket() = default;
+
+    // move
+    UnixServerSocket(UnixServerSocket&&) = default;
+    UnixServerSocket& operator=(UnixServerSocket&&) = default;
+
+    // uncopyable
+    UnixServerSocket(const UnixServerSocket&) = delete;
+    UnixServerSocket& operator=(const UnixServerSocket&) = delete;
+
+    // bind local, a socket file left by a previous run is removed first,
+    // the file is not removed on close
+    void bind(const UnixAddr& addr);
+
+    // listen
+    void listen(int backlog = 20);
+
+    // accept from client
+    UnixSocket accept();
+
+    // get local
+    UnixAddr local() const;
+
+protected:
+    virtual const char* except_name() const noexcept override;
+
+}; // class UnixServerSocket
+
+} // namespace nano
+
+#endif // NANO_LINUX
+
+#endif // NANONET_UNIX_SERVER_SOCKET_H
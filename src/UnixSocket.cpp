@@ -0,0 +1,116 @@
+// File:     src/UnixSocket.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "UnixSocket.h"
+
+#ifdef NANO_LINUX
+
+namespace nano {
+
+// constructor
+UnixSocket::UnixSocket(bool create)
+    : TransSocket(create ? SOCK_STREAM : NULL_SOCKET, AF_UNIX) {}
+
+// connected pair
+std::pair<UnixSocket, UnixSocket> UnixSocket::pair() {
+    sock_t socks[2];
+    assert_throw_nanoexcept(create_socket_pair(SOCK_STREAM, socks),
+        "[UNIX] pair(): ", LAST_ERROR);
+    std::pair<UnixSocket, UnixSocket> ret(false, false);
+    ret.first.socket_ = socks[0];
+    ret.second.socket_ = socks[1];
+    return ret;
+}
+
+void UnixSocket::connect(const UnixAddr& addr) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "connect(): Socket is closed");
+    sockaddr_un remote;
+    socklen_t len = addr.to_sockaddr(remote);
+    assert_throw_nanoexcept(connect_to(socket_,
+        reinterpret_cast<const sockaddr*>(&remote), len),
+        except_name(), "connect(): Connect to \'", addr.to_string(),
+        "\' failed: ", LAST_ERROR);
+}
+
+// local & remote
+UnixAddr UnixSocket::local() const {
+    return UnixAddr::local_of(socket_);
+}
+
+UnixAddr UnixSocket::remote() const {
+    return UnixAddr::remote_of(socket_);
+}
+
+// descriptor passing
+void UnixSocket::send_fd(sock_t fd) {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "send_fd(): Socket is closed");
+    IoResult ret = try_send_fds(socket_, &fd, 1);
+    assert_throw_nanoexcept(ret.ok(),
+        except_name(), "send_fd(): ", SysError(ret.error));
+}
+
+sock_t UnixSocket::receive_fd() {
+    assert_throw_nanoexcept(socket_ != INVALID_SOCKET,
+        except_name(), "receive_fd(): Socket is closed");
+    int fd = INVALID_SOCKET;
+    size_t count = 1;
+    IoResult ret = try_recv_fds(socket_, &fd, &count);
+    assert_throw_nanoexcept(ret.ok(),
+        except_name(), "receive_fd(): ", SysError(ret.error));
+    return count == 1 ? fd : INVALID_SOCKET;
+}
+
+Socket UnixSocket::receive_socket() {
+    Socket ret(false);
+    ret.socket_ = this->receive_fd();
+    assert_throw_nanoexcept(ret.socket_ != INVALID_SOCKET,
+        except_name(), "receive_socket(): No socket was passed");
+    // anything but a TCP socket is closed instead of taken over
+    int domain = AF_UNSPEC, type = 0;
+    if (!ret.get_option(SOL_SOCKET, SO_DOMAIN, domain)
+            || !ret.get_option(SOL_SOCKET, SO_TYPE, type)) {
+        SysError error = LAST_ERROR;
+        ret.close();
+        throw_except(except_name(), "receive_socket(): ", error);
+    }
+    if ((domain != AF_INET && domain != AF_INET6) || type != SOCK_STREAM) {
+        ret.close();
+        throw_except(except_name(),
+            "receive_socket(): The passed descriptor is not a TCP socket");
+    }
+    ret.domain_ = domain;
+    return ret;
+}
+
+const char* UnixSocket::except_name() const noexcept {
+    return "[UNIX] ";
+}
+
+} // namespace nano
+
+#endif // NANO_LINUX
@@ -0,0 +1,91 @@
+// File:     src/UnixSocket.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_UNIX_SOCKET_H
+#define NANONET_UNIX_SOCKET_H
+
+// C++
+#include <utility>
+
+// NanoNet
+#include "Socket.h"
+#include "UnixAddr.h"
+
+#ifdef NANO_LINUX
+
+namespace nano {
+
+class UnixSocket : public TransSocket {
+
+    // server socket
+    friend class UnixServerSocket;
+
+public:
+
+    // ctor & dtor
+    UnixSocket(bool create = true);
+    virtual ~UnixSocket() = default;
+
+    // move
+    UnixSocket(UnixSocket&&) = default;
+    UnixSocket& operator=(UnixSocket&&) = default;
+
+    // uncopyable
+    UnixSocket(const UnixSocket&) = delete;
+    UnixSocket& operator=(const UnixSocket&) = delete;
+
+    // two connected sockets, e.g. for a parent and its child
+    static std::pair<UnixSocket, UnixSocket> pair();
+
+    // connect to a listening socket
+    void connect(const UnixAddr& addr);
+
+    // local & remote, empty for unnamed sockets
+    UnixAddr local() const;
+    UnixAddr remote() const;
+
+    // pass a descriptor to the peer process (SCM_RIGHTS), the sender keeps
+    // its own copy and may close it afterwards
+    void send_fd(sock_t fd);
+
+    // returns INVALID_SOCKET if the peer closed or sent data without a
+    // descriptor
+    sock_t receive_fd();
+
+    // take over a TCP connection passed with send_fd()
+    Socket receive_socket();
+
+protected:
+    virtual const char* except_name() const noexcept override;
+
+}; // class UnixSocket
+
+} // namespace nano
+
+#endif // NANO_LINUX
+
+#endif // NANONET_UNIX_SOCKET_H
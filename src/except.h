@@ -52,21 +52,57 @@ namespace nano {
 
 class NanoExcept : public std::exception {
     std::string except_msg_;
+    int code_;
 public:
-    explicit NanoExcept(const std::string& msg) : except_msg_(msg) {}
-    explicit NanoExcept(std::string&& msg) : except_msg_(std::move(msg)) {}
+    explicit NanoExcept(const std::string& msg, int code = 0)
+        : except_msg_(msg), code_(code) {}
+    explicit NanoExcept(std::string&& msg, int code = 0)
+        : except_msg_(std::move(msg)), code_(code) {}
     virtual ~NanoExcept() override = default;
     virtual const char* what() const noexcept override {
         return except_msg_.c_str();
     }
+    // the system error code taken where the call failed, 0 if none
+    int code() const noexcept {
+        return code_;
+    }
+};
+
+// a system error code and its message, taken at once so nothing in
+// between can overwrite the code
+struct SysError {
+    int code;
+    std::string message;
+    explicit SysError(int code);
+    operator const std::string&() const noexcept {
+        return message;
+    }
 };
 
+// message parts, an error or a caught exception also sets the code
+template <class T>
+inline void append_except_(std::string& s, int&, const T& arg) {
+    s += arg;
+}
+
+inline void append_except_(std::string& s, int& code, const SysError& arg) {
+    s += arg.message;
+    code = arg.code;
+}
+
+inline void append_except_(std::string& s, int& code,
+        const NanoExcept& arg) {
+    s += arg.what();
+    if (arg.code() != 0) code = arg.code();
+}
+
 // throw exceptions
 template <class ExceptType = NanoExcept, class ...Args>
 inline void throw_except(const Args&... args) {
     std::string s;
-    ((s += args), ...);
-    throw ExceptType(std::move(s));
+    int code = 0;
+    (append_except_(s, code, args), ...);
+    throw ExceptType(std::move(s), code);
 }
 
 #define assert_throw_nanoexcept(condition, ...) \
@@ -76,17 +112,20 @@ inline void throw_except(const Args&... args) {
 #ifdef __linux__
 
 #define ERR_CODE errno
-#define LAST_ERROR (std::strerror(ERR_CODE))
+#define LAST_ERROR (::nano::SysError(ERR_CODE))
+
+inline SysError::SysError(int code)
+    : code(code), message(std::strerror(code)) {}
 
 #elif _WIN32
 
 #define ERR_CODE (WSAGetLastError())
 
 namespace {
-inline std::string WSAGetLastErrorMessage_() {
+inline std::string WSAGetLastErrorMessage_(int code) {
     LPSTR msg = nullptr;
     FormatMessageA(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM
-        | FORMAT_MESSAGE_IGNORE_INSERTS, nullptr, ERR_CODE,
+        | FORMAT_MESSAGE_IGNORE_INSERTS, nullptr, code,
         MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
         (LPSTR)&msg, 0, nullptr);
     std::string result(msg);
@@ -95,7 +134,10 @@ inline std::string WSAGetLastErrorMessage_() {
 }
 } // anonymous namespace
 
-#define LAST_ERROR (WSAGetLastErrorMessage_())
+#define LAST_ERROR (::nano::SysError(ERR_CODE))
+
+inline SysError::SysError(int code)
+    : code(code), message(WSAGetLastErrorMessage_(code)) {}
 
 #endif
 
@@ -26,6 +26,21 @@
 
 #include "net.h"
 
+#ifdef NANO_LINUX
+#include <algorithm>
+#include <climits>
+#include <linux/errqueue.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <sys/sendfile.h>
+#elif NANO_WINDOWS
+#include <io.h>
+#include <algorithm>
+#endif
+
+// C++
+#include <chrono>
+
 namespace nano {
 
 // init WSA
@@ -49,26 +64,6 @@ class WSAInit {
 
 #endif
 
-addr_t addr_ntoh(addr_t addr) noexcept {
-    return static_cast<addr_t>(::ntohl(
-        static_cast<uint32_t>(addr)));
-}
-
-addr_t addr_hton(addr_t addr) noexcept {
-    return static_cast<addr_t>(::htonl(
-        static_cast<uint32_t>(addr)));
-}
-
-port_t port_ntoh(port_t addr) noexcept {
-    return static_cast<port_t>(::ntohs(
-        static_cast<uint16_t>(addr)));
-}
-
-port_t port_hton(port_t addr) noexcept {
-    return static_cast<port_t>(::htons(
-        static_cast<uint16_t>(addr)));
-}
-
 addr_t addr_ston(std::string_view str) {
     addr_t addr;
     switch (inet_pton(AF_INET, str.data(), &addr))
@@ -104,23 +99,8 @@ std::string addr_ntos(addr_t addr) {
 }
 
 bool is_valid_ipv4(std::string_view addr) noexcept {
-    int count = 0, value = 0;
-    char prev = '.';
-    for (const char& c : addr) {
-        if (c == '.') {
-            if (prev == '.') return false;
-            if (value > 255 || count == 3)
-                return false;
-            value = 0;
-            ++count;
-        } else if (c >= '0' && c <= '9') {
-            value = value * 10 + (c & 0xF);
-        } else {
-            return false;
-        }
-        prev = c;
-    }
-    return (value <= 255) && (count == 3);
+    addr_t value = 0;
+    return parse_ipv4(addr, value);
 }
 
 size_t dns_query(std::string_view name,
@@ -150,10 +130,10 @@ addr_t dns_query_single(std::string_view name, int protocol) {
     info.ai_socktype = protocol;
     addrinfo* addrs = nullptr;
     int status = getaddrinfo(name.data(), nullptr, &info, &addrs);
+    assert_throw_nanoexcept(status == 0, gai_strerror(status));
     addr_t result = static_cast<addr_t>(reinterpret_cast<sockaddr_in*>
         (addrs->ai_addr)->sin_addr.s_addr);
     freeaddrinfo(addrs);
-    assert_throw_nanoexcept(status == 0, gai_strerror(status));
     return result;
 }
 
@@ -170,16 +150,41 @@ bool bind_address(sock_t socket, addr_t addr, port_t port) noexcept {
     return 0 == ::bind(socket, reinterpret_cast<const sockaddr*>(&local), len);
 }
 
-sock_t accept_from(sock_t socket, addr_t* addr, port_t* port) noexcept {
+sock_t accept_from(sock_t socket, addr_t* addr, port_t* port,
+        int flags) noexcept {
     sockaddr_in remote {};
     socklen_t socklen = sizeof(remote);
+#ifdef NANO_LINUX
+    sock_t link_socket = ::accept4(socket,
+        reinterpret_cast<sockaddr*>(&remote), &socklen, flags);
+#elif NANO_WINDOWS
+    (void)flags;
     sock_t link_socket = ::accept(socket,
         reinterpret_cast<sockaddr*>(&remote), &socklen);
+#endif
     if (addr) *addr = remote.sin_addr.s_addr;
     if (port) *port = remote.sin_port;
     return link_socket;
 }
 
+bool bind_address(sock_t socket, const sockaddr* addr,
+        socklen_t len) noexcept {
+    return 0 == ::bind(socket, addr, len);
+}
+
+sock_t accept_from(sock_t socket, sockaddr_storage* addr,
+        int flags) noexcept {
+    sockaddr_storage remote;
+    socklen_t socklen = sizeof(remote);
+    sockaddr* out = reinterpret_cast<sockaddr*>(addr ? addr : &remote);
+#ifdef NANO_LINUX
+    return ::accept4(socket, out, &socklen, flags);
+#elif NANO_WINDOWS
+    (void)flags;
+    return ::accept(socket, out, &socklen);
+#endif
+}
+
 bool enable_listening(sock_t socket, int backlog) noexcept {
     return 0 == ::listen(socket, backlog);
 }
@@ -193,52 +198,611 @@ bool connect_to(sock_t socket, addr_t addr, port_t port) noexcept {
     return ret == 0;
 }
 
-int recv_msg(sock_t socket, char* buf, size_t buf_size, int flags) {
-    int len = static_cast<int>(::recv(socket, buf, buf_size, flags));
-    if (len >= 0) {
-        // truncate buffer
-        if (len < buf_size) buf[len] = 0;
-        return len;
-    } else {
-        return -ERR_CODE;
+bool connect_to(sock_t socket, const sockaddr* addr, socklen_t len) noexcept {
+    return 0 == ::connect(socket, addr, len);
+}
+
+namespace {
+
+#ifdef NANO_LINUX
+constexpr int CONNECT_TIMEDOUT_ = ETIMEDOUT;
+constexpr int CONNECT_INVALID_ = EINVAL;
+#elif NANO_WINDOWS
+constexpr int CONNECT_TIMEDOUT_ = WSAETIMEDOUT;
+constexpr int CONNECT_INVALID_ = WSAEINVAL;
+#endif
+
+inline void set_error_(int error) noexcept {
+#ifdef NANO_LINUX
+    errno = error;
+#elif NANO_WINDOWS
+    WSASetLastError(error);
+#endif
+}
+
+// a non-blocking connect has been started
+inline bool in_progress_(int error) noexcept {
+#ifdef NANO_LINUX
+    return error == EINPROGRESS;
+#elif NANO_WINDOWS
+    return error == WSAEWOULDBLOCK;
+#endif
+}
+
+inline int poll_(pollfd* fds, size_t count, int timeout_ms) noexcept {
+#ifdef NANO_LINUX
+    return ::poll(fds, static_cast<nfds_t>(count), timeout_ms);
+#elif NANO_WINDOWS
+    return ::WSAPoll(fds, static_cast<ULONG>(count), timeout_ms);
+#endif
+}
+
+// result of a finished non-blocking connect
+inline int socket_error_(sock_t socket) noexcept {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (0 != ::getsockopt(socket, SOL_SOCKET, SO_ERROR,
+            reinterpret_cast<char*>(&error), &len))
+        return ERR_CODE;
+    return error;
+}
+
+inline long long elapsed_ms_(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+} // anonymous namespace
+
+bool connect_to(sock_t socket, addr_t addr, port_t port,
+        int timeout_ms) noexcept {
+    sockaddr_in remote {};
+    make_sockaddr4(&remote, addr, port);
+    return connect_to(socket, reinterpret_cast<const sockaddr*>(&remote),
+        sizeof(remote), timeout_ms);
+}
+
+bool connect_to(sock_t socket, const sockaddr* addr, socklen_t len,
+        int timeout_ms) noexcept {
+    if (timeout_ms < 0) return connect_to(socket, addr, len);
+#ifdef NANO_LINUX
+    int flags = fcntl(socket, F_GETFL, 0);
+    bool blocking = flags != -1 && !(flags & O_NONBLOCK);
+#elif NANO_WINDOWS
+    // the mode cannot be queried, assume the default
+    bool blocking = true;
+#endif
+    if (blocking && !set_blocking(socket, false)) return false;
+    bool ok = connect_to(socket, addr, len);
+    if (!ok && in_progress_(ERR_CODE)) {
+        auto start = std::chrono::steady_clock::now();
+        pollfd fd {};
+        fd.fd = socket;
+        fd.events = POLLOUT;
+        int ret = 0;
+        for (;;) {
+            long long left = timeout_ms - elapsed_ms_(start);
+            ret = poll_(&fd, 1, left > 0 ? static_cast<int>(left) : 0);
+#ifdef NANO_LINUX
+            if (ret < 0 && errno == EINTR) continue;
+#endif
+            break;
+        }
+        int error = ret < 0 ? ERR_CODE
+            : ret == 0 ? CONNECT_TIMEDOUT_ : socket_error_(socket);
+        ok = error == 0;
+        set_error_(error);
+    }
+    if (blocking) {
+        int error = ERR_CODE;
+        set_blocking(socket, true);
+        set_error_(error);
+    }
+    return ok;
+}
+
+sock_t connect_race(const sockaddr_storage* addrs, size_t count,
+        int timeout_ms, int stagger_ms, size_t* index) noexcept {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<pollfd> fds;
+    std::vector<size_t> attempts;   // index of the address of fds[i]
+    size_t next = 0;
+    long long next_start = 0;
+    int error = count > 0 ? CONNECT_TIMEDOUT_ : CONNECT_INVALID_;
+    sock_t winner = INVALID_SOCKET;
+    size_t winner_index = 0;
+    while (winner == INVALID_SOCKET) {
+        long long now = elapsed_ms_(start);
+        if (timeout_ms >= 0 && now >= timeout_ms) {
+            error = CONNECT_TIMEDOUT_;
+            break;
+        }
+        // start the next attempt on its turn or when none is in flight
+        if (next < count && (now >= next_start || fds.empty())) {
+            size_t i = next++;
+            next_start = now + stagger_ms;
+            const sockaddr* addr = reinterpret_cast<const sockaddr*>(
+                &addrs[i]);
+            sock_t sock = create_socket(addr->sa_family, SOCK_STREAM);
+            if (sock == INVALID_SOCKET || !set_blocking(sock, false)) {
+                error = ERR_CODE;
+                if (sock != INVALID_SOCKET) close_socket(sock);
+                next_start = now;
+                continue;
+            }
+            if (connect_to(sock, addr, sockaddr_length(addr))) {
+                winner = sock;
+                winner_index = i;
+            } else if (in_progress_(ERR_CODE)) {
+                fds.push_back(pollfd{});
+                fds.back().fd = sock;
+                fds.back().events = POLLOUT;
+                attempts.push_back(i);
+            } else {
+                // refused at once, try the next address without waiting
+                error = ERR_CODE;
+                close_socket(sock);
+                next_start = now;
+            }
+            continue;
+        }
+        // every address failed
+        if (fds.empty()) break;
+        // wait for an attempt to finish, the next start or the deadline
+        long long wait = next < count ? next_start - now : -1;
+        if (timeout_ms >= 0 && (wait < 0 || timeout_ms - now < wait))
+            wait = timeout_ms - now;
+        int ret = poll_(fds.data(), fds.size(), static_cast<int>(wait));
+        if (ret < 0) {
+#ifdef NANO_LINUX
+            if (errno == EINTR) continue;
+#endif
+            error = ERR_CODE;
+            break;
+        }
+        for (size_t i = 0; i < fds.size();) {
+            if (fds[i].revents == 0) {
+                ++i;
+                continue;
+            }
+            int result = socket_error_(fds[i].fd);
+            if (result == 0 && winner == INVALID_SOCKET) {
+                winner = fds[i].fd;
+                winner_index = attempts[i];
+            } else {
+                if (result != 0) error = result;
+                close_socket(fds[i].fd);
+                // a failure starts the next attempt at once
+                next_start = now;
+            }
+            fds.erase(fds.begin() + i);
+            attempts.erase(attempts.begin() + i);
+        }
+    }
+    // the losers
+    for (pollfd& fd : fds) close_socket(fd.fd);
+    if (winner == INVALID_SOCKET) {
+        set_error_(error);
+        return INVALID_SOCKET;
     }
+    set_blocking(winner, true);
+    if (index) *index = winner_index;
+    return winner;
+}
+
+int recv_msg(sock_t socket, char* buf, size_t buf_size, int flags) {
+    IoResult ret = try_recv_msg(socket, buf, buf_size, flags);
+    return ret.ok() ? ret.bytes : -ret.error;
 }
 
 int recv_msg_from(sock_t socket, char* buf, size_t buf_size,
         addr_t* addr, port_t* port, int flags) {
+    IoResult ret = try_recv_msg_from(socket, buf, buf_size,
+        addr, port, flags);
+    return ret.ok() ? ret.bytes : -ret.error;
+}
+
+int send_msg(sock_t socket, const char* msg, size_t length, int flags) {
+    IoResult ret = try_send_msg(socket, msg, length, flags);
+    assert_throw_nanoexcept(ret.ok(), SysError(ret.error));
+    return ret.bytes;
+}
+
+int send_msg_to(sock_t socket, const char* msg, size_t length,
+        addr_t addr, port_t port, int flags) {
+    IoResult ret = try_send_msg_to(socket, msg, length, addr, port, flags);
+    assert_throw_nanoexcept(ret.ok(), SysError(ret.error));
+    return ret.bytes;
+}
+
+IoResult try_recv_msg(sock_t socket, char* buf, size_t buf_size,
+        int flags) noexcept {
+    int len = static_cast<int>(::recv(socket, buf, buf_size, flags));
+    if (len < 0) return IoResult{0, ERR_CODE};
+    // truncate buffer
+    if (static_cast<size_t>(len) < buf_size) buf[len] = 0;
+    return IoResult{len, 0};
+}
+
+IoResult try_recv_msg_from(sock_t socket, char* buf, size_t buf_size,
+        addr_t* addr, port_t* port, int flags) noexcept {
     sockaddr_in remote;
     socklen_t socklen = sizeof(remote);
     int len = static_cast<int>(::recvfrom(socket, buf, buf_size,
         flags, reinterpret_cast<sockaddr*>(&remote), &socklen));
-    if (len >= 0) {
-        // truncate buffer
-        if (len < buf_size) buf[len] = 0;
-        if (addr) *addr = remote.sin_addr.s_addr;
-        if (port) *port = remote.sin_port;
-        return len;
-    } else {
-        return -ERR_CODE;
-    }
+    if (len < 0) return IoResult{0, ERR_CODE};
+    // truncate buffer
+    if (static_cast<size_t>(len) < buf_size) buf[len] = 0;
+    if (addr) *addr = remote.sin_addr.s_addr;
+    if (port) *port = remote.sin_port;
+    return IoResult{len, 0};
 }
 
-int send_msg(sock_t socket, const char* msg, size_t length, int flags) {
+IoResult try_recv_msg_from(sock_t socket, char* buf, size_t buf_size,
+        sockaddr_storage* addr, int flags) noexcept {
+    sockaddr_storage remote;
+    socklen_t socklen = sizeof(remote);
+    int len = static_cast<int>(::recvfrom(socket, buf, buf_size, flags,
+        reinterpret_cast<sockaddr*>(addr ? addr : &remote), &socklen));
+    if (len < 0) return IoResult{0, ERR_CODE};
+    // truncate buffer
+    if (static_cast<size_t>(len) < buf_size) buf[len] = 0;
+    return IoResult{len, 0};
+}
+
+IoResult try_send_msg(sock_t socket, const char* msg, size_t length,
+        int flags) noexcept {
     int len = static_cast<int>(::send(socket, msg, length, flags));
-    assert_throw_nanoexcept(len >= 0, LAST_ERROR);
-    return len;
+    if (len < 0) return IoResult{0, ERR_CODE};
+    return IoResult{len, 0};
 }
 
-int send_msg_to(sock_t socket, const char* msg, size_t length,
-        addr_t addr, port_t port, int flags) {
+IoResult try_send_msg_to(sock_t socket, const char* msg, size_t length,
+        addr_t addr, port_t port, int flags) noexcept {
     sockaddr_in remote;
-    remote.sin_family = AF_INET;
-    remote.sin_addr.s_addr = addr;
-    remote.sin_port = port;
-    int ret = static_cast<int>(sendto(socket, msg, length, flags,
+    make_sockaddr4(&remote, addr, port);
+    int len = static_cast<int>(::sendto(socket, msg, length, flags,
         reinterpret_cast<const sockaddr*>(&remote), sizeof(remote)));
+    if (len < 0) return IoResult{0, ERR_CODE};
+    return IoResult{len, 0};
+}
+
+IoResult try_send_msg_to(sock_t socket, const char* msg, size_t length,
+        const sockaddr* addr, socklen_t len, int flags) noexcept {
+    int ret = static_cast<int>(::sendto(socket, msg, length, flags,
+        addr, len));
+    if (ret < 0) return IoResult{0, ERR_CODE};
+    return IoResult{ret, 0};
+}
+
+IoResult try_recv_raw(sock_t socket, char* buf, size_t buf_size,
+        int flags) noexcept {
+    int len = static_cast<int>(::recv(socket, buf, buf_size, flags));
+    if (len < 0) return IoResult{0, ERR_CODE};
+    return IoResult{len, 0};
+}
+
+size_t send_msg_all(sock_t socket, const char* msg, size_t length) {
+    size_t sent = 0;
+    while (sent < length) {
+        IoResult ret = try_send_msg(socket, msg + sent, length - sent);
+        if (ret.ok()) {
+            sent += static_cast<size_t>(ret.bytes);
+        } else if (ret.would_block()) {
+            pollfd pfd = {socket, POLLOUT, 0};
+            assert_throw_nanoexcept(poll_(&pfd, 1, -1) >= 0
+                || ERR_CODE == EINTR, LAST_ERROR);
+        } else {
+            assert_throw_nanoexcept(ret.error == EINTR, SysError(ret.error));
+        }
+    }
+    return sent;
+}
+
+int recv_msg_all(sock_t socket, char* buf, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        // a signal or a full socket buffer may still cut it short
+        IoResult ret = try_recv_raw(socket, buf + done, length - done,
+            MSG_WAITALL);
+        if (ret.ok()) {
+            if (ret.bytes == 0) break;
+            done += static_cast<size_t>(ret.bytes);
+        } else if (ret.error != EINTR) {
+            if (done > 0 && ret.would_block()) break;
+            return -ret.error;
+        }
+    }
+    return static_cast<int>(done);
+}
+
+#ifdef NANO_LINUX
+
+int send_msg_to_gso(sock_t socket, const char* msg, size_t length,
+        const sockaddr* addr, socklen_t len, size_t segment_size,
+        int flags) {
+    iovec iov = {const_cast<char*>(msg), length};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+    msghdr hdr = {const_cast<sockaddr*>(addr), len, &iov, 1,
+        control, sizeof(control), 0};
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    uint16_t gso_size = static_cast<uint16_t>(segment_size);
+    std::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+    int ret = static_cast<int>(::sendmsg(socket, &hdr, flags));
     assert_throw_nanoexcept(ret >= 0, LAST_ERROR);
     return ret;
 }
 
+int recv_msg_from_gro(sock_t socket, char* buf, size_t buf_size,
+        sockaddr_storage* addr, size_t* segment_size, int flags) {
+    sockaddr_storage remote;
+    iovec iov = {buf, buf_size};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr hdr = {addr ? addr : &remote, sizeof(remote), &iov, 1,
+        control, sizeof(control), 0};
+    int len = static_cast<int>(::recvmsg(socket, &hdr, flags));
+    if (len < 0) return -ERR_CODE;
+    if (segment_size) {
+        // not coalesced, a single datagram
+        *segment_size = static_cast<size_t>(len);
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg;
+                cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                int gso_size = 0;
+                std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+                *segment_size = static_cast<size_t>(gso_size);
+            }
+        }
+    }
+    return len;
+}
+
+int recv_zerocopy_notice(sock_t socket, uint32_t* first, uint32_t* last,
+        bool* copied) {
+    for (;;) {
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err)
+            + sizeof(sockaddr_in6))] = {};
+        msghdr hdr {};
+        hdr.msg_control = control;
+        hdr.msg_controllen = sizeof(control);
+        if (::recvmsg(socket, &hdr, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            return -ERR_CODE;
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg;
+                cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+            if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+                    || (cmsg->cmsg_level == SOL_IPV6
+                    && cmsg->cmsg_type == IPV6_RECVERR)))
+                continue;
+            sock_extended_err err;
+            std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+            if (err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0)
+                continue;
+            if (first) *first = err.ee_info;
+            if (last) *last = err.ee_data;
+            if (copied) *copied = (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED);
+            return 0;
+        }
+        // not a zero-copy notification, skip it
+    }
+}
+
+size_t send_msg_iov(sock_t socket, const iovec* iov, size_t count,
+        int flags) {
+    size_t sent = 0;
+    // the caller's buffers are copied only after a partial write
+    std::vector<iovec> rest;
+    while (count > 0) {
+        msghdr hdr {};
+        hdr.msg_iov = const_cast<iovec*>(iov);
+        hdr.msg_iovlen = std::min<size_t>(count, IOV_MAX);
+        ssize_t ret = ::sendmsg(socket, &hdr, flags);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) break;
+            throw_except(LAST_ERROR);
+        }
+        sent += static_cast<size_t>(ret);
+        // skip the buffers sent in full
+        size_t left = static_cast<size_t>(ret);
+        while (count > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (left > 0) {
+            if (rest.empty()) {
+                rest.assign(iov, iov + count);
+                iov = rest.data();
+            }
+            iovec& first = rest[iov - rest.data()];
+            first.iov_base = static_cast<char*>(first.iov_base) + left;
+            first.iov_len -= left;
+        }
+    }
+    return sent;
+}
+
+ssize_t recv_msg_iov(sock_t socket, iovec* iov, size_t count, int flags) {
+    msghdr hdr {};
+    hdr.msg_iov = iov;
+    hdr.msg_iovlen = std::min<size_t>(count, IOV_MAX);
+    ssize_t len = ::recvmsg(socket, &hdr, flags);
+    return len < 0 ? -ERR_CODE : len;
+}
+
+bool create_socket_pair(int type, sock_t (&socks)[2]) noexcept {
+    return 0 == ::socketpair(AF_UNIX, type | SOCK_CLOEXEC, 0, socks);
+}
+
+IoResult try_send_fds(sock_t socket, const int* fds, size_t count) noexcept {
+    if (count == 0 || count > FDS_PER_MSG) return IoResult{0, EINVAL};
+    // a stream socket carries ancillary data along with real data only
+    char byte = 0;
+    iovec iov = {&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * FDS_PER_MSG)] = {};
+    msghdr hdr {};
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+    int ret;
+    do ret = static_cast<int>(::sendmsg(socket, &hdr, MSG_NOSIGNAL));
+    while (ret < 0 && errno == EINTR);
+    if (ret < 0) return IoResult{0, ERR_CODE};
+    return IoResult{ret, 0};
+}
+
+IoResult try_recv_fds(sock_t socket, int* fds, size_t* count) noexcept {
+    size_t capacity = std::min(*count, FDS_PER_MSG);
+    *count = 0;
+    char byte = 0;
+    iovec iov = {&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * FDS_PER_MSG)] = {};
+    msghdr hdr {};
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+    int ret;
+    do ret = static_cast<int>(::recvmsg(socket, &hdr, MSG_CMSG_CLOEXEC));
+    while (ret < 0 && errno == EINTR);
+    if (ret < 0) return IoResult{0, ERR_CODE};
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg;
+            cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+        size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < n; ++i) {
+            int fd;
+            std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+            // no room for the extra ones, do not leak them
+            if (*count < capacity) fds[(*count)++] = fd;
+            else ::close(fd);
+        }
+    }
+    return IoResult{ret, 0};
+}
+
+#endif // NANO_LINUX
+
+#ifdef NANO_LINUX
+
+namespace {
+
+// pipe reused by the splice fallback of the calling thread
+struct SplicePipe {
+    int fds[2] = {-1, -1};
+    int error = 0;
+    SplicePipe() {
+        if (::pipe2(fds, O_CLOEXEC) != 0) {
+            error = errno;
+            fds[0] = fds[1] = -1;
+        }
+    }
+    ~SplicePipe() {
+        if (fds[0] != -1) ::close(fds[0]);
+        if (fds[1] != -1) ::close(fds[1]);
+    }
+};
+
+// read and drop the bytes left in the pipe
+inline void discard_pipe(int fd, size_t left) noexcept {
+    char scratch[4096];
+    while (left > 0) {
+        ssize_t ret = ::read(fd, scratch, std::min(left, sizeof(scratch)));
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret <= 0) break;
+        left -= static_cast<size_t>(ret);
+    }
+}
+
+} // anonymous namespace
+
+size_t splice_file(sock_t socket, int fd, off_t offset, size_t count) {
+    static thread_local SplicePipe pipe;
+    assert_throw_nanoexcept(pipe.fds[0] != -1, SysError(pipe.error));
+    size_t sent = 0;
+    while (sent < count) {
+        loff_t off = offset + static_cast<off_t>(sent);
+        ssize_t in = ::splice(fd, &off, pipe.fds[1], nullptr,
+            count - sent, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (in < 0 && errno == EINTR) continue;
+        assert_throw_nanoexcept(in >= 0, LAST_ERROR);
+        if (in == 0) break; // end of file
+        size_t left = static_cast<size_t>(in);
+        while (left > 0) {
+            ssize_t out = ::splice(pipe.fds[0], nullptr, socket, nullptr,
+                left, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (out < 0 && errno == EINTR) continue;
+            if (out < 0 && errno == EAGAIN) {
+                // the file is still there, so the pipe is emptied for the
+                // next call and only the bytes that reached the socket count
+                discard_pipe(pipe.fds[0], left);
+                return sent + (static_cast<size_t>(in) - left);
+            }
+            if (out < 0) {
+                SysError error = LAST_ERROR;
+                discard_pipe(pipe.fds[0], left);
+                throw_except(error);
+            }
+            left -= static_cast<size_t>(out);
+        }
+        sent += static_cast<size_t>(in);
+    }
+    return sent;
+}
+
+#endif // NANO_LINUX
+
+size_t send_file(sock_t socket, int fd, off_t offset, size_t count) {
+#ifdef NANO_LINUX
+    size_t sent = 0;
+    while (sent < count) {
+        off_t off = offset + static_cast<off_t>(sent);
+        ssize_t ret = ::sendfile(socket, fd, &off, count - sent);
+        if (ret > 0) {
+            sent += static_cast<size_t>(ret);
+        } else if (ret == 0) {
+            break; // end of file
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN) {
+            break;
+        } else if (errno == EINVAL || errno == ENOSYS) {
+            // the file cannot be mapped, move it through a pipe
+            return sent + splice_file(socket, fd,
+                offset + static_cast<off_t>(sent), count - sent);
+        } else {
+            throw_except(LAST_ERROR);
+        }
+    }
+    return sent;
+#elif NANO_WINDOWS
+    char buf[16384];
+    size_t sent = 0;
+    assert_throw_nanoexcept(_lseeki64(fd, offset, SEEK_SET) != -1,
+        std::strerror(errno));
+    while (sent < count) {
+        int n = _read(fd, buf, static_cast<unsigned>(
+            std::min(sizeof(buf), count - sent)));
+        assert_throw_nanoexcept(n >= 0, std::strerror(errno));
+        if (n == 0) break;
+        for (int done = 0; done < n;)
+            done += send_msg(socket, buf + done, n - done);
+        sent += static_cast<size_t>(n);
+    }
+    return sent;
+#endif
+}
+
 bool close_socket(sock_t socket) noexcept {
 #ifdef NANO_LINUX
     return 0 == ::close(socket);
@@ -262,6 +826,41 @@ void get_local_address(sock_t socket, addr_t* addr, port_t* port) noexcept {
     if (port) *port = local.sin_port;
 }
 
+void get_remote_address(sock_t socket, addr_t* addr, port_t* port) noexcept {
+    sockaddr_in remote {};
+    socklen_t addr_len = sizeof(remote);
+    if (0 != ::getpeername(socket,
+            reinterpret_cast<sockaddr*>(&remote), &addr_len))
+        return;
+    if (addr) *addr = remote.sin_addr.s_addr;
+    if (port) *port = remote.sin_port;
+}
+
+void get_local_address(sock_t socket, sockaddr_storage* addr) noexcept {
+    socklen_t addr_len = sizeof(*addr);
+    if (0 != ::getsockname(socket, reinterpret_cast<sockaddr*>(addr),
+            &addr_len))
+        addr->ss_family = AF_UNSPEC;
+}
+
+void get_remote_address(sock_t socket, sockaddr_storage* addr) noexcept {
+    socklen_t addr_len = sizeof(*addr);
+    if (0 != ::getpeername(socket, reinterpret_cast<sockaddr*>(addr),
+            &addr_len))
+        addr->ss_family = AF_UNSPEC;
+}
+
+socklen_t sockaddr_length(const sockaddr* addr) noexcept {
+    switch (addr->sa_family) {
+    case AF_INET:
+        return sizeof(sockaddr_in);
+    case AF_INET6:
+        return sizeof(sockaddr_in6);
+    default:
+        return 0;
+    }
+}
+
 // Set non-blocking
 bool set_blocking(sock_t socket, bool blocking) noexcept {
 #ifdef NANO_LINUX
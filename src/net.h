@@ -40,6 +40,8 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <unistd.h>
 #include <fcntl.h>
 
@@ -64,8 +66,11 @@
 #endif
 
 // C++
+#include <cerrno>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 
 // NanoNet
 #include "except.h"
@@ -84,7 +89,7 @@ namespace nano {
 
 enum Domain {
     IPv4 = AF_INET,
-    // IPv6 = AF_INET6, // Not supported yet (NanoNet 2.3)
+    IPv6 = AF_INET6,
 };
 
 enum SockType {
@@ -92,11 +97,48 @@ enum SockType {
     UDP_SOCK = SOCK_DGRAM,
 }; // protocol type
 
-// Convert network byte order and host byte order
-addr_t addr_ntoh(addr_t addr) noexcept;
-addr_t addr_hton(addr_t addr) noexcept;
-port_t port_ntoh(port_t addr) noexcept;
-port_t port_hton(port_t addr) noexcept;
+// Result of a non-throwing I/O call, error is 0 on success
+struct IoResult {
+    int bytes;
+    int error;
+
+    bool ok() const noexcept { return error == 0; }
+    explicit operator bool() const noexcept { return error == 0; }
+
+    // a non-blocking socket is not ready, try again later
+    bool would_block() const noexcept {
+#ifdef NANO_LINUX
+        return error == EAGAIN || error == EWOULDBLOCK;
+#elif NANO_WINDOWS
+        return error == WSAEWOULDBLOCK;
+#endif
+    }
+}; // struct IoResult
+
+// Convert network byte order and host byte order, constexpr so that
+// addresses and ports can be built at compile time
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+
+constexpr addr_t addr_ntoh(addr_t addr) noexcept { return addr; }
+constexpr port_t port_ntoh(port_t port) noexcept { return port; }
+
+#else
+
+constexpr addr_t addr_ntoh(addr_t addr) noexcept {
+    uint32_t val = static_cast<uint32_t>(addr);
+    return static_cast<addr_t>((val >> 24) | ((val >> 8) & 0xFF00)
+        | ((val << 8) & 0xFF0000) | (val << 24));
+}
+
+constexpr port_t port_ntoh(port_t port) noexcept {
+    uint16_t val = static_cast<uint16_t>(port);
+    return static_cast<port_t>((val >> 8) | (val << 8));
+}
+
+#endif
+
+constexpr addr_t addr_hton(addr_t addr) noexcept { return addr_ntoh(addr); }
+constexpr port_t port_hton(port_t port) noexcept { return port_ntoh(port); }
 
 // Converts an ip address to a numeric value and a dotted-decimal string
 addr_t addr_ston(std::string_view str);
@@ -104,6 +146,124 @@ std::string addr_ntos(addr_t addr);
 
 bool is_valid_ipv4(std::string_view addr) noexcept;
 
+// Parse the dotted-decimal IPv4 address at the start of str in one pass
+// without touching DNS, octets have 1-3 digits and no leading zeros, the
+// result is in network byte order, returns the characters used or 0
+constexpr size_t parse_ipv4_prefix(std::string_view str,
+        addr_t& addr) noexcept {
+    uint32_t result = 0;
+    size_t i = 0, size = str.size();
+    for (int part = 0; part < 4; ++part) {
+        if (part > 0) {
+            if (i >= size || str[i] != '.') return 0;
+            ++i;
+        }
+        size_t begin = i;
+        uint32_t value = 0;
+        for (; i < size && i - begin < 3; ++i) {
+            uint32_t digit = static_cast<unsigned char>(str[i]) - '0';
+            if (digit > 9) break;
+            value = value * 10 + digit;
+        }
+        size_t digits = i - begin;
+        if (digits == 0 || value > 255 || (digits > 1 && str[begin] == '0'))
+            return 0;
+        result = (result << 8) | value;
+    }
+    addr = addr_hton(static_cast<addr_t>(result));
+    return i;
+}
+
+// The whole string is an IPv4 address, see parse_ipv4_prefix
+constexpr bool parse_ipv4(std::string_view str, addr_t& addr) noexcept {
+    addr_t value = 0;
+    size_t used = parse_ipv4_prefix(str, value);
+    if (used == 0 || used != str.size()) return false;
+    addr = value;
+    return true;
+}
+
+// Parse a decimal port of 1-5 digits, the result is in network byte order
+constexpr bool parse_port(std::string_view str, port_t& port) noexcept {
+    uint32_t value = 0, valid = 1;
+    size_t count = 0;
+    for (size_t i = 0; i < 5; ++i) {
+        uint32_t digit = i < str.size() ? static_cast<uint32_t>(
+            static_cast<unsigned char>(str[i])) - '0' : 10;
+        valid &= digit < 10;
+        value = valid ? value * 10 + digit : value;
+        count += valid;
+    }
+    if (count == 0 || count != str.size() || value > 65535) return false;
+    port = port_hton(static_cast<port_t>(value));
+    return true;
+}
+
+// Parse an IPv6 address in the text forms of RFC 4291, with :: and a
+// dotted IPv4 tail, into 16 bytes in network byte order
+constexpr bool parse_ipv6(std::string_view str, uint8_t (&bytes)[16]) noexcept {
+    auto hex = [](char c) -> uint32_t {
+        return c >= '0' && c <= '9' ? c - '0'
+            : c >= 'a' && c <= 'f' ? c - 'a' + 10
+            : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+    };
+    uint32_t words[8] = {};
+    int count = 0, gap = -1;
+    size_t i = 0, size = str.size();
+    if (size >= 2 && str[0] == ':' && str[1] == ':') {
+        gap = 0;
+        i = 2;
+    }
+    while (i < size) {
+        if (count == 8) return false;
+        size_t end = i;
+        while (end < size && hex(str[end]) < 16) ++end;
+        if (end < size && str[end] == '.') {
+            // the last 32 bits as dotted IPv4
+            addr_t addr = 0;
+            if (count > 6 || !parse_ipv4(str.substr(i), addr)) return false;
+            uint32_t value = static_cast<uint32_t>(addr_ntoh(addr));
+            words[count++] = value >> 16;
+            words[count++] = value & 0xFFFF;
+            i = size;
+            break;
+        }
+        if (end == i || end - i > 4) return false;
+        uint32_t value = 0;
+        for (; i < end; ++i) value = (value << 4) | hex(str[i]);
+        words[count++] = value;
+        if (i == size) break;
+        if (str[i++] != ':' || i == size) return false;
+        if (str[i] == ':') {
+            if (gap >= 0) return false;
+            gap = count;
+            ++i;
+        }
+    }
+    if (gap < 0 ? count != 8 : count > 7) return false;
+    // expand ::
+    int tail = gap < 0 ? 0 : count - gap;
+    for (int k = 0; k < 8; ++k) {
+        uint32_t word = gap < 0 || k < gap ? words[k]
+            : k >= 8 - tail ? words[k - (8 - count)] : 0;
+        bytes[2 * k] = static_cast<uint8_t>(word >> 8);
+        bytes[2 * k + 1] = static_cast<uint8_t>(word & 0xFF);
+    }
+    return true;
+}
+
+// Parse "a.b.c.d<separator>port" in one pass with the parsers above
+constexpr bool parse_addrport(std::string_view str, addr_t& addr,
+        port_t& port, char separator = ':') noexcept {
+    addr_t addr_value = 0;
+    size_t pos = parse_ipv4_prefix(str, addr_value);
+    if (pos == 0 || pos >= str.size() || str[pos] != separator
+            || !parse_port(str.substr(pos + 1), port))
+        return false;
+    addr = addr_value;
+    return true;
+}
+
 // Query the ip address corresponding to the domain name
 size_t dns_query(std::string_view name, std::vector<addr_t>& results,
     int protocol = SOCK_DGRAM);
@@ -116,15 +276,34 @@ sock_t create_socket(int domain, int type, int protocol = 0) noexcept;
 
 // Bind a address to a socket
 bool bind_address(sock_t socket, addr_t addr, port_t port) noexcept;
+bool bind_address(sock_t socket, const sockaddr* addr, socklen_t len) noexcept;
 
-// Accept a connection on a socket
-sock_t accept_from(sock_t socket, addr_t* addr, port_t* port) noexcept;
+// Accept a connection on a socket, flags are passed to accept4 on Linux
+sock_t accept_from(sock_t socket, addr_t* addr, port_t* port,
+    int flags = 0) noexcept;
+sock_t accept_from(sock_t socket, sockaddr_storage* addr,
+    int flags = 0) noexcept;
 
 // Listen for connections on a socket
 bool enable_listening(sock_t socket, int backlog = 20) noexcept;
 
 // Initiate a connection on a socket
 bool connect_to(sock_t socket, addr_t addr, port_t port) noexcept;
+bool connect_to(sock_t socket, const sockaddr* addr, socklen_t len) noexcept;
+
+// Connect within timeout_ms, or as long as the kernel retries if it is
+// negative, the error is ETIMEDOUT when the deadline passes
+bool connect_to(sock_t socket, addr_t addr, port_t port,
+    int timeout_ms) noexcept;
+bool connect_to(sock_t socket, const sockaddr* addr, socklen_t len,
+    int timeout_ms) noexcept;
+
+// Race TCP connections to the addresses in order, starting the next one
+// every stagger_ms or as soon as one fails, returns the blocking socket of
+// the first to connect and closes the others, or INVALID_SOCKET with the
+// error of the last failure
+sock_t connect_race(const sockaddr_storage* addrs, size_t count,
+    int timeout_ms, int stagger_ms, size_t* index = nullptr) noexcept;
 
 // Receive a message from a socket
 int recv_msg(sock_t socket, char* buf, size_t buf_size, int flags = 0);
@@ -136,6 +315,87 @@ int send_msg(sock_t socket, const char* msg, size_t length, int flags = 0);
 int send_msg_to(sock_t socket, const char* msg, size_t length,
     addr_t addr, port_t port, int flags = 0);
 
+// Receive or send without throwing, the functions above wrap these
+IoResult try_recv_msg(sock_t socket, char* buf, size_t buf_size,
+    int flags = 0) noexcept;
+IoResult try_recv_msg_from(sock_t socket, char* buf, size_t buf_size,
+    addr_t* addr, port_t* port, int flags = 0) noexcept;
+IoResult try_send_msg(sock_t socket, const char* msg, size_t length,
+    int flags = 0) noexcept;
+IoResult try_send_msg_to(sock_t socket, const char* msg, size_t length,
+    addr_t addr, port_t port, int flags = 0) noexcept;
+
+// The same for addresses of either family
+IoResult try_recv_msg_from(sock_t socket, char* buf, size_t buf_size,
+    sockaddr_storage* addr, int flags = 0) noexcept;
+IoResult try_send_msg_to(sock_t socket, const char* msg, size_t length,
+    const sockaddr* addr, socklen_t len, int flags = 0) noexcept;
+
+// Receive without storing a '\0' after the data
+IoResult try_recv_raw(sock_t socket, char* buf, size_t buf_size,
+    int flags = 0) noexcept;
+
+// Send all length bytes, waiting whenever a non-blocking socket would
+// block, returns length
+size_t send_msg_all(sock_t socket, const char* msg, size_t length);
+
+// Receive exactly length bytes with MSG_WAITALL, returns length, fewer if
+// the peer closed or a receive timeout or non-blocking socket stopped it
+// after some bytes, or -ERR_CODE
+int recv_msg_all(sock_t socket, char* buf, size_t length);
+
+#ifdef NANO_LINUX
+
+// Send a message the kernel splits into segment_size datagrams (UDP GSO)
+int send_msg_to_gso(sock_t socket, const char* msg, size_t length,
+    const sockaddr* addr, socklen_t len, size_t segment_size, int flags = 0);
+
+// Receive datagrams the kernel may have coalesced (UDP GRO), segment_size
+// is set to the size of every datagram but the last
+int recv_msg_from_gro(sock_t socket, char* buf, size_t buf_size,
+    sockaddr_storage* addr, size_t* segment_size, int flags = 0);
+
+// Read a MSG_ZEROCOPY completion from the error queue without blocking,
+// sends first..last are done, copied is set if the kernel fell back to
+// copying, returns 0 on success, or -EAGAIN when the queue is empty
+int recv_zerocopy_notice(sock_t socket, uint32_t* first, uint32_t* last,
+    bool* copied);
+
+// Send the buffers in order with sendmsg, partial writes are resumed,
+// returns the bytes sent before the socket would block
+size_t send_msg_iov(sock_t socket, const iovec* iov, size_t count,
+    int flags = 0);
+
+// Receive into the buffers in order with recvmsg
+ssize_t recv_msg_iov(sock_t socket, iovec* iov, size_t count, int flags = 0);
+
+// Create a connected pair of AF_UNIX sockets
+bool create_socket_pair(int type, sock_t (&socks)[2]) noexcept;
+
+// Descriptors passed in one message at most
+constexpr size_t FDS_PER_MSG = 16;
+
+// Pass descriptors over an AF_UNIX socket (SCM_RIGHTS) with one byte of
+// data, the receiver sets count from the capacity to the number received,
+// received descriptors are close-on-exec
+IoResult try_send_fds(sock_t socket, const int* fds, size_t count) noexcept;
+IoResult try_recv_fds(sock_t socket, int* fds, size_t* count) noexcept;
+
+#endif
+
+// Send count bytes of a file from offset without copying them to user
+// space, returns the bytes sent before the socket would block
+size_t send_file(sock_t socket, int fd, off_t offset, size_t count);
+
+#ifdef NANO_LINUX
+
+// The fallback of send_file for files sendfile cannot map, moves the
+// bytes through a pipe of the calling thread, whatever is left in it when
+// the socket would block or fails is dropped
+size_t splice_file(sock_t socket, int fd, off_t offset, size_t count);
+
+#endif
+
 // Close the socket
 bool close_socket(sock_t socket) noexcept;
 
@@ -146,6 +406,16 @@ void make_sockaddr4(sockaddr_in* sockaddr,
 // Gets the address and port bound on the file descriptor
 void get_local_address(sock_t socket, addr_t* addr, port_t* port) noexcept;
 
+// Gets the address and port of the connected peer
+void get_remote_address(sock_t socket, addr_t* addr, port_t* port) noexcept;
+
+// The same for sockets of either family, ss_family is AF_UNSPEC on failure
+void get_local_address(sock_t socket, sockaddr_storage* addr) noexcept;
+void get_remote_address(sock_t socket, sockaddr_storage* addr) noexcept;
+
+// Size of an AF_INET or AF_INET6 address, 0 for other families
+socklen_t sockaddr_length(const sockaddr* addr) noexcept;
+
 // Set non-blocking
 bool set_blocking(sock_t socket, bool blocking) noexcept;
 
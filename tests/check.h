@@ -0,0 +1,68 @@
+// File:     tests/check.h
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef NANONET_TESTS_CHECK_H
+#define NANONET_TESTS_CHECK_H
+
+// C++
+#include <cstdio>
+#include <exception>
+
+namespace check {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+// run one test function, an escaping exception counts as a failure
+template <class Test>
+void run(const char* name, Test test) {
+    int before = failures();
+    try {
+        test();
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s: uncaught exception: %s\n", name, e.what());
+        ++failures();
+    }
+    std::fprintf(stderr, "%s %s\n", failures() == before ? "PASS" : "FAIL",
+        name);
+}
+
+} // namespace check
+
+// record a failure and go on with the test
+#define CHECK(condition)                                              \
+    do {                                                              \
+        if (!(condition)) {                                           \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n",         \
+                __FILE__, __LINE__, #condition);                      \
+            ++check::failures();                                      \
+        }                                                             \
+    } while (0)
+
+#endif // NANONET_TESTS_CHECK_H
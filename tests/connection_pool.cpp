@@ -0,0 +1,128 @@
+// File:     tests/connection_pool.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nanonet.h"
+#include "check.h"
+
+// C++
+#include <chrono>
+#include <utility>
+
+// Linux
+#include <unistd.h>
+
+using namespace nano;
+
+namespace {
+
+using std::chrono::milliseconds;
+
+// a listener, the connections wait in its backlog
+struct Server {
+    ServerSocket listener;
+    Server() : listener(Addr("127.0.0.1"), Port(0)) {
+        listener.listen();
+    }
+    ~Server() {
+        listener.close();
+    }
+    AddrPort local() const { return listener.local(); }
+};
+
+// a lease dropped without release() frees its slot
+void test_dropped_lease_frees_slot() {
+    Server server;
+    ConnectionPool pool(1);
+    {
+        ConnectionPool::Lease lease = pool.acquire(server.local());
+        CHECK(lease);
+        CHECK(pool.active_count(server.local()) == 1);
+    }
+    CHECK(pool.active_count(server.local()) == 0);
+    CHECK(pool.idle_count() == 0);
+    // would time out if the slot had leaked
+    ConnectionPool::Lease lease = pool.acquire(server.local(),
+        milliseconds(1000));
+    CHECK(lease);
+}
+
+// a released connection is reused, and the lease is empty afterwards
+void test_release_reuses() {
+    Server server;
+    ConnectionPool pool(2);
+    ConnectionPool::Lease lease = pool.acquire(server.local());
+    sock_t fd = lease->get();
+    lease.release();
+    CHECK(!lease);
+    CHECK(pool.idle_count() == 1);
+    CHECK(pool.active_count(server.local()) == 0);
+    lease = pool.acquire(server.local());
+    CHECK(lease->get() == fd);
+    CHECK(pool.idle_count() == 0);
+}
+
+// each lease gives back its own slot, whatever its socket is
+void test_lease_releases_own_entry() {
+    Server first;
+    Server second;
+    ConnectionPool pool(2);
+    ConnectionPool::Lease a = pool.acquire(first.local());
+    ConnectionPool::Lease b = pool.acquire(second.local());
+    a.socket().close();
+    a.release();
+    CHECK(pool.active_count(first.local()) == 0);
+    CHECK(pool.active_count(second.local()) == 1);
+    b.release(false);
+    CHECK(pool.active_count(second.local()) == 0);
+    CHECK(pool.idle_count() == 0);
+}
+
+// a moved lease releases once
+void test_move_releases_once() {
+    Server server;
+    ConnectionPool pool(2);
+    ConnectionPool::Lease a = pool.acquire(server.local());
+    ConnectionPool::Lease b = pool.acquire(server.local());
+    a = std::move(b);
+    CHECK(!b);
+    CHECK(pool.active_count(server.local()) == 1);
+    ConnectionPool::Lease c(std::move(a));
+    CHECK(!a);
+    c.release(false);
+    CHECK(pool.active_count(server.local()) == 0);
+}
+
+} // anonymous namespace
+
+int main() {
+    // a leaked slot blocks acquire(), fail instead of hanging
+    ::alarm(30);
+    check::run("dropped_lease_frees_slot", test_dropped_lease_frees_slot);
+    check::run("release_reuses", test_release_reuses);
+    check::run("lease_releases_own_entry", test_lease_releases_own_entry);
+    check::run("move_releases_once", test_move_releases_once);
+    return check::failures() ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+// File:     tests/cork.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nanonet.h"
+#include "check.h"
+
+// C++
+#include <string>
+
+// Linux
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace nano;
+
+namespace {
+
+// a connected pair over loopback
+struct Pair {
+    Socket client;
+    Socket server;
+    Pair() {
+        ServerSocket listener(Addr("127.0.0.1"), Port(0));
+        listener.listen();
+        AddrPort local = listener.local();
+        client.connect(local.addr(), local.port());
+        server = listener.accept();
+        listener.close();
+    }
+    ~Pair() {
+        client.close();
+        server.close();
+    }
+};
+
+// read whatever arrived, without waiting
+std::string drain(Socket& sock) {
+    std::string got;
+    char buf[65536];
+    for (;;) {
+        IoResult ret = sock.try_receive(buf, sizeof(buf));
+        if (!ret.ok() || ret.bytes == 0) break;
+        got.append(buf, static_cast<size_t>(ret.bytes));
+    }
+    return got;
+}
+
+// sends through TransSocket& are queued like direct ones
+void test_order_through_base() {
+    Pair pair;
+    pair.server.set_blocking(false);
+    TransSocket& base = pair.client;
+    pair.client.cork();
+    pair.client.send("one,", 4);
+    base.send("two,", 4);
+    base.send_all("three,", 6);
+    CHECK(base.try_send("four", 4).bytes == 4);
+    CHECK(pair.client.corked() == 18);
+    ::usleep(10000);
+    CHECK(drain(pair.server).empty());
+    pair.client.uncork();
+    CHECK(pair.client.corked() == 0);
+    ::usleep(10000);
+    CHECK(drain(pair.server) == "one,two,three,four");
+}
+
+// a deferred flush the socket cut short finishes once it drains
+void test_deferred_flush_resumes() {
+    Pair pair;
+    EventLoop loop;
+    pair.client.set_option(SOL_SOCKET, SO_SNDBUF, 4096);
+    pair.client.set_blocking(false);
+    pair.server.set_blocking(false);
+    // fill the socket before corking
+    std::string filler(4096, 'f');
+    size_t filled = 0;
+    for (;;) {
+        IoResult ret = pair.client.try_send(filler.data(), filler.size());
+        if (!ret.ok()) break;
+        filled += static_cast<size_t>(ret.bytes);
+    }
+    pair.client.auto_cork(&loop);
+    std::string tail(8000, 't');
+    pair.client.send(tail.data(), tail.size());
+    loop.run_once(0);
+    CHECK(pair.client.corked() > 0);
+
+    std::string got;
+    for (int i = 0; i < 1000 && got.size() < filled + tail.size(); ++i) {
+        got += drain(pair.server);
+        loop.run_once(10);
+    }
+    CHECK(pair.client.corked() == 0);
+    CHECK(got.size() == filled + tail.size());
+    CHECK(got.compare(filled, tail.size(), tail) == 0);
+    pair.client.auto_cork(nullptr);
+}
+
+// the error of a deferred flush is thrown by the next send
+void test_deferred_error_reported() {
+    Pair pair;
+    EventLoop loop;
+    pair.client.set_blocking(false);
+    // reset instead of an orderly close
+    linger hard = {1, 0};
+    pair.server.set_option(SOL_SOCKET, SO_LINGER, hard);
+    pair.server.close();
+    ::usleep(10000);
+    pair.client.auto_cork(&loop);
+    pair.client.send("lost", 4);
+    loop.run_once(0);
+    bool thrown = false;
+    try {
+        pair.client.send("next", 4);
+    } catch (const NanoExcept& e) {
+        thrown = true;
+        // taken when the flush failed, not from errno now
+        CHECK(e.code() == EPIPE || e.code() == ECONNRESET);
+    }
+    CHECK(thrown);
+    // reported once
+    pair.client.auto_cork(nullptr);
+    CHECK(pair.client.corked() == 0);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::signal(SIGPIPE, SIG_IGN);
+    // a hang fails the test instead of the whole run
+    ::alarm(30);
+    check::run("order_through_base", test_order_through_base);
+    check::run("deferred_flush_resumes", test_deferred_flush_resumes);
+    check::run("deferred_error_reported", test_deferred_error_reported);
+    return check::failures() ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+// File:     tests/coroutine.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nanonet.h"
+#include "check.h"
+
+// Linux
+#include <unistd.h>
+
+using namespace nano;
+
+#ifdef NANO_COROUTINE
+
+namespace {
+
+Task<IoResult> receive_once(EventLoop& loop, TransSocket& sock,
+        char* buf, size_t size) {
+    co_return co_await async_receive(loop, sock, buf, size);
+}
+
+Task<Socket> accept_once(EventLoop& loop, ServerSocket& server) {
+    co_return co_await async_accept(loop, server);
+}
+
+Task<void> receive_into(EventLoop& loop, TransSocket& sock,
+        IoResult& ret, bool& done) {
+    char buf[16];
+    ret = co_await async_receive(loop, sock, buf, sizeof(buf));
+    done = true;
+}
+
+// a socket reusing the fd of a closed one is watched from scratch
+void test_fd_reuse() {
+    EventLoop loop;
+    ServerSocket first(Addr("127.0.0.1"), Port(0));
+    first.listen();
+    AddrPort local = first.local();
+    Socket client;
+    client.connect(local.addr(), local.port());
+    Socket conn = sync_wait(loop, accept_once(loop, first));
+    conn.close();
+    client.close();
+
+    sock_t fd = first.get();
+    nano::close(loop, first);
+    CHECK(!loop.contains(fd));
+
+    // the lowest free fd is the one just closed
+    ServerSocket second(Addr("127.0.0.1"), Port(0));
+    second.listen();
+    CHECK(second.get() == fd);
+    local = second.local();
+    client = Socket();
+    client.connect(local.addr(), local.port());
+    conn = sync_wait(loop, accept_once(loop, second));
+    CHECK(conn.is_open());
+    client.send("hello", 5);
+    char buf[16];
+    IoResult ret = sync_wait(loop, receive_once(loop, conn, buf, sizeof(buf)));
+    CHECK(ret.ok() && ret.bytes == 5);
+
+    nano::close(loop, conn);
+    nano::close(loop, second);
+    client.close();
+}
+
+// a coroutine waiting on a socket resumes when it is closed
+void test_close_resumes_waiter() {
+    EventLoop loop;
+    ServerSocket server(Addr("127.0.0.1"), Port(0));
+    server.listen();
+    AddrPort local = server.local();
+    Socket client;
+    client.connect(local.addr(), local.port());
+    Socket conn = sync_wait(loop, accept_once(loop, server));
+
+    IoResult ret{0, 0};
+    bool done = false;
+    spawn(receive_into(loop, conn, ret, done));
+    CHECK(!done);
+    nano::close(loop, conn);
+    CHECK(done);
+    CHECK(!ret.ok() && !ret.would_block());
+
+    nano::close(loop, server);
+    client.close();
+}
+
+} // anonymous namespace
+
+int main() {
+    // a hang fails the test instead of the whole run
+    ::alarm(30);
+    check::run("fd_reuse", test_fd_reuse);
+    check::run("close_resumes_waiter", test_close_resumes_waiter);
+    return check::failures() ? 1 : 0;
+}
+
+#else
+
+int main() {
+    return 0;
+}
+
+#endif // NANO_COROUTINE
@@ -0,0 +1,79 @@
+// File:     tests/io_uring.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nanonet.h"
+#include "check.h"
+
+// C++
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// Linux
+#include <unistd.h>
+
+using namespace nano;
+
+namespace {
+
+// stop() from another thread ends a run() blocked with nothing in flight
+void test_stop_from_other_thread() {
+    IoUring ring;
+    std::thread runner([&ring] { ring.run(); });
+    while (!ring.is_running()) std::this_thread::yield();
+    // let it block in io_uring_enter()
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ring.stop();
+    runner.join();
+    CHECK(!ring.is_running());
+}
+
+// the wakeup is armed again, a second run() can be stopped as well
+void test_stop_twice() {
+    IoUring ring;
+    for (int i = 0; i < 2; ++i) {
+        std::thread runner([&ring] { ring.run(); });
+        while (!ring.is_running()) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ring.stop();
+        runner.join();
+    }
+    CHECK(!ring.is_running());
+}
+
+} // anonymous namespace
+
+int main() {
+    if (!IoUring::available()) {
+        std::fprintf(stderr, "SKIP io_uring is not available\n");
+        return 0;
+    }
+    // a lost wakeup hangs, fail instead
+    ::alarm(30);
+    check::run("stop_from_other_thread", test_stop_from_other_thread);
+    check::run("stop_twice", test_stop_twice);
+    return check::failures() ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+// File:     tests/send_file.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nanonet.h"
+#include "check.h"
+
+// C++
+#include <cerrno>
+#include <csignal>
+#include <string>
+
+// Linux
+#include <unistd.h>
+
+using namespace nano;
+
+namespace {
+
+// a connected pair over loopback
+struct Pair {
+    Socket client;
+    Socket server;
+    Pair() {
+        ServerSocket listener(Addr("127.0.0.1"), Port(0));
+        listener.listen();
+        AddrPort local = listener.local();
+        client.connect(local.addr(), local.port());
+        server = listener.accept();
+        listener.close();
+    }
+    ~Pair() {
+        client.close();
+        server.close();
+    }
+};
+
+// unlinked temporary file holding data
+int temp_file(const std::string& data) {
+    char path[] = "/tmp/nanonet_send_file_XXXXXX";
+    int fd = ::mkstemp(path);
+    if (fd < 0) return -1;
+    ::unlink(path);
+    if (::write(fd, data.data(), data.size())
+            != static_cast<ssize_t>(data.size())) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// data of size bytes that shows where a byte came from
+std::string pattern(size_t size) {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; ++i)
+        data[i] = static_cast<char>('a' + i % 23);
+    return data;
+}
+
+// resume send(fd, offset, count) on the non-blocking client until the
+// server has read everything, returns what it read
+template <class Send>
+std::string drain(Pair& pair, const std::string& data, size_t sent,
+        Send send) {
+    std::string got;
+    std::string buf(64 << 10, '\0');
+    pair.server.set_blocking(false);
+    while (got.size() < data.size()) {
+        if (sent < data.size())
+            sent += send(static_cast<off_t>(sent), data.size() - sent);
+        IoResult ret = pair.server.try_receive(&buf[0], buf.size());
+        if (ret.ok() && ret.bytes == 0) break;
+        if (ret.ok()) got.append(buf.data(), static_cast<size_t>(ret.bytes));
+        else if (!ret.would_block()) break;
+    }
+    CHECK(sent == data.size());
+    return got;
+}
+
+// a non-blocking socket gets what fits and the rest is sent on resume
+void test_non_blocking_returns() {
+    std::string data = pattern(2 << 20);
+    int fd = temp_file(data);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    Pair pair;
+    pair.client.set_option(SOL_SOCKET, SO_SNDBUF, 16 << 10);
+    pair.client.set_blocking(false);
+
+    // nobody reads, a blocking wait would hang here
+    size_t sent = pair.client.send_file(fd, 0, data.size());
+    CHECK(sent < data.size());
+
+    std::string got = drain(pair, data, sent, [&](off_t offset, size_t n) {
+        return pair.client.send_file(fd, offset, n);
+    });
+    CHECK(got == data);
+    ::close(fd);
+}
+
+// the bytes left in the pipe when the socket would block are dropped,
+// resuming from the returned count neither repeats nor skips any
+void test_splice_would_block() {
+    std::string data = pattern(2 << 20);
+    int fd = temp_file(data);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    Pair pair;
+    pair.client.set_option(SOL_SOCKET, SO_SNDBUF, 16 << 10);
+    pair.client.set_blocking(false);
+
+    size_t sent = splice_file(pair.client.get(), fd, 0, data.size());
+    CHECK(sent < data.size());
+
+    std::string got = drain(pair, data, sent, [&](off_t offset, size_t n) {
+        return splice_file(pair.client.get(), fd, offset, n);
+    });
+    CHECK(got == data);
+    ::close(fd);
+}
+
+// a failing socket throws, and the pipe is emptied for the next call
+void test_splice_error() {
+    std::string data = pattern(2 << 20);
+    int fd = temp_file(data);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    {
+        Pair pair;
+        pair.server.close();
+        // the first bytes may still go out before the reset comes back
+        bool threw = false;
+        for (int i = 0; i < 10 && !threw; ++i) {
+            try {
+                splice_file(pair.client.get(), fd, 0, data.size());
+            } catch (const NanoExcept& e) {
+                threw = true;
+                CHECK(e.code() == EPIPE || e.code() == ECONNRESET);
+            }
+        }
+        CHECK(threw);
+    }
+
+    Pair pair;
+    pair.client.set_blocking(false);
+    std::string got = drain(pair, data, 0, [&](off_t offset, size_t n) {
+        return splice_file(pair.client.get(), fd, offset, n);
+    });
+    CHECK(got == data);
+    ::close(fd);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::signal(SIGPIPE, SIG_IGN);
+    // a hang fails the test instead of the whole run
+    ::alarm(30);
+    check::run("non_blocking_returns", test_non_blocking_returns);
+    check::run("splice_would_block", test_splice_would_block);
+    check::run("splice_error", test_splice_error);
+    return check::failures() ? 1 : 0;
+}
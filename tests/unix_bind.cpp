@@ -0,0 +1,112 @@
+// File:     tests/unix_bind.cpp
+// Author:   AkashiNeko
+// Project:  NanoNet
+// Github:   https://github.com/AkashiNeko/NanoNet/
+
+/* Copyright AkashiNeko. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ *
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "nanonet.h"
+#include "check.h"
+
+// C++
+#include <string>
+
+// Linux
+#include <unistd.h>
+
+using namespace nano;
+
+namespace {
+
+// a fresh path in /tmp, nothing bound to it yet
+std::string temp_path(const char* name) {
+    std::string path = "/tmp/nanonet_" + std::to_string(::getpid())
+        + "_" + name + ".sock";
+    ::unlink(path.c_str());
+    return path;
+}
+
+template <class Sock>
+bool bind_throws(Sock& sock, const UnixAddr& addr) {
+    try {
+        sock.bind(addr);
+    } catch (const NanoExcept&) {
+        return true;
+    }
+    return false;
+}
+
+// a second server must not take over the name of a live listener
+void test_live_listener_kept() {
+    std::string path = temp_path("live");
+    UnixServerSocket first(UnixAddr{path});
+    first.listen();
+    UnixServerSocket second;
+    CHECK(bind_throws(second, UnixAddr{path}));
+    second.close();
+
+    // the first one is still reachable
+    UnixSocket client;
+    client.connect(UnixAddr{path});
+    UnixSocket conn = first.accept();
+    CHECK(conn.is_open());
+    conn.close();
+    client.close();
+    first.close();
+    ::unlink(path.c_str());
+}
+
+// the file of a closed listener is removed and bound again
+void test_stale_file_replaced() {
+    std::string path = temp_path("stale");
+    UnixServerSocket first(UnixAddr{path});
+    first.listen();
+    first.close();
+    UnixServerSocket second;
+    CHECK(!bind_throws(second, UnixAddr{path}));
+    second.listen();
+    UnixSocket client;
+    client.connect(UnixAddr{path});
+    client.close();
+    second.close();
+    ::unlink(path.c_str());
+}
+
+// a bound datagram socket answers the probe too
+void test_live_datagram_kept() {
+    std::string path = temp_path("dgram");
+    UnixDgramSocket first(UnixAddr{path});
+    UnixDgramSocket second;
+    CHECK(bind_throws(second, UnixAddr{path}));
+    second.close();
+    first.close();
+    ::unlink(path.c_str());
+}
+
+} // anonymous namespace
+
+int main() {
+    check::run("live_listener_kept", test_live_listener_kept);
+    check::run("stale_file_replaced", test_stale_file_replaced);
+    check::run("live_datagram_kept", test_live_datagram_kept);
+    return check::failures() ? 1 : 0;
+}